@@ -0,0 +1,43 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// alocador por "bump": a memória é pedida em blocos grandes e cada
+// alocação só avança um ponteiro. nada é liberado individualmente; a
+// compilação inteira (nós da AST, símbolos, escopos e strings) some de uma
+// vez com arena_reset ou arena_destroy.
+typedef struct ArenaBlock ArenaBlock;
+
+typedef struct {
+    ArenaBlock* head;   // bloco atual (os anteriores ficam encadeados)
+    char* cursor;
+    char* limit;
+} Arena;
+
+// cria uma arena vazia
+Arena* arena_create(void);
+
+// reserva size bytes alinhados (o conteúdo não é zerado)
+void* arena_alloc(Arena* arena, size_t size);
+
+// reserva size bytes zerados
+void* arena_calloc(Arena* arena, size_t size);
+
+// copia uma string para dentro da arena
+char* arena_strdup(Arena* arena, const char* s);
+
+// copia length bytes de s e termina com '\0'
+char* arena_strndup(Arena* arena, const char* s, size_t length);
+
+// passa todos os blocos de from para into e libera from. o que foi alocado
+// em from continua válido e passa a viver (e morrer) junto com into.
+void arena_merge(Arena* into, Arena* from);
+
+// descarta tudo que foi alocado, mantendo o primeiro bloco para reuso
+void arena_reset(Arena* arena);
+
+// libera a arena e todos os seus blocos
+void arena_destroy(Arena* arena);
+
+#endif // ARENA_H
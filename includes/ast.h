@@ -1,7 +1,11 @@
 #ifndef AST_H
 #define AST_H
 
+#include <stdint.h>
+#include "intern.h"
+
 struct SymbolTable;
+struct SymbolNode;
 
 typedef enum {
     // estruturais
@@ -49,17 +53,59 @@ typedef enum {
     NODE_TYPE_FLOAT
 } NodeType;
 
-typedef struct ASTNode {
-    NodeType type;
-    char* value;
-    struct ASTNode* child;
-    struct ASTNode* sibling;
-    struct SymbolTable* scope; 
-} ASTNode;
-
-ASTNode* create_node(NodeType type, const char* value);
-void add_child(ASTNode* parent, ASTNode* new_child);
-void free_ast(ASTNode* root);
-void print_ast(ASTNode* node, int level);
+// índice de um nó na AST. 0 (AST_NONE) é "nenhum nó", então dá para
+// testar filhos e irmãos como se fossem ponteiros.
+typedef uint32_t AstId;
+
+#define AST_NONE 0
+
+// tipo de expressão ainda não calculado (ver expr_type)
+#define AST_TYPE_UNKNOWN 0xFF
+
+// AST plana: os campos de todos os nós ficam em vetores separados
+// (estrutura de vetores), indexados pelo AstId. percorrer só os tipos ou
+// só os filhos lê memória contígua, e acrescentar um filho é O(1) porque
+// o último filho de cada nó é guardado.
+typedef struct Ast {
+    uint8_t* type;              // NodeType
+    NameId* value;              // texto internado (NAME_NONE = sem valor)
+    AstId* child;               // primeiro filho
+    AstId* sibling;             // próximo irmão
+    AstId* last_child;          // último filho
+    struct SymbolTable** scope; // escopo das declarações de função
+    struct SymbolNode** symbol; // símbolo resolvido pelo parser (variáveis,
+                                // parâmetros, atribuições, chamadas e funções)
+    uint8_t* data_type;         // SymbolDataType da expressão, guardado por
+                                // expr_type na primeira consulta
+    int count;                  // nós usados (o 0 é reservado)
+    int capacity;
+
+    AstId root;                 // NODE_PROGRAM, preenchido pelo parser
+} Ast;
+
+Ast* ast_create(void);
+void ast_free(Ast* ast);
+
+// cria um nó sem filhos; value é um nome internado ou NAME_NONE
+AstId create_node(Ast* ast, NodeType type, NameId value);
+
+// acrescenta new_child como último filho de parent, em O(1)
+void add_child(Ast* ast, AstId parent, AstId new_child);
+
+// copia para into a subárvore de from com raiz em root (que não pode ter
+// irmãos) e devolve o novo índice da raiz
+AstId ast_merge(Ast* into, const Ast* from, AstId root);
+
+void print_ast(const Ast* ast, AstId node, int level);
+
+static inline NodeType ast_type(const Ast* ast, AstId node) { return (NodeType)ast->type[node]; }
+static inline NameId ast_name(const Ast* ast, AstId node) { return ast->value[node]; }
+static inline const char* ast_value(const Ast* ast, AstId node) { return intern_name(ast->value[node]); }
+static inline AstId ast_child(const Ast* ast, AstId node) { return ast->child[node]; }
+static inline AstId ast_sibling(const Ast* ast, AstId node) { return ast->sibling[node]; }
+static inline struct SymbolTable* ast_scope(const Ast* ast, AstId node) { return ast->scope[node]; }
+static inline void ast_set_scope(Ast* ast, AstId node, struct SymbolTable* scope) { ast->scope[node] = scope; }
+static inline struct SymbolNode* ast_symbol(const Ast* ast, AstId node) { return ast->symbol[node]; }
+static inline void ast_set_symbol(Ast* ast, AstId node, struct SymbolNode* symbol) { ast->symbol[node] = symbol; }
 
 #endif // AST_H
@@ -0,0 +1,94 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <stdint.h>
+#include "ast.h"
+#include "symtab.h"
+
+//
+// bytecode baseado em registradores. cada função tem um quadro de
+// registradores: as variáveis ficam no registrador igual ao seu endereço
+// (SymbolNode.address), depois vêm as constantes da função e por fim os
+// temporários das expressões.
+//
+// os operandos são sempre registradores, então `i = i + 1` vira uma única
+// instrução ADDI, sem o empilha/desempilha de uma máquina de pilha.
+//
+#define BYTECODE_OPS(X) \
+    X(MOVE)    /* R[a] = R[b] */ \
+    X(I2F)     /* R[a].f = (double)R[b].i */ \
+    X(F2I)     /* R[a].i = (long long)R[b].f */ \
+    X(ADDI) X(SUBI) X(MULI) X(DIVI)   /* R[a] = R[b] op R[c] (inteiros) */ \
+    X(ADDF) X(SUBF) X(MULF) X(DIVF)   /* R[a] = R[b] op R[c] (floats) */ \
+    X(NEGI) X(NEGF)                   /* R[a] = -R[b] */ \
+    X(EQI) X(NEI) X(LTI) X(LEI)       /* R[a].i = R[b] cmp R[c] */ \
+    X(EQF) X(NEF) X(LTF) X(LEF) \
+    X(JMP)     /* pc = c */ \
+    X(JMPF)    /* se R[a].i == 0, pc = c */ \
+    X(JMPT)    /* se R[a].i != 0, pc = c */ \
+    X(JMPFF)   /* se R[a].f == 0, pc = c */ \
+    X(JMPTF)   /* se R[a].f != 0, pc = c */ \
+    X(JEQI) X(JNEI) X(JLTI) X(JLEI)   /* se R[a] cmp R[b], pc = c */ \
+    X(JEQF) X(JNEF) X(JLTF) X(JLEF) \
+    X(JNLTF) X(JNLEF)                 /* se !(R[a] cmp R[b]), pc = c (NaN) */ \
+    X(CALL)    /* R[a] = funções[b](R[c], R[c+1], ...) */ \
+    X(RET)     /* retorna R[a] */ \
+    X(RETZ)    /* retorna 0 */ \
+    X(PRINTI)  /* imprime R[a].i; b != 0 termina a linha */ \
+    X(PRINTF)  /* imprime R[a].f; b != 0 termina a linha */ \
+    X(PRINTNL) /* imprime uma quebra de linha */ \
+    X(SCANI)   /* lê um inteiro para R[a] */ \
+    X(SCANF)   /* lê um float para R[a] */
+
+typedef enum {
+#define BYTECODE_ENUM(name) OP_##name,
+    BYTECODE_OPS(BYTECODE_ENUM)
+#undef BYTECODE_ENUM
+    OP_COUNT
+} OpCode;
+
+// instrução de 8 bytes: opcode e três operandos de 16 bits
+typedef struct {
+    uint16_t op;
+    uint16_t a;
+    uint16_t b;
+    uint16_t c;
+} Instruction;
+
+// conteúdo de um registrador. o tipo é conhecido em tempo de compilação.
+typedef union {
+    long long i;
+    double f;
+} Value;
+
+typedef struct {
+    char* name;
+    SymbolDataType return_type;
+    int param_count;        // parâmetros ficam em R[1..param_count]
+    SymbolDataType* param_types;
+
+    Instruction* code;
+    int code_count;
+    int code_capacity;
+
+    Value* constants;       // copiadas para R[local_count..] a cada chamada
+    int constant_count;
+    int local_count;        // registradores das variáveis (endereços)
+    int register_count;     // tamanho total do quadro
+} BytecodeFunction;
+
+typedef struct {
+    BytecodeFunction* functions;
+    int function_count;
+    int entry;              // função executada primeiro
+} BytecodeProgram;
+
+// traduz a AST para bytecode. global_scope é o escopo usado pelo parser,
+// onde estão as funções e as variáveis do bloco principal.
+BytecodeProgram* bytecode_compile(const Ast* ast, SymbolTable* global_scope);
+
+void bytecode_free(BytecodeProgram* program);
+
+const char* opcode_to_string(OpCode op);
+
+#endif // BYTECODE_H
@@ -0,0 +1,17 @@
+#ifndef CODEGEN_H
+#define CODEGEN_H
+
+#include <stdio.h>
+#include "ast.h"
+#include "symtab.h"
+
+// gera assembly x86-64 (sintaxe AT&T, System V) para o programa inteiro.
+// o arquivo gerado já traz as rotinas de print/scan e a função `main`,
+// então basta `gcc programa.s -o programa`.
+void codegen_emit_asm(const Ast* ast, SymbolTable* global_scope, FILE* out);
+
+// traduz o programa para C portável: uma função C por função da linguagem,
+// pronta para ser otimizada por `gcc -O2`
+void codegen_emit_c(const Ast* ast, SymbolTable* global_scope, FILE* out);
+
+#endif // CODEGEN_H
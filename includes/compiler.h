@@ -0,0 +1,41 @@
+#ifndef COMPILER_H
+#define COMPILER_H
+
+#include <stddef.h>
+#include "diagnostic.h"
+
+// biblioteca do compilador: analisa um texto já na memória e devolve o
+// código gerado ou a mensagem de erro, sem terminar o processo. serve para
+// embutir o compilador em outro programa ou reaproveitar o mesmo processo
+// em muitas compilações (veja o modo --server).
+
+// o que gerar a partir do programa analisado
+typedef enum {
+    COMPILE_CHECK,      // só análise léxica, sintática e semântica
+    COMPILE_EMIT_ASM,   // assembly x86-64
+    COMPILE_EMIT_C      // C portável
+} CompileTarget;
+
+typedef struct {
+    CompileTarget target;
+    int max_depth;      // limite de aninhamento (0 = PARSER_DEFAULT_MAX_DEPTH)
+    int no_optimize;    // não passa a AST por optimize_ast (-O0)
+} CompileOptions;
+
+typedef struct {
+    int ok;                                 // 1 se compilou
+    char* output;                           // código gerado (malloc), ou NULL
+    size_t output_length;
+    char error[DIAGNOSTIC_MESSAGE_SIZE];    // mensagem do erro, se !ok
+} CompileResult;
+
+// compila os length bytes de text. o texto não precisa terminar em '\0'.
+// devolve result->ok; em caso de erro tudo o que a compilação alocou já
+// foi liberado. options NULL usa COMPILE_CHECK com o limite padrão.
+// pode ser chamada por várias threads ao mesmo tempo.
+int compile_source(const char* text, size_t length, const CompileOptions* options, CompileResult* result);
+
+// libera o código gerado guardado em result
+void compile_result_free(CompileResult* result);
+
+#endif // COMPILER_H
@@ -0,0 +1,54 @@
+#ifndef CONSTANT_H
+#define CONSTANT_H
+
+#include <stdio.h>
+#include "ast.h"
+#include "symtab.h"
+
+// valor conhecido em tempo de compilação, com as mesmas regras da execução:
+// inteiros de 64 bits em complemento de dois, floats em double, operações
+// mistas em float e comparações dando inteiro 0 ou 1
+typedef struct {
+    SymbolDataType type;    // TYPE_INTEGER ou TYPE_FLOAT
+    union {
+        long long i;
+        double f;
+    };
+} Constant;
+
+// valor de um NODE_INT_LITERAL ou NODE_FLOAT_LITERAL
+Constant constant_of_literal(const Ast* ast, AstId node);
+
+// calcula a op b (aritmética ou comparação). devolve 0 quando o resultado
+// só sai na execução: divisão inteira por zero ou float não finito.
+int constant_binary(NodeType op, Constant a, Constant b, Constant* out);
+
+int constant_negate(Constant a, Constant* out);
+
+// conversão na atribuição a uma variável de outro tipo. float fora da
+// faixa dos inteiros não é convertido (na execução o resultado depende da
+// máquina).
+int constant_convert(Constant a, SymbolDataType type, Constant* out);
+
+// valor de verdade numa condição (diferente de zero)
+int constant_truth(Constant c);
+
+// os dois são o mesmo valor (o mesmo tipo e os mesmos bits)
+int constant_equal(Constant a, Constant b);
+
+// o valor tem literal que todos os backends leem de volta igual (não é o
+// menor inteiro nem um float infinito ou NaN)
+int constant_has_literal(Constant c);
+
+// cria o literal do valor, ou devolve AST_NONE se o valor não tiver texto
+// que todos os backends leiam de volta igual (o menor inteiro)
+AstId constant_node(Ast* ast, Constant c);
+
+// transforma o nó folha em literal do valor, no lugar. devolve 0 (sem
+// mexer no nó) nos casos em que constant_node devolveria AST_NONE.
+int constant_replace_node(Ast* ast, AstId node, Constant c);
+
+// escreve o valor como literal (floats sempre com ponto ou expoente)
+void constant_print(FILE* out, Constant c);
+
+#endif // CONSTANT_H
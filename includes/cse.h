@@ -0,0 +1,21 @@
+#ifndef CSE_H
+#define CSE_H
+
+#include "ast.h"
+#include "symtab.h"
+
+// eliminação de subexpressões comuns dentro de cada bloco básico (um
+// trecho de instruções sem if nem while no meio). as expressões puras
+// (contas e comparações sobre variáveis e literais, sem chamadas nem
+// divisões inteiras que possam falhar) são numeradas por hash-consing: a
+// chave é o tipo do nó e o número de cada operando, e a mesma chave dá o
+// mesmo número. uma atribuição a x mata as expressões que usam x (x passa
+// a ter outra versão, então a chave muda).
+//
+// a segunda vez que uma expressão aparece vira a leitura de uma variável
+// que já tem o valor: a que recebeu a expressão inteira numa atribuição,
+// se ela não mudou desde então, ou uma temporária nova (_cse1, _cse2, ...)
+// calculada uma vez antes da instrução da primeira ocorrência.
+void cse_optimize_ast(Ast* ast, SymbolTable* global_scope);
+
+#endif // CSE_H
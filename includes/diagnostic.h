@@ -0,0 +1,33 @@
+#ifndef DIAGNOSTIC_H
+#define DIAGNOSTIC_H
+
+#include <setjmp.h>
+
+#define DIAGNOSTIC_MESSAGE_SIZE 512
+
+// ponto de retorno para os erros de compilação. enquanto houver uma
+// armadilha armada na thread, compile_error guarda a mensagem nela e volta
+// com longjmp para o setjmp de quem armou; sem armadilha, a mensagem vai
+// para stderr e o processo termina, como no compilador de linha de comando.
+typedef struct ErrorTrap {
+    jmp_buf jump;
+    char message[DIAGNOSTIC_MESSAGE_SIZE];
+    struct ErrorTrap* previous;
+} ErrorTrap;
+
+// arma a armadilha na thread atual. o uso é
+//     error_trap_push(&trap);
+//     if (setjmp(trap.jump)) { ...libera tudo...; error_trap_pop(&trap); }
+void error_trap_push(ErrorTrap* trap);
+
+// desarma a armadilha (precisa ser a última armada)
+void error_trap_pop(ErrorTrap* trap);
+
+// há uma armadilha armada nesta thread. os erros das threads do pool não
+// voltam para ela, então os caminhos paralelos ficam desligados nesse caso.
+int error_trap_active(void);
+
+// erro de compilação com mensagem no formato do printf (sem o '\n' final)
+void compile_error(const char* format, ...) __attribute__((noreturn, format(printf, 1, 2)));
+
+#endif // DIAGNOSTIC_H
@@ -0,0 +1,23 @@
+#ifndef DRIVER_H
+#define DRIVER_H
+
+#include "compiler.h"
+
+// compila vários programas de uma vez. cada caminho pode ser um arquivo ou
+// um diretório, percorrido recursivamente atrás de arquivos .lang. cada
+// arquivo vira uma tarefa no pool compartilhado, com seu próprio lexer,
+// parser, tabelas de símbolos e AST (via compile_source); os maiores são
+// enviados primeiro. a saída de cada um vai para o arquivo com a extensão
+// trocada, e os erros são impressos no fim, na ordem dos arquivos, então a
+// saída não depende de quantas threads foram usadas. devolve o código de
+// saída (EXIT_FAILURE se algum arquivo falhou).
+int driver_compile_files(char* const* paths, int count, const CompileOptions* options);
+
+// troca a extensão .lang do arquivo de entrada pela extensão pedida
+// (o resultado é alocado com malloc)
+char* default_output_path(const char* input, const char* extension);
+
+// é um diretório (para decidir entre um arquivo só e vários)
+int is_directory(const char* path);
+
+#endif // DRIVER_H
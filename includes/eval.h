@@ -0,0 +1,13 @@
+#ifndef EVAL_H
+#define EVAL_H
+
+#include "ast.h"
+#include "symtab.h"
+
+// interpretador por closures: cada nó da AST é convertido uma única vez
+// numa função C especializada (por exemplo "variável inteira + constante"),
+// com operandos já resolvidos, e depois só essas funções são chamadas.
+// funciona em qualquer arquitetura. devolve o valor retornado pela entrada.
+int eval_run(const Ast* ast, SymbolTable* global_scope);
+
+#endif // EVAL_H
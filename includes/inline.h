@@ -0,0 +1,30 @@
+#ifndef INLINE_H
+#define INLINE_H
+
+#include <stdio.h>
+#include "ast.h"
+#include "symtab.h"
+
+// expansão de funções pequenas no lugar das chamadas. o corpo precisa ter
+// até INLINE_MAX_NODES nós, e o programa inteiro pode ganhar no máximo o
+// seu próprio tamanho (com um mínimo de INLINE_MIN_BUDGET nós).
+//
+// - um corpo que é só return e, com argumentos simples (literais,
+//   variáveis, ou contas puras usadas uma vez), vira e no lugar da
+//   chamada, com os parâmetros trocados pelos argumentos.
+// - uma chamada que é a instrução inteira (f(...);, x = f(...),
+//   int x = f(...) ou return f(...)) vira as instruções do corpo, se o
+//   único return for o último. os parâmetros e as variáveis da função
+//   viram variáveis novas do chamador (_f_a1, ...), então nada colide com
+//   os nomes dele.
+//
+// as funções são visitadas na ordem do programa e só chamam as de antes,
+// então o corpo copiado já vem expandido. chamadas recursivas ficam.
+// com stats diferente de NULL, o orçamento e a decisão de cada chamada
+// são escritos nele.
+#define INLINE_MAX_NODES 40
+#define INLINE_MIN_BUDGET 2000
+
+void inline_optimize_ast(Ast* ast, SymbolTable* global_scope, FILE* stats);
+
+#endif // INLINE_H
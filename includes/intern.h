@@ -0,0 +1,33 @@
+#ifndef INTERN_H
+#define INTERN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// tabela global de nomes internados: cada texto distinto (identificador ou
+// literal) recebe um número uma única vez, e daí em diante comparar nomes é
+// comparar números. os textos só são liberados por intern_release. pode ser
+// usada por várias threads ao mesmo tempo (o lexer paralelo interna em todos
+// os pedaços).
+typedef uint32_t NameId;
+
+// nenhum nome (intern_name devolve NULL)
+#define NAME_NONE 0
+
+// número do texto s[0..length), criando um se ele ainda não existir
+NameId intern(const char* s, size_t length);
+
+// o mesmo para uma string terminada em '\0'
+NameId intern_cstr(const char* s);
+
+// texto de um nome (terminado em '\0'), ou NULL para NAME_NONE
+const char* intern_name(NameId id);
+
+// marcam o começo e o fim de uma compilação da biblioteca. quando a última
+// compilação em andamento termina, a tabela é esvaziada e os números
+// antigos deixam de valer; assim um processo que atende muitas compilações
+// (o --server) não acumula os nomes de todas elas.
+void intern_retain(void);
+void intern_release(void);
+
+#endif // INTERN_H
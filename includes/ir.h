@@ -0,0 +1,135 @@
+#ifndef IR_H
+#define IR_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "ast.h"
+#include "symtab.h"
+#include "constant.h"
+
+// representação intermediária em SSA, uma função por vez. o grafo de
+// fluxo sai direto da estrutura da AST (if e while) e as variáveis locais
+// viram valores SSA durante a construção: cada atribuição cria um valor
+// novo e as junções recebem phis. cada bloco tem no máximo dois
+// predecessores e dois sucessores, porque a linguagem não tem break nem
+// goto.
+
+typedef uint32_t IrValue;   // índice da instrução na função
+#define IR_NONE 0
+
+typedef enum {
+    IR_CONST,       // value
+    IR_PARAM,       // parâmetro var
+    IR_UNDEF,       // valor de var antes de qualquer atribuição
+    IR_PHI,         // um operando por predecessor, na ordem de pred[]
+    IR_COPY,        // atribuição a var; origin é o nó da AST
+    IR_BINARY,      // node_op entre os dois operandos
+    IR_NEGATE,
+    IR_CONVERT,     // para type
+    IR_CALL,        // chamada da função var com os operandos
+    IR_SCAN,        // lê var
+    IR_PRINT,       // imprime os operandos
+    IR_RETURN,
+    IR_JUMP,        // para succ[0]
+    IR_BRANCH       // succ[0] se o operando for verdadeiro, senão succ[1]
+} IrOp;
+
+// estado de um valor na propagação de constantes
+typedef enum {
+    LATTICE_UNKNOWN,    // ainda sem valor (nenhum caminho chegou nele)
+    LATTICE_CONSTANT,   // sempre o mesmo valor
+    LATTICE_VARYING     // depende da execução
+} Lattice;
+
+#define IR_LIVE   1     // marcada pela eliminação de código morto
+#define IR_PINNED 2     // atribuição a uma variável que não virou SSA
+
+typedef struct {
+    uint8_t op;             // IrOp
+    uint8_t type;           // SymbolDataType do resultado
+    uint8_t node_op;        // IR_BINARY: o NodeType do operador
+    uint8_t lattice;        // Lattice
+    uint8_t flags;
+    int block;
+    int operand_start;      // índice em IrFunction.operands
+    int operand_count;
+    IrValue next;           // próxima instrução do bloco
+    IrValue expr_start;     // IR_COPY: primeira instrução da expressão
+    SymbolNode* var;
+    AstId origin;           // IR_COPY: NODE_ASSIGNMENT ou NODE_DECLARATION
+    Constant value;         // IR_CONST, ou o valor que a propagação achou
+} IrInstr;
+
+typedef struct {
+    IrValue first;
+    IrValue last;
+    int pred[2];
+    int pred_count;
+    int succ[2];
+    int succ_count;
+    int executable;         // alcançável segundo a propagação de constantes
+} IrBlock;
+
+// nó da AST e o que a IR sabe dele: para um NODE_IDENTIFIER, o valor SSA
+// que ele lê; para uma instrução, o bloco onde ela começa
+typedef struct {
+    AstId node;
+    uint32_t index;
+} IrLink;
+
+typedef struct {
+    SymbolNode* symbol;     // NULL no bloco principal
+    SymbolTable* scope;
+    AstId body;
+
+    IrInstr* instrs;        // o índice 0 fica reservado (IR_NONE)
+    int instr_count;
+    int instr_capacity;
+    IrValue* operands;
+    int operand_count;
+    int operand_capacity;
+    IrBlock* blocks;
+    int block_count;
+    int block_capacity;
+    IrLink* uses;           // leituras de variável na AST
+    int use_count;
+    int use_capacity;
+    IrLink* statements;     // instruções da AST e seus blocos
+    int statement_count;
+    int statement_capacity;
+} IrFunction;
+
+// monta a IR de uma função, ou do bloco principal com func == AST_NONE
+// (body é o bloco e scope o escopo global)
+IrFunction* ir_build(const Ast* ast, AstId func, AstId body, SymbolTable* scope);
+
+void ir_free(IrFunction* f);
+
+static inline IrValue ir_operand(const IrFunction* f, IrValue v, int i) {
+    return f->operands[f->instrs[v].operand_start + i];
+}
+
+// propagação condicional esparsa de constantes (Wegman e Zadeck): marca os
+// blocos alcançáveis e acha o valor de cada instrução
+void ir_propagate_constants(IrFunction* f);
+
+// eliminação de código morto: marca como vivas as instruções com efeito
+// (print, scan, chamadas, return e divisões inteiras que podem falhar) nos
+// blocos alcançáveis e o que elas leem. valores constantes não contam como
+// lidos, já que viram literais.
+void ir_mark_live(IrFunction* f);
+
+// lista a IR. otimizada, só mostra os blocos alcançáveis e as instruções
+// vivas, com as constantes no lugar dos valores.
+void ir_print(const IrFunction* f, int optimized, FILE* out);
+
+// monta e lista a IR de todas as funções do programa (--dump-ir)
+void ir_dump_program(const Ast* ast, SymbolTable* global_scope, int optimized, FILE* out);
+
+// aplica na AST o que a IR descobriu: variáveis com valor constante viram
+// literais, atribuições e declarações cujo valor nunca é lido saem, e
+// instruções em blocos inalcançáveis (depois de um return, ou num ramo que
+// nunca é tomado) também
+void ir_optimize_ast(Ast* ast, SymbolTable* global_scope);
+
+#endif // IR_H
@@ -0,0 +1,13 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include "ast.h"
+#include "symtab.h"
+
+// gera código de máquina x86-64 direto na memória e executa o programa,
+// sem assembler, ligador nem arquivos temporários. as variáveis ficam no
+// quadro da função em [rbp - 8 * (endereço + 1)], usando os endereços que o
+// parser guardou em SymbolNode.address. devolve o valor retornado pela entrada.
+int jit_run(const Ast* ast, SymbolTable* global_scope);
+
+#endif // JIT_H
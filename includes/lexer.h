@@ -1,11 +1,56 @@
 #ifndef LEXER_H
 #define LEXER_H
 
+#include <stddef.h>
+#include <stdio.h>
 #include "token.h"
 
-Token* tokenize(const char* source_code, int* token_count);
+// divide os length bytes de source_code em tokens. os tokens apontam para
+// source_code, então ele não pode ser liberado antes deles. o texto precisa
+// terminar com SOURCE_PADDING bytes zerados (ver source.h), porque o lexer
+// lê em blocos. textos grandes são lidos em paralelo no pool compartilhado.
+Token* tokenize(const char* source_code, size_t length, int* token_count);
 
-void free_tokens(Token* tokens, int token_count);
+// escreve o lexema do token (o fim do arquivo aparece como "EOF")
+void token_fprint(FILE* out, const char* source_code, Token t);
+
+void free_tokens(Token* tokens);
+
+// quantos tokens o fluxo sob demanda guarda (potência de 2). o parser
+// olha no máximo um token à frente do atual.
+#define TOKEN_WINDOW 8
+
+struct LexerState;
+
+// fluxo de tokens para o parser. ou percorre um vetor pronto, ou lê os
+// tokens sob demanda guardando só os últimos TOKEN_WINDOW numa janela
+// circular, sem vetor do tamanho do arquivo.
+typedef struct {
+    Token* tokens;              // vetor pronto, ou NULL na leitura sob demanda
+    int count;                  // total de tokens (-1 enquanto não achou o fim)
+    int position;               // índice do token atual
+    int owns_tokens;            // o vetor é liberado por token_stream_close
+    struct LexerState* lexer;
+    const char* end;
+    Token window[TOKEN_WINDOW];
+    int lexed;                  // tokens lidos até agora
+} TokenStream;
+
+// percorre um vetor de tokens já pronto (que continua sendo de quem chamou)
+void token_stream_from_array(TokenStream* stream, Token* tokens, int count);
+
+// lê os tokens de source_code sob demanda. textos grandes, quando há mais
+// de um núcleo, são lidos de uma vez em paralelo com tokenize.
+void token_stream_open(TokenStream* stream, const char* source_code, size_t length);
+
+// token k posições à frente do atual (0 <= k < TOKEN_WINDOW). depois do fim
+// devolve sempre o EOF.
+Token token_stream_peek(TokenStream* stream, int k);
+
+// avança para o próximo token (parando no EOF)
+void token_stream_next(TokenStream* stream);
+
+void token_stream_close(TokenStream* stream);
 
 #endif // LEXER_H
 
@@ -0,0 +1,39 @@
+#ifndef LEXER_SCAN_H
+#define LEXER_SCAN_H
+
+// classes de caractere, consultadas numa tabela de 256 posições em vez de
+// isalpha/isdigit (que dependem do locale)
+enum {
+    CHAR_DIGIT = 1,         // 0-9
+    CHAR_IDENT_START = 2,   // letra ou '_'
+    CHAR_IDENT = 4,         // letra, dígito ou '_'
+    CHAR_SPACE = 8,         // espaço, tab e '\r'
+    CHAR_NEWLINE = 16       // '\n', separado porque conta linha
+};
+
+// calculada em tempo de compilação (src/lexer_scan.c)
+extern const unsigned char char_class[256];
+
+#define CLASS_OF(c) (char_class[(unsigned char)(c)])
+
+// rotinas que percorrem sequências de caracteres de uma vez, usadas pelo
+// lexer. todas leem blocos inteiros (até 32 bytes) a partir da posição dada,
+// então o texto precisa de SOURCE_PADDING bytes zerados depois do '\0'
+// (o que source_open já garante).
+typedef struct {
+    const char* name;
+    // pula espaços, tabs, '\r' e '\n', somando em *lines as quebras de linha
+    const char* (*skip_blank)(const char* p, int* lines);
+    // primeira posição com '\n' ou '\0' (fim de um comentário //)
+    const char* (*line_end)(const char* p);
+    // primeira posição que não é letra, dígito nem '_'
+    const char* (*ident_end)(const char* p);
+    // primeira posição que não é dígito
+    const char* (*digit_end)(const char* p);
+} LexScanner;
+
+// melhor versão para a CPU atual (AVX2, SSE2 ou escalar), escolhida na
+// primeira chamada. definir LEXER_NO_SIMD na compilação força a escalar.
+const LexScanner* lex_scanner(void);
+
+#endif // LEXER_SCAN_H
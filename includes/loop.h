@@ -0,0 +1,23 @@
+#ifndef LOOP_H
+#define LOOP_H
+
+#include "ast.h"
+#include "symtab.h"
+
+// otimizações dos while, dos laços de dentro para os de fora:
+//
+// - variáveis de indução básicas: i com uma atribuição só no laço, da forma
+//   i = i + c ou i = i - c (c literal inteiro) no nível de cima do corpo.
+// - desenrolamento: se i tem valor literal na entrada e a condição compara
+//   i com um literal, o número de voltas sai na compilação. com poucas
+//   voltas (e um corpo pequeno) o laço vira cópias do corpo em sequência.
+// - código invariante: as contas puras cujas variáveis não mudam no laço
+//   vão para temporárias (_inv1, ...) calculadas uma vez antes dele.
+// - redução de força: i * k, com k literal ou invariante, vira uma variável
+//   (_ind1, ...) que começa em i * k e soma c * k junto com o incremento.
+//
+// devolve o número de laços desenrolados, para quem chama rodar a
+// propagação de constantes de novo sobre as cópias
+int loop_optimize_ast(Ast* ast, SymbolTable* global_scope);
+
+#endif // LOOP_H
@@ -0,0 +1,25 @@
+#ifndef OPTIMIZE_H
+#define OPTIMIZE_H
+
+#include <stdio.h>
+#include "ast.h"
+#include "symtab.h"
+
+// otimiza a AST já analisada, antes de qualquer backend:
+//   - operações e comparações entre literais viram um literal só
+//     (divisão inteira por zero fica para dar o erro na execução);
+//   - identidades como x * 1, x + 0, x - 0, x / 1 e x * 0 (esta só para
+//     inteiros e com x sem chamadas nem divisões que possam falhar);
+//   - if com condição constante vira só o bloco escolhido, e while com
+//     condição constante falsa some.
+// os nós que saem da árvore continuam nos vetores, só sem ligação.
+void optimize_ast(Ast* ast);
+
+// todas as otimizações: a expansão de funções pequenas (ver inline.h), a
+// dobra acima, depois a propagação de constantes e a eliminação de código
+// morto na IR em SSA (ver ir.h), a dobra de novo, as otimizações de laços
+// (ver loop.h) e por fim a eliminação de subexpressões comuns (ver cse.h).
+// stats (ou NULL) recebe o relatório da expansão
+void optimize_program(Ast* ast, SymbolTable* global_scope, FILE* stats);
+
+#endif // OPTIMIZE_H
@@ -1,18 +1,36 @@
 #ifndef PARSER_H
 #define PARSER_H
 
-#include "token.h"
+#include "lexer.h"
 #include "ast.h"
 #include "symtab.h"
 
 typedef struct {
-    Token* tokens;
-    int current;
-    int token_count;
+    TokenStream* stream; // de onde vêm os tokens (vetor pronto ou sob demanda)
     SymbolTable* current_scope;
     int next_address;
+    Arena* arena;       // onde os escopos e símbolos são alocados
+    Ast* ast;           // onde os nós são criados
+    const char* source; // código-fonte para onde os tokens apontam
+    int parallel;       // analisa as funções do nível mais alto em paralelo
+    int function_count; // funções já declaradas (visíveis para chamadas)
+    int predeclared;    // a assinatura da função já está na tabela global
+    int depth;          // aninhamento atual de blocos e expressões
+    int max_depth;      // limite do aninhamento (0 = PARSER_DEFAULT_MAX_DEPTH)
 } ParserState;
 
-ASTNode* parse(ParserState* state);
+// o parser é recursivo: cada nível de parênteses, menos unário ou bloco
+// aninhado gasta pilha aqui e nas fases seguintes. passar do limite é um
+// erro de sintaxe em vez de estouro de pilha.
+#define PARSER_DEFAULT_MAX_DEPTH 1000
+
+// analisa o programa inteiro. com state->parallel, programas grandes já
+// divididos em tokens num vetor têm as
+// funções do nível mais alto analisadas em threads do pool compartilhado:
+// as assinaturas são registradas antes, em ordem, e cada corpo é lido com
+// seu próprio ParserState, sua própria arena e sua própria AST,
+// copiada depois para a principal. a AST resultante é igual à
+// da análise sequencial. a raiz também fica em state->ast->root.
+AstId parse(ParserState* state);
 
 #endif // PARSER_H
@@ -0,0 +1,18 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+// modo servidor: um processo só, já aquecido, atende compilações por um
+// socket Unix em socket_path. cada conexão é um pedido:
+//
+//     <alvo> [max-depth=N]\n      alvo: check, asm ou c
+//     <código-fonte até o fim da escrita do cliente>
+//
+// e recebe uma resposta antes de a conexão ser fechada:
+//
+//     ok <n>\n<n bytes do código gerado>
+//     erro <n>\n<n bytes da mensagem>
+//
+// o pedido "shutdown" encerra o servidor. devolve o código de saída.
+int server_run(const char* socket_path);
+
+#endif // SERVER_H
@@ -0,0 +1,27 @@
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include <stddef.h>
+
+// bytes zerados garantidos depois do fim do texto. o lexer para no '\0' e
+// pode ler blocos inteiros perto do fim sem checar o tamanho.
+#define SOURCE_PADDING 64
+
+// código-fonte carregado na memória. arquivos comuns são mapeados com mmap
+// (somente leitura, sem cópia); stdin, pipes e FIFOs são lidos em blocos.
+typedef struct {
+    const char* text;       // termina com pelo menos SOURCE_PADDING zeros
+    size_t length;
+    void* mapping;          // região mapeada, ou NULL se o texto foi lido
+    size_t mapping_size;
+} Source;
+
+// abre o arquivo em path ("-" lê da entrada padrão). termina o programa
+// com código 74 se não conseguir ler, ou chama compile_error se houver uma
+// armadilha de erros armada (veja diagnostic.h).
+Source* source_open(const char* path);
+
+// libera o texto e o próprio Source
+void source_close(Source* source);
+
+#endif // SOURCE_H
@@ -2,6 +2,8 @@
 #define SYMTAB_H
 
 #include "ast.h"
+#include "arena.h"
+#include "intern.h"
 
 //
 // tipos de dados que a linguagem de programação vai ter.
@@ -24,40 +26,51 @@ typedef enum {
 } SymbolKind;
 
 typedef struct SymbolNode {
-    char* name;
+    NameId id;          // nome internado, a chave da tabela
+    const char* name;   // texto do nome (o mesmo de intern_name(id))
     SymbolKind kind;
     SymbolDataType type;
     int line;
     int address;
-    struct SymbolNode* next;
+    int order;          // funções: posição da declaração no programa (0, 1, ...)
+    struct SymbolNode* next;    // próximo símbolo do escopo, na ordem de declaração
 } SymbolNode;
 
-#define SYMBOL_TABLE_SIZE 256
-
 typedef struct SymbolTable {
-    // tabela de hash.
-    SymbolNode* table[SYMBOL_TABLE_SIZE];
+    // tabela de hash com endereçamento aberto, indexada pelo NameId. começa
+    // pequena e dobra quando fica metade cheia, então funções com poucas
+    // variáveis custam poucos bytes.
+    SymbolNode** slots;
+    int capacity;       // potência de 2
+    int shift;          // 32 - log2(capacity), para o hash multiplicativo
+    int count;
+
+    SymbolNode* first;  // símbolos na ordem de declaração
+    SymbolNode* last;
     struct SymbolTable* parent;
+    Arena* arena;       // de onde saem os símbolos e os escopos filhos
 } SymbolTable;
 
 
-// cria uma nova tabela de símbolos
-SymbolTable* scope_create();
+// cria uma nova tabela de símbolos na arena; ela é liberada junto com a arena
+SymbolTable* scope_create(Arena* arena);
 
-// libera a memória de uma tabela
-void scope_destroy(SymbolTable* st);
+// entra em um novo escopo, alocado em arena (que pode ser diferente da do
+// pai quando funções são analisadas em paralelo)
+SymbolTable* scope_enter(Arena* arena, SymbolTable* parent);
 
-// entra em um novo escopo
-SymbolTable* scope_enter(SymbolTable* parent);
-
-// insere um novo símbolo na tabela
-void scope_insert(SymbolTable* st, const char* name, SymbolKind kind, SymbolDataType type, int line, int address);
+// insere um novo símbolo na tabela e o devolve
+SymbolNode* scope_insert(SymbolTable* st, NameId name, SymbolKind kind, SymbolDataType type, int line, int address);
 
 // orocura por um símbolo na tabela atual e nas tabelas pai
-SymbolNode* scope_lookup(SymbolTable* st, const char* name);
+SymbolNode* scope_lookup(SymbolTable* st, NameId name);
 
 // orocura por um símbolo na tabela atual
-SymbolNode* scope_lookup_current(SymbolTable* st, const char* name);
+SymbolNode* scope_lookup_current(SymbolTable* st, NameId name);
+
+// número de endereços usados pelas variáveis e parâmetros do escopo
+// (maior endereço mais um)
+int scope_frame_size(SymbolTable* st);
 
 // imprime o conteúdo da tabela de símbolos
 void scope_dump(SymbolTable* st);
@@ -0,0 +1,47 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+// conjunto fixo de threads com roubo de tarefas: cada thread auxiliar tem
+// sua fila, onde ficam as tarefas que ela cria, e quando fica sem trabalho
+// rouba das filas das outras. as tarefas criadas fora do pool vão para uma
+// fila comum. quem espera um grupo de tarefas também executa tarefas
+// pendentes enquanto espera, então uma tarefa pode criar e esperar outras
+// sem travar o pool.
+typedef struct ThreadPool ThreadPool;
+
+typedef void (*TaskFunction)(void* arg);
+
+// tarefas que são esperadas juntas
+typedef struct {
+    int pending;
+} TaskGroup;
+
+#define TASK_GROUP_INIT { 0 }
+
+// cria um pool com threads participantes (contando a que espera), ou seja,
+// threads - 1 threads auxiliares. threads <= 0 usa o número de núcleos.
+ThreadPool* thread_pool_create(int threads);
+
+// pool compartilhado pelo compilador, criado na primeira chamada
+ThreadPool* thread_pool_shared(void);
+
+// número de threads do pool compartilhado; precisa ser chamada antes do
+// primeiro thread_pool_shared (senão é ignorada)
+void thread_pool_set_shared_size(int threads);
+
+// número de threads que participam do pool
+int thread_pool_size(ThreadPool* pool);
+
+// coloca function(arg) na fila como parte do grupo
+void thread_pool_submit(ThreadPool* pool, TaskGroup* group, TaskFunction function, void* arg);
+
+// espera todas as tarefas do grupo terminarem, executando tarefas da fila
+void thread_pool_wait(ThreadPool* pool, TaskGroup* group);
+
+// espera as threads auxiliares terminarem e libera o pool
+void thread_pool_destroy(ThreadPool* pool);
+
+// número de núcleos disponíveis
+int cpu_count(void);
+
+#endif // THREADPOOL_H
@@ -1,6 +1,9 @@
 #ifndef TOKEN_H
 #define TOKEN_H
 
+#include <stdint.h>
+#include "intern.h"
+
 typedef enum {
     // início e fim de bloco de código
     TOKEN_BEGIN,
@@ -63,12 +66,24 @@ typedef enum {
     TOKEN_UNKNOWN
 } TokenType;
 
+// token compacto (16 bytes): o lexema não é copiado, o token só guarda onde
+// ele está no código-fonte, que precisa continuar vivo enquanto os tokens
+// forem usados. identificadores já saem do lexer internados.
 typedef struct {
-    TokenType type;
-    char* lexeme;
-    int line;
+    uint32_t offset;    // posição do lexema no código-fonte
+    uint32_t line;
+    NameId name;        // identificadores: nome internado (senão NAME_NONE)
+    uint16_t length;    // tamanho do lexema em bytes
+    uint8_t type;       // um TokenType
 } Token;
 
+#define TOKEN_MAX_LENGTH UINT16_MAX
+
+// início do lexema no código-fonte (não termina com '\0', use length)
+static inline const char* token_start(const char* source, Token t) {
+    return source + t.offset;
+}
+
 const char* token_type_to_string(TokenType type);
 
 #endif // TOKEN_H
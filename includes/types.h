@@ -0,0 +1,20 @@
+#ifndef TYPES_H
+#define TYPES_H
+
+#include "ast.h"
+#include "symtab.h"
+
+// checa se o nó é um operador de comparação (==, !=, <, <=, >, >=)
+int is_comparison(NodeType type);
+
+// tipo estático de uma expressão. variáveis e chamadas usam o símbolo que o
+// parser ligou ao nó. o tipo de cada nó é calculado uma vez, a partir dos
+// filhos, e fica guardado na AST; as otimizações só trocam uma expressão
+// por outra do mesmo tipo, então o valor guardado continua valendo.
+SymbolDataType expr_type(const Ast* ast, AstId expr);
+
+// tipo em que os dois operandos de um operador binário são avaliados:
+// float se algum deles for float, senão inteiro
+SymbolDataType operand_type(const Ast* ast, AstId op);
+
+#endif // TYPES_H
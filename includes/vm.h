@@ -0,0 +1,10 @@
+#ifndef VM_H
+#define VM_H
+
+#include "bytecode.h"
+
+// executa o programa a partir da função de entrada e devolve o valor
+// retornado por ela (usado como código de saída do processo)
+int vm_run(const BytecodeProgram* program);
+
+#endif // VM_H
@@ -1,74 +1,203 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "lexer.h"
 #include "parser.h"
+#include "bytecode.h"
+#include "vm.h"
+#include "codegen.h"
+#include "jit.h"
+#include "eval.h"
+#include "source.h"
+#include "server.h"
+#include "optimize.h"
+#include "ir.h"
+#include "driver.h"
+#include "threadpool.h"
 
-// ler o arquivo de codigo fonte
-static char* read_file(const char* path) {
-  FILE* file = fopen(path, "rb");
-  if (file == NULL) {
-      fprintf(stderr, "Não foi possível abrir o arquivo \"%s\".\n", path);
-      exit(74);
-  }
+// o que fazer depois da análise
+typedef enum {
+    MODE_DUMP,      // imprime tokens, tabela de símbolos e AST
+    MODE_RUN,       // executa na máquina virtual
+    MODE_JIT,       // gera código de máquina na memória e executa
+    MODE_EVAL,      // interpreta a AST convertida em closures
+    MODE_EMIT_ASM,  // gera assembly x86-64
+    MODE_EMIT_C,    // gera C portável
+    MODE_CHECK,     // só analisa (erros léxicos, sintáticos e semânticos)
+    MODE_DUMP_IR    // imprime a IR em SSA de cada função
+} Mode;
 
-  // descobre o tamanho do arquivo
-  fseek(file, 0L, SEEK_END);
-  size_t file_size = ftell(file);
-  rewind(file);
-  // aloca memória para guardar o conteúdo do arquivo
-  char* buffer = (char*)malloc(file_size + 1);
-  if (buffer == NULL) {
-      fprintf(stderr, "Memória insuficiente para ler \"%s\".\n", path);
-      exit(74);
-  }
-  // lê o arquivo para o buffer
-  size_t bytes_read = fread(buffer, sizeof(char), file_size, file);
-  if (bytes_read < file_size) {
-      fprintf(stderr, "Não foi possível ler o arquivo \"%s\".\n", path);
-      exit(74);
-  }
-  buffer[bytes_read] = '\0';
-  fclose(file);
-  return buffer;
+static void usage(const char* program) {
+    fprintf(stderr, "Uso: %s [opções] <ficheiro.lang | diretório | ->...\n", program);
+    fprintf(stderr, "  --run          compila para bytecode e executa o programa\n");
+    fprintf(stderr, "  --jit          compila para código de máquina na memória e executa\n");
+    fprintf(stderr, "  --eval         interpreta o programa por closures, sem backend\n");
+    fprintf(stderr, "  --emit=asm     gera assembly x86-64 (ficheiro .s)\n");
+    fprintf(stderr, "  --emit=c       gera código C (ficheiro .c)\n");
+    fprintf(stderr, "  --check        só analisa o programa, sem gerar nada\n");
+    fprintf(stderr, "  --dump-ir      imprime a IR em SSA de cada função (otimizada, sem -O0)\n");
+    fprintf(stderr, "  -o <ficheiro>  nome do ficheiro gerado (com uma entrada só)\n");
+    fprintf(stderr, "  -O0            não otimiza a AST antes de executar ou gerar código\n");
+    fprintf(stderr, "  --stats        mostra na saída de erros o orçamento e as decisões da expansão de funções\n");
+    fprintf(stderr, "  -jN            compila com N threads (padrão: um por núcleo)\n");
+    fprintf(stderr, "  --max-depth=N  limite de aninhamento de blocos e expressões (padrão %d)\n", PARSER_DEFAULT_MAX_DEPTH);
+    fprintf(stderr, "  --server=SOCK  atende compilações por um socket Unix, sem sair\n");
+    fprintf(stderr, "  -              lê o programa da entrada padrão\n");
+    fprintf(stderr, "Com vários arquivos ou um diretório, só --check, --emit=asm e --emit=c (sem -o nem --stats).\n");
+    exit(1);
+}
+
+static FILE* open_output(const char* path) {
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        fprintf(stderr, "Não foi possível criar o arquivo \"%s\".\n", path);
+        exit(74);
+    }
+    return file;
 }
 
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        fprintf(stderr, "Uso: %s <ficheiro.lang>\n", argv[0]);
-        return 1;
+    char** inputs = (char**)malloc(argc * sizeof(char*));
+    int input_count = 0;
+    const char* output = NULL;
+    const char* server_socket = NULL;
+    Mode mode = MODE_DUMP;
+    int max_depth = PARSER_DEFAULT_MAX_DEPTH;
+    int optimize = 1;
+    int stats = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--run") == 0) mode = MODE_RUN;
+        else if (strcmp(argv[i], "--jit") == 0) mode = MODE_JIT;
+        else if (strcmp(argv[i], "--eval") == 0) mode = MODE_EVAL;
+        else if (strcmp(argv[i], "--emit=asm") == 0) mode = MODE_EMIT_ASM;
+        else if (strcmp(argv[i], "--emit=c") == 0) mode = MODE_EMIT_C;
+        else if (strcmp(argv[i], "--check") == 0) mode = MODE_CHECK;
+        else if (strcmp(argv[i], "--dump-ir") == 0) mode = MODE_DUMP_IR;
+        else if (strcmp(argv[i], "-O0") == 0) optimize = 0;
+        else if (strcmp(argv[i], "--stats") == 0) stats = 1;
+        else if (strcmp(argv[i], "-O1") == 0 || strcmp(argv[i], "-O") == 0) optimize = 1;
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) output = argv[++i];
+        else if (strncmp(argv[i], "--max-depth=", 12) == 0) {
+            max_depth = atoi(argv[i] + 12);
+            if (max_depth <= 0) usage(argv[0]);
+        }
+        else if (strncmp(argv[i], "--server=", 9) == 0 && argv[i][9] != '\0') server_socket = argv[i] + 9;
+        else if (strncmp(argv[i], "-j", 2) == 0) {
+            int threads = atoi(argv[i][2] ? argv[i] + 2 : (i + 1 < argc ? argv[++i] : ""));
+            if (threads <= 0) usage(argv[0]);
+            thread_pool_set_shared_size(threads);
+        }
+        else if (argv[i][0] == '-' && argv[i][1] != '\0') usage(argv[0]);
+        else inputs[input_count++] = argv[i];
+    }
+    if (server_socket) {
+        if (input_count) usage(argv[0]);
+        return server_run(server_socket);
+    }
+    if (input_count == 0) usage(argv[0]);
+
+    // vários arquivos (ou um diretório): cada um é compilado numa tarefa do pool
+    if (input_count > 1 || is_directory(inputs[0])) {
+        if (output || stats || (mode != MODE_CHECK && mode != MODE_EMIT_ASM && mode != MODE_EMIT_C)) usage(argv[0]);
+        CompileOptions options = {
+            mode == MODE_CHECK ? COMPILE_CHECK : mode == MODE_EMIT_ASM ? COMPILE_EMIT_ASM : COMPILE_EMIT_C,
+            max_depth, !optimize
+        };
+        int status = driver_compile_files(inputs, input_count, &options);
+        free(inputs);
+        return status;
     }
+    const char* path = inputs[0];
+    free(inputs);
 
-    // lê o código-fonte do arquivo
-    char* source_code = read_file(argv[1]);
+    // carrega o código-fonte (mapeado direto do arquivo quando possível)
+    Source* source = source_open(path);
+    const char* source_code = source->text;
     
+    // modos sem despejo: só a saída do programa ou o arquivo gerado
+    if (mode != MODE_DUMP) {
+        // os tokens são lidos conforme o parser pede
+        TokenStream stream;
+        token_stream_open(&stream, source_code, source->length);
+
+        // símbolos, escopos e lexemas vão para a mesma arena; os nós ficam
+        // nos vetores da AST
+        Arena* arena = arena_create();
+        Ast* ast = ast_create();
+        SymbolTable* global_scope = scope_create(arena);
+        ParserState state = {&stream, global_scope, 0, arena, ast, source_code, 1};
+        state.max_depth = max_depth;
+        parse(&state);
+        if (mode == MODE_DUMP_IR) {
+            // a IR do programa só dobrado, antes de voltar para a AST
+            if (optimize) optimize_ast(ast);
+            ir_dump_program(ast, global_scope, optimize, stdout);
+        } else if (optimize) {
+            optimize_program(ast, global_scope, stats ? stderr : NULL);
+        }
+        int status = 0;
+
+        if (mode == MODE_RUN) {
+            BytecodeProgram* program = bytecode_compile(ast, global_scope);
+            status = vm_run(program);
+            bytecode_free(program);
+        } else if (mode == MODE_JIT) {
+            status = jit_run(ast, global_scope);
+        } else if (mode == MODE_EVAL) {
+            status = eval_run(ast, global_scope);
+        } else if (mode == MODE_EMIT_ASM || mode == MODE_EMIT_C) {
+            const char* extension = mode == MODE_EMIT_ASM ? ".s" : ".c";
+            char* out_path = output ? strdup(output) : default_output_path(path, extension);
+            FILE* out = open_output(out_path);
+            if (mode == MODE_EMIT_ASM) codegen_emit_asm(ast, global_scope, out);
+            else codegen_emit_c(ast, global_scope, out);
+            fclose(out);
+            free(out_path);
+        }
+
+        token_stream_close(&stream);
+        source_close(source);
+        ast_free(ast);
+        arena_destroy(arena);
+        return status;
+    }
+
     // análise léxica
     int token_count = 0;
-    Token* tokens = tokenize(source_code, &token_count);
+    Token* tokens = tokenize(source_code, source->length, &token_count);
 
     printf("--- Tokens ---\n");
     // imprime os tokens
     for (int i = 0; i < token_count; i++) {
-      printf("  [%d] Tipo: %-20s Lexema: '%s'\n", tokens[i].line, token_type_to_string(tokens[i].type), tokens[i].lexeme);
+      printf("  [%d] Tipo: %-20s Lexema: '", tokens[i].line, token_type_to_string(tokens[i].type));
+      token_fprint(stdout, source_code, tokens[i]);
+      printf("'\n");
     }
     printf("\n--- Análise Sintática e Semântica ---\n");
     
     // análise sintática e semântica (parser)
     // pega os tokens e constrói a AST e verifica se o código faz sentido erros semânticos
-    SymbolTable* global_scope = scope_create();
-    ParserState state = {tokens, 0, token_count, global_scope, 0};
-    ASTNode* ast_root = parse(&state);
+    Arena* arena = arena_create();
+    Ast* ast = ast_create();
+    SymbolTable* global_scope = scope_create(arena);
+    TokenStream stream;
+    token_stream_from_array(&stream, tokens, token_count);
+    ParserState state = {&stream, global_scope, 0, arena, ast, source_code, 1};
+    state.max_depth = max_depth;
+    AstId ast_root = parse(&state);
     printf("Análise concluída com sucesso.\n");
     
     printf("\n--- Tabela de Símbolos ---\n");
     scope_dump(global_scope);
     
     printf("\n--- Árvore Sintática Abstrata ---\n");
-    print_ast(ast_root, 0);
+    print_ast(ast, ast_root, 0);
     
     printf("\nLimpando memória...\n");
-    free(source_code);
-    free_tokens(tokens, token_count);
-    free_ast(ast_root);
+    source_close(source);
+    free_tokens(tokens);
+    ast_free(ast);
+    arena_destroy(arena);
     printf("Concluído.\n");
 
     return 0;
@@ -0,0 +1,98 @@
+#include "arena.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_BLOCK_SIZE (256 * 1024)
+#define ARENA_ALIGNMENT 16
+
+struct ArenaBlock {
+    struct ArenaBlock* next;
+    size_t size;
+    // os dados vêm logo depois do cabeçalho, já alinhados
+};
+
+#define BLOCK_HEADER ((sizeof(ArenaBlock) + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1))
+
+static void arena_push_block(Arena* arena, size_t min_size) {
+    size_t size = min_size > ARENA_BLOCK_SIZE ? min_size : ARENA_BLOCK_SIZE;
+    ArenaBlock* block = (ArenaBlock*)malloc(BLOCK_HEADER + size);
+    if (!block) {
+        perror("Falha ao alocar bloco da arena");
+        exit(EXIT_FAILURE);
+    }
+    block->next = arena->head;
+    block->size = size;
+    arena->head = block;
+    arena->cursor = (char*)block + BLOCK_HEADER;
+    arena->limit = arena->cursor + size;
+}
+
+Arena* arena_create(void) {
+    Arena* arena = (Arena*)malloc(sizeof(Arena));
+    if (!arena) {
+        perror("Falha ao alocar arena");
+        exit(EXIT_FAILURE);
+    }
+    arena->head = NULL;
+    arena->cursor = NULL;
+    arena->limit = NULL;
+    arena_push_block(arena, ARENA_BLOCK_SIZE);
+    return arena;
+}
+
+void* arena_alloc(Arena* arena, size_t size) {
+    size = (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+    if ((size_t)(arena->limit - arena->cursor) < size) arena_push_block(arena, size);
+    void* p = arena->cursor;
+    arena->cursor += size;
+    return p;
+}
+
+void* arena_calloc(Arena* arena, size_t size) {
+    void* p = arena_alloc(arena, size);
+    memset(p, 0, size);
+    return p;
+}
+
+char* arena_strndup(Arena* arena, const char* s, size_t length) {
+    char* copy = (char*)arena_alloc(arena, length + 1);
+    memcpy(copy, s, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+char* arena_strdup(Arena* arena, const char* s) {
+    return arena_strndup(arena, s, strlen(s));
+}
+
+void arena_merge(Arena* into, Arena* from) {
+    // os blocos entram depois do bloco atual de into, que continua sendo
+    // o usado pelas próximas alocações
+    ArenaBlock* last = from->head;
+    while (last->next) last = last->next;
+    last->next = into->head->next;
+    into->head->next = from->head;
+    free(from);
+}
+
+void arena_reset(Arena* arena) {
+    // o bloco mais antigo fica no fim da lista; é ele que sobrevive
+    while (arena->head->next) {
+        ArenaBlock* next = arena->head->next;
+        free(arena->head);
+        arena->head = next;
+    }
+    arena->cursor = (char*)arena->head + BLOCK_HEADER;
+    arena->limit = arena->cursor + arena->head->size;
+}
+
+void arena_destroy(Arena* arena) {
+    if (!arena) return;
+    while (arena->head) {
+        ArenaBlock* next = arena->head->next;
+        free(arena->head);
+        arena->head = next;
+    }
+    free(arena);
+}
@@ -1,64 +1,147 @@
 #include "ast.h"
-#include "symtab.h"
+#include "diagnostic.h"
 #include <stdio.h>
 #include <stdlib.h>
-#include <string.h>
-
-// cria um novo nó para a AST
-ASTNode* create_node(NodeType type, const char* value) {
-    ASTNode* node = (ASTNode*)malloc(sizeof(ASTNode));
-    if (!node) {
-        perror("Falha ao alocar ASTNode");
-        exit(EXIT_FAILURE);
-    }
-    node->type = type;
-    node->value = value ? strdup(value) : NULL;
-    node->child = NULL;
-    node->sibling = NULL;
-    node->scope = NULL;
+
+#define AST_INITIAL_CAPACITY 256
+
+static void ast_error(void) {
+    compile_error("Erro: memória insuficiente para a AST.");
+}
+
+// realoca um vetor da AST, abortando se faltar memória
+static void* grow(void* array, size_t capacity, size_t element_size) {
+    void* p = realloc(array, capacity * element_size);
+    if (!p) ast_error();
+    return p;
+}
+
+static void reserve_nodes(Ast* ast, int needed) {
+    if (ast->count + needed <= ast->capacity) return;
+    int capacity = ast->capacity ? ast->capacity : AST_INITIAL_CAPACITY;
+    while (capacity < ast->count + needed) capacity *= 2;
+    ast->type = grow(ast->type, capacity, sizeof(uint8_t));
+    ast->value = grow(ast->value, capacity, sizeof(NameId));
+    ast->child = grow(ast->child, capacity, sizeof(AstId));
+    ast->sibling = grow(ast->sibling, capacity, sizeof(AstId));
+    ast->last_child = grow(ast->last_child, capacity, sizeof(AstId));
+    ast->scope = grow(ast->scope, capacity, sizeof(struct SymbolTable*));
+    ast->symbol = grow(ast->symbol, capacity, sizeof(struct SymbolNode*));
+    ast->data_type = grow(ast->data_type, capacity, sizeof(uint8_t));
+    ast->capacity = capacity;
+}
+
+Ast* ast_create(void) {
+    Ast* ast = (Ast*)calloc(1, sizeof(Ast));
+    if (!ast) ast_error();
+    reserve_nodes(ast, 1);
+
+    // o índice 0 (AST_NONE) fica reservado
+    ast->type[0] = NODE_PROGRAM;
+    ast->value[0] = NAME_NONE;
+    ast->child[0] = ast->sibling[0] = ast->last_child[0] = AST_NONE;
+    ast->scope[0] = NULL;
+    ast->symbol[0] = NULL;
+    ast->data_type[0] = AST_TYPE_UNKNOWN;
+    ast->count = 1;
+    return ast;
+}
+
+void ast_free(Ast* ast) {
+    if (!ast) return;
+    free(ast->type);
+    free(ast->value);
+    free(ast->child);
+    free(ast->sibling);
+    free(ast->last_child);
+    free(ast->scope);
+    free(ast->symbol);
+    free(ast->data_type);
+    free(ast);
+}
+
+// cria um novo nó no fim dos vetores
+AstId create_node(Ast* ast, NodeType type, NameId value) {
+    reserve_nodes(ast, 1);
+    AstId node = (AstId)ast->count++;
+    ast->type[node] = (uint8_t)type;
+    ast->value[node] = value;
+    ast->child[node] = AST_NONE;
+    ast->sibling[node] = AST_NONE;
+    ast->last_child[node] = AST_NONE;
+    ast->scope[node] = NULL;
+    ast->symbol[node] = NULL;
+    ast->data_type[node] = AST_TYPE_UNKNOWN;
     return node;
 }
 
-// adiciona um nó filho a um nó pai
-void add_child(ASTNode* parent, ASTNode* new_child) {
-    if (!parent || !new_child) return;
-    if (parent->child == NULL) {
-        parent->child = new_child;
+// adiciona um nó filho a um nó pai. o último filho fica guardado, então não
+// é preciso percorrer os irmãos.
+void add_child(Ast* ast, AstId parent, AstId new_child) {
+    if (parent == AST_NONE || new_child == AST_NONE) return;
+    if (ast->child[parent] == AST_NONE) {
+        ast->child[parent] = new_child;
     } else {
-        // se já tem filho, vai até o último irmão e adiciona o novo lá
-        ASTNode* current_sibling = parent->child;
-        while (current_sibling->sibling != NULL) {
-            current_sibling = current_sibling->sibling;
-        }
-        current_sibling->sibling = new_child;
+        ast->sibling[ast->last_child[parent]] = new_child;
     }
+    // new_child pode trazer irmãos junto; o último deles vira a cauda
+    AstId last = new_child;
+    while (ast->sibling[last] != AST_NONE) last = ast->sibling[last];
+    ast->last_child[parent] = last;
 }
 
-// libera toda a memória que a AST usou
-void free_ast(ASTNode* root) {
-    if (!root) return;
-    free_ast(root->sibling);
-    free_ast(root->child);
-    if (root->scope) {
-        scope_destroy(root->scope);
+// copia node e seus filhos de from para into. os filhos são criados antes
+// de serem ligados, então os índices de uma subárvore ficam contíguos.
+static AstId merge_node(Ast* into, const Ast* from, AstId node) {
+    AstId copy = create_node(into, ast_type(from, node), ast_name(from, node));
+    into->scope[copy] = from->scope[node];
+    into->symbol[copy] = from->symbol[node];
+    for (AstId c = from->child[node]; c != AST_NONE; c = from->sibling[c]) {
+        add_child(into, copy, merge_node(into, from, c));
     }
-    free(root->value);
-    free(root);
+    return copy;
+}
+
+AstId ast_merge(Ast* into, const Ast* from, AstId root) {
+    if (root == AST_NONE) return AST_NONE;
+    reserve_nodes(into, from->count);
+    return merge_node(into, from, root);
 }
 
-// imprime a AST
-void print_ast(ASTNode* node, int level) {
-    if (!node)
-      return;
+// imprime a AST em pré-ordem com uma pilha explícita: cada nó empilha o
+// irmão e depois o filho, então árvores fundas ou blocos enormes não gastam
+// a pilha de chamadas
+void print_ast(const Ast* ast, AstId node, int level) {
+    typedef struct {
+        AstId node;
+        int level;
+    } Pending;
+
+    int capacity = 64;
+    int count = 0;
+    Pending* stack = (Pending*)malloc(capacity * sizeof(Pending));
+    if (!stack) ast_error();
+    stack[count++] = (Pending){ node, level };
+
+    while (count > 0) {
+        Pending p = stack[--count];
+        if (p.node == AST_NONE)
+          continue;
 
-    for (int i = 0; i < level; i++)
-      printf("  ");
+        for (int i = 0; i < p.level; i++)
+          printf("  ");
 
-    printf("Tipo: %d", node->type); // Imprime o tipo do nó
-    if (node->value)
-      printf(", Valor: \"%s\"", node->value); // imprime se tiver valor
+        printf("Tipo: %d", ast_type(ast, p.node)); // Imprime o tipo do nó
+        if (ast_value(ast, p.node))
+          printf(", Valor: \"%s\"", ast_value(ast, p.node)); // imprime se tiver valor
 
-    printf("\n");
-    print_ast(node->child, level + 1);
-    print_ast(node->sibling, level);
+        printf("\n");
+        if (count + 2 > capacity) {
+            capacity *= 2;
+            stack = grow(stack, capacity, sizeof(Pending));
+        }
+        stack[count++] = (Pending){ ast_sibling(ast, p.node), p.level };
+        stack[count++] = (Pending){ ast_child(ast, p.node), p.level + 1 };
+    }
+    free(stack);
 }
@@ -0,0 +1,478 @@
+#include "bytecode.h"
+#include "types.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_REGISTERS 65535
+#define MAX_CODE_SIZE 65535
+
+// estado da tradução de uma função
+typedef struct {
+    BytecodeProgram* program;
+    const Ast* ast;
+    BytecodeFunction* fn;
+    int next_temp;          // primeiro registrador temporário livre
+} Compiler;
+
+static void bytecode_error(const char* message, const char* name) {
+    fprintf(stderr, "Erro de Geração de Código: %s", message);
+    if (name) fprintf(stderr, " ('%s')", name);
+    fprintf(stderr, ".\n");
+    exit(EXIT_FAILURE);
+}
+
+static int emit(Compiler* c, OpCode op, int a, int b, int arg_c) {
+    BytecodeFunction* fn = c->fn;
+    if (fn->code_count >= MAX_CODE_SIZE) bytecode_error("função grande demais para o bytecode", fn->name);
+    if (fn->code_count >= fn->code_capacity) {
+        fn->code_capacity = fn->code_capacity ? fn->code_capacity * 2 : 64;
+        fn->code = (Instruction*)realloc(fn->code, fn->code_capacity * sizeof(Instruction));
+        if (!fn->code) {
+            perror("Falha ao alocar bytecode");
+            exit(EXIT_FAILURE);
+        }
+    }
+    Instruction* in = &fn->code[fn->code_count];
+    in->op = (uint16_t)op;
+    in->a = (uint16_t)a;
+    in->b = (uint16_t)b;
+    in->c = (uint16_t)arg_c;
+    return fn->code_count++;
+}
+
+// corrige o destino de um salto emitido antes de conhecermos o alvo
+static void patch_jump(Compiler* c, int at, int target) {
+    c->fn->code[at].c = (uint16_t)target;
+}
+
+static int alloc_temp(Compiler* c) {
+    int reg = c->next_temp++;
+    if (reg >= MAX_REGISTERS) bytecode_error("registradores insuficientes", c->fn->name);
+    if (c->next_temp > c->fn->register_count) c->fn->register_count = c->next_temp;
+    return reg;
+}
+
+// variável ligada ao nó pelo parser
+static SymbolNode* node_variable(Compiler* c, AstId node) {
+    SymbolNode* sym = ast_symbol(c->ast, node);
+    if (sym->kind != KIND_VARIABLE && sym->kind != KIND_PARAMETER) {
+        bytecode_error("identificador não é uma variável", sym->name);
+    }
+    return sym;
+}
+
+// ---------------------------------------------------------------------------
+// constantes
+// ---------------------------------------------------------------------------
+
+static int is_literal(const Ast* ast, AstId node) {
+    return ast_type(ast, node) == NODE_INT_LITERAL || ast_type(ast, node) == NODE_FLOAT_LITERAL;
+}
+
+static Value literal_value(const Ast* ast, AstId node) {
+    Value v;
+    if (ast_type(ast, node) == NODE_INT_LITERAL) v.i = strtoll(ast_value(ast, node), NULL, 10);
+    else v.f = strtod(ast_value(ast, node), NULL);
+    return v;
+}
+
+// índice da constante na tabela da função, ou -1
+static int find_constant(BytecodeFunction* fn, Value v) {
+    for (int i = 0; i < fn->constant_count; i++) {
+        if (memcmp(&fn->constants[i], &v, sizeof(Value)) == 0) return i;
+    }
+    return -1;
+}
+
+static void add_constant(BytecodeFunction* fn, Value v, int* capacity) {
+    if (find_constant(fn, v) >= 0) return;
+    if (fn->constant_count >= *capacity) {
+        *capacity = *capacity ? *capacity * 2 : 8;
+        fn->constants = (Value*)realloc(fn->constants, *capacity * sizeof(Value));
+    }
+    fn->constants[fn->constant_count++] = v;
+}
+
+static Value zero_value(void) {
+    Value v;
+    memset(&v, 0, sizeof(Value));
+    return v;
+}
+
+// junta os literais da função antes de gerar código, para que as constantes
+// fiquem em registradores fixos logo depois das variáveis. as declarações
+// zeram a variável, então também usam o zero.
+static void collect_constants(const Ast* ast, BytecodeFunction* fn, AstId node, int* capacity) {
+    for (; node; node = ast_sibling(ast, node)) {
+        if (is_literal(ast, node)) add_constant(fn, literal_value(ast, node), capacity);
+        else if (ast_type(ast, node) == NODE_DECLARATION) add_constant(fn, zero_value(), capacity);
+        collect_constants(ast, fn, ast_child(ast, node), capacity);
+    }
+}
+
+static int constant_register(Compiler* c, AstId node) {
+    return c->fn->local_count + find_constant(c->fn, literal_value(c->ast, node));
+}
+
+// ---------------------------------------------------------------------------
+// expressões
+// ---------------------------------------------------------------------------
+
+static int compile_expr(Compiler* c, AstId node, int want);
+
+// compila uma expressão convertendo o resultado para o tipo pedido
+static int compile_expr_as(Compiler* c, AstId node, SymbolDataType type, int want) {
+    SymbolDataType actual = expr_type(c->ast, node);
+    if (actual == type) return compile_expr(c, node, want);
+
+    int saved = c->next_temp;
+    int reg = compile_expr(c, node, -1);
+    c->next_temp = saved;
+    int dst = want >= 0 ? want : alloc_temp(c);
+    emit(c, type == TYPE_FLOAT ? OP_I2F : OP_F2I, dst, reg, 0);
+    return dst;
+}
+
+static int compile_call(Compiler* c, AstId node, int want) {
+    // as funções estão na ordem de declaração, a mesma de symbol->order
+    int index = ast_symbol(c->ast, node)->order;
+    BytecodeFunction* callee = &c->program->functions[index];
+
+    AstId args = ast_child(c->ast, node) ? ast_child(c->ast, ast_child(c->ast, node)) : AST_NONE;
+    int argc = 0;
+    for (AstId a = args; a; a = ast_sibling(c->ast, a)) argc++;
+    if (argc != callee->param_count) bytecode_error("número de argumentos incorreto na chamada", ast_value(c->ast, node));
+
+    // os argumentos ficam em registradores consecutivos
+    int saved = c->next_temp;
+    int base = c->next_temp;
+    for (int i = 0; i < argc; i++) alloc_temp(c);
+    int i = 0;
+    for (AstId a = args; a; a = ast_sibling(c->ast, a), i++) {
+        compile_expr_as(c, a, callee->param_types[i], base + i);
+    }
+    c->next_temp = saved;
+    int dst = want >= 0 ? want : alloc_temp(c);
+    emit(c, OP_CALL, dst, index, base);
+    return dst;
+}
+
+static int compile_expr(Compiler* c, AstId node, int want) {
+    switch (ast_type(c->ast, node)) {
+        case NODE_INT_LITERAL:
+        case NODE_FLOAT_LITERAL:
+        case NODE_IDENTIFIER: {
+            int reg = ast_type(c->ast, node) == NODE_IDENTIFIER ? node_variable(c, node)->address
+                                                    : constant_register(c, node);
+            if (want >= 0 && want != reg) {
+                emit(c, OP_MOVE, want, reg, 0);
+                return want;
+            }
+            return reg;
+        }
+
+        case NODE_FUNC_CALL:
+            return compile_call(c, node, want);
+
+        case NODE_NEGATE: {
+            SymbolDataType type = expr_type(c->ast, node);
+            int saved = c->next_temp;
+            int operand = compile_expr(c, ast_child(c->ast, node), -1);
+            c->next_temp = saved;
+            int dst = want >= 0 ? want : alloc_temp(c);
+            emit(c, type == TYPE_FLOAT ? OP_NEGF : OP_NEGI, dst, operand, 0);
+            return dst;
+        }
+
+        default: break;
+    }
+
+    AstId left = ast_child(c->ast, node);
+    AstId right = left ? ast_sibling(c->ast, left) : AST_NONE;
+    if (!left || !right) bytecode_error("expressão inválida", ast_value(c->ast, node));
+
+    // comparações usam o tipo dos operandos, aritmética o tipo do resultado
+    SymbolDataType type;
+    if (is_comparison(ast_type(c->ast, node))) {
+        type = operand_type(c->ast, node);
+    } else {
+        type = expr_type(c->ast, node);
+    }
+    int is_float = type == TYPE_FLOAT;
+
+    int saved = c->next_temp;
+    int l = compile_expr_as(c, left, type, -1);
+    int r = compile_expr_as(c, right, type, -1);
+    c->next_temp = saved;
+    int dst = want >= 0 ? want : alloc_temp(c);
+
+    switch (ast_type(c->ast, node)) {
+        case NODE_ADD: emit(c, is_float ? OP_ADDF : OP_ADDI, dst, l, r); break;
+        case NODE_SUB: emit(c, is_float ? OP_SUBF : OP_SUBI, dst, l, r); break;
+        case NODE_MUL: emit(c, is_float ? OP_MULF : OP_MULI, dst, l, r); break;
+        case NODE_DIV: emit(c, is_float ? OP_DIVF : OP_DIVI, dst, l, r); break;
+        case NODE_EQ:  emit(c, is_float ? OP_EQF : OP_EQI, dst, l, r); break;
+        case NODE_NEQ: emit(c, is_float ? OP_NEF : OP_NEI, dst, l, r); break;
+        case NODE_LT:  emit(c, is_float ? OP_LTF : OP_LTI, dst, l, r); break;
+        case NODE_LTE: emit(c, is_float ? OP_LEF : OP_LEI, dst, l, r); break;
+        // a > b é b < a
+        case NODE_GT:  emit(c, is_float ? OP_LTF : OP_LTI, dst, r, l); break;
+        case NODE_GTE: emit(c, is_float ? OP_LEF : OP_LEI, dst, r, l); break;
+        default: bytecode_error("operador desconhecido", ast_value(c->ast, node));
+    }
+    return dst;
+}
+
+// emite um salto para `target` (corrigido depois) tomado quando a condição
+// for igual a `when`. comparações viram uma única instrução de comparar e saltar.
+static int compile_branch(Compiler* c, AstId cond, int when) {
+    int saved = c->next_temp;
+    int at;
+    if (is_comparison(ast_type(c->ast, cond))) {
+        AstId left = ast_child(c->ast, cond);
+        AstId right = ast_sibling(c->ast, left);
+        SymbolDataType type = operand_type(c->ast, cond);
+        int l = compile_expr_as(c, left, type, -1);
+        int r = compile_expr_as(c, right, type, -1);
+
+        // reduz GT/GTE trocando os operandos
+        NodeType op = ast_type(c->ast, cond);
+        if (op == NODE_GT) { op = NODE_LT; int t = l; l = r; r = t; }
+        if (op == NODE_GTE) { op = NODE_LTE; int t = l; l = r; r = t; }
+
+        OpCode code;
+        if (type == TYPE_INTEGER) {
+            // para inteiros, !(a < b) é b <= a
+            switch (op) {
+                case NODE_EQ:  code = when ? OP_JEQI : OP_JNEI; break;
+                case NODE_NEQ: code = when ? OP_JNEI : OP_JEQI; break;
+                case NODE_LT:
+                    if (when) code = OP_JLTI;
+                    else { code = OP_JLEI; int t = l; l = r; r = t; }
+                    break;
+                default: // NODE_LTE
+                    if (when) code = OP_JLEI;
+                    else { code = OP_JLTI; int t = l; l = r; r = t; }
+                    break;
+            }
+        } else {
+            switch (op) {
+                case NODE_EQ:  code = when ? OP_JEQF : OP_JNEF; break;
+                case NODE_NEQ: code = when ? OP_JNEF : OP_JEQF; break;
+                case NODE_LT:  code = when ? OP_JLTF : OP_JNLTF; break;
+                default:       code = when ? OP_JLEF : OP_JNLEF; break;
+            }
+        }
+        at = emit(c, code, l, r, 0);
+    } else {
+        int is_float = expr_type(c->ast, cond) == TYPE_FLOAT;
+        int reg = compile_expr(c, cond, -1);
+        if (is_float) at = emit(c, when ? OP_JMPTF : OP_JMPFF, reg, 0, 0);
+        else at = emit(c, when ? OP_JMPT : OP_JMPF, reg, 0, 0);
+    }
+    c->next_temp = saved;
+    return at;
+}
+
+// ---------------------------------------------------------------------------
+// instruções
+// ---------------------------------------------------------------------------
+
+static void compile_block(Compiler* c, AstId block);
+
+static void compile_assignment(Compiler* c, AstId node, AstId expr) {
+    SymbolNode* sym = node_variable(c, node);
+    int saved = c->next_temp;
+    compile_expr_as(c, expr, sym->type, sym->address);
+    c->next_temp = saved;
+}
+
+static void compile_statement(Compiler* c, AstId node) {
+    switch (ast_type(c->ast, node)) {
+        case NODE_DECLARATION:
+            // variáveis começam valendo zero (também quando a declaração
+            // está dentro de um laço)
+            emit(c, OP_MOVE, node_variable(c, node)->address, c->fn->local_count + find_constant(c->fn, zero_value()), 0);
+            break;
+
+        case NODE_DECL_ASSIGN:
+            // a declaração zera a variável antes de a expressão ser avaliada
+            compile_statement(c, ast_child(c->ast, node));
+            compile_statement(c, ast_sibling(c->ast, ast_child(c->ast, node)));
+            break;
+
+        case NODE_ASSIGNMENT:
+            compile_assignment(c, node, ast_child(c->ast, node));
+            break;
+
+        case NODE_BLOCK:
+            compile_block(c, node);
+            break;
+
+        case NODE_CONDITIONAL: {
+            AstId cond = ast_child(c->ast, node);
+            AstId then_block = ast_sibling(c->ast, cond);
+            AstId else_block = ast_sibling(c->ast, then_block);
+            int skip_then = compile_branch(c, cond, 0);
+            compile_block(c, then_block);
+            if (else_block) {
+                int skip_else = emit(c, OP_JMP, 0, 0, 0);
+                patch_jump(c, skip_then, c->fn->code_count);
+                compile_block(c, else_block);
+                patch_jump(c, skip_else, c->fn->code_count);
+            } else {
+                patch_jump(c, skip_then, c->fn->code_count);
+            }
+            break;
+        }
+
+        case NODE_LOOP: {
+            // o teste fica no fim do laço: uma só instrução de desvio por volta
+            int to_test = emit(c, OP_JMP, 0, 0, 0);
+            int body = c->fn->code_count;
+            compile_block(c, ast_sibling(c->ast, ast_child(c->ast, node)));
+            patch_jump(c, to_test, c->fn->code_count);
+            int back = compile_branch(c, ast_child(c->ast, node), 1);
+            patch_jump(c, back, body);
+            break;
+        }
+
+        case NODE_RETURN_STMT: {
+            int saved = c->next_temp;
+            int reg = compile_expr_as(c, ast_child(c->ast, node), c->fn->return_type, -1);
+            emit(c, OP_RET, reg, 0, 0);
+            c->next_temp = saved;
+            break;
+        }
+
+        case NODE_PRINT: {
+            AstId args = ast_child(c->ast, ast_child(c->ast, node));
+            if (!args) {
+                emit(c, OP_PRINTNL, 0, 0, 0);
+                break;
+            }
+            for (AstId a = args; a; a = ast_sibling(c->ast, a)) {
+                int saved = c->next_temp;
+                int is_float = expr_type(c->ast, a) == TYPE_FLOAT;
+                int reg = compile_expr(c, a, -1);
+                emit(c, is_float ? OP_PRINTF : OP_PRINTI, reg, ast_sibling(c->ast, a) == AST_NONE, 0);
+                c->next_temp = saved;
+            }
+            break;
+        }
+
+        case NODE_SCAN:
+            for (AstId a = ast_child(c->ast, ast_child(c->ast, node)); a; a = ast_sibling(c->ast, a)) {
+                if (ast_type(c->ast, a) != NODE_IDENTIFIER) bytecode_error("scan espera variáveis como argumento", ast_value(c->ast, a));
+                SymbolNode* sym = node_variable(c, a);
+                emit(c, sym->type == TYPE_FLOAT ? OP_SCANF : OP_SCANI, sym->address, 0, 0);
+            }
+            break;
+
+        case NODE_FUNC_CALL: {
+            int saved = c->next_temp;
+            compile_call(c, node, -1);
+            c->next_temp = saved;
+            break;
+        }
+
+        default:
+            bytecode_error("instrução não suportada", ast_value(c->ast, node));
+    }
+}
+
+static void compile_block(Compiler* c, AstId block) {
+    for (AstId stmt = ast_child(c->ast, block); stmt; stmt = ast_sibling(c->ast, stmt)) {
+        compile_statement(c, stmt);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// funções
+// ---------------------------------------------------------------------------
+
+static void compile_function(Compiler* c, BytecodeFunction* fn, SymbolTable* scope, AstId body) {
+    int capacity = 0;
+    c->fn = fn;
+    fn->local_count = scope_frame_size(scope);
+    collect_constants(c->ast, fn, body, &capacity);
+    fn->register_count = fn->local_count + fn->constant_count;
+    if (fn->register_count >= MAX_REGISTERS) bytecode_error("registradores insuficientes", fn->name);
+    c->next_temp = fn->register_count;
+
+    compile_block(c, body);
+    emit(c, OP_RETZ, 0, 0, 0);
+}
+
+BytecodeProgram* bytecode_compile(const Ast* ast, SymbolTable* global_scope) {
+    AstId root = ast->root;
+    BytecodeProgram* program = (BytecodeProgram*)calloc(1, sizeof(BytecodeProgram));
+    int count = 0;
+    for (AstId n = ast_child(ast, root); n; n = ast_sibling(ast, n)) count++;
+    program->functions = (BytecodeFunction*)calloc(count ? count : 1, sizeof(BytecodeFunction));
+    program->function_count = count;
+    program->entry = -1;
+
+    Compiler compiler = { program, ast, NULL, 0 };
+    Compiler* c = &compiler;
+
+    // primeiro registra as assinaturas, para que as chamadas saibam os tipos
+    int i = 0;
+    for (AstId n = ast_child(ast, root); n; n = ast_sibling(ast, n), i++) {
+        BytecodeFunction* fn = &program->functions[i];
+        if (ast_type(ast, n) == NODE_FUNC_DECL) {
+            SymbolNode* sym = ast_symbol(ast, n);
+            fn->name = strdup(ast_value(ast, n));
+            fn->return_type = sym ? sym->type : TYPE_INTEGER;
+            AstId params = ast_child(ast, n);
+            for (AstId p = ast_child(ast, params); p; p = ast_sibling(ast, p)) fn->param_count++;
+            fn->param_types = (SymbolDataType*)malloc((fn->param_count ? fn->param_count : 1) * sizeof(SymbolDataType));
+            int j = 0;
+            for (AstId p = ast_child(ast, params); p; p = ast_sibling(ast, p), j++) {
+                SymbolNode* param = ast_symbol(ast, p);
+                // a VM copia os argumentos para os registradores 1..param_count
+                if (param->address != j + 1) bytecode_error("endereço de parâmetro inesperado", ast_value(ast, p));
+                fn->param_types[j] = param->type;
+            }
+            if (strcmp(fn->name, "main") == 0 && program->entry < 0) program->entry = i;
+        } else {
+            // bloco principal do programa
+            fn->name = strdup("<principal>");
+            fn->return_type = TYPE_INTEGER;
+            program->entry = i;
+        }
+    }
+
+    i = 0;
+    for (AstId n = ast_child(ast, root); n; n = ast_sibling(ast, n), i++) {
+        if (ast_type(ast, n) == NODE_FUNC_DECL) compile_function(c, &program->functions[i], ast_scope(ast, n), ast_sibling(ast, ast_child(ast, n)));
+        else compile_function(c, &program->functions[i], global_scope, n);
+    }
+
+    if (program->entry < 0) bytecode_error("programa sem bloco principal nem função", "main");
+    return program;
+}
+
+void bytecode_free(BytecodeProgram* program) {
+    if (!program) return;
+    for (int i = 0; i < program->function_count; i++) {
+        BytecodeFunction* fn = &program->functions[i];
+        free(fn->name);
+        free(fn->param_types);
+        free(fn->code);
+        free(fn->constants);
+    }
+    free(program->functions);
+    free(program);
+}
+
+const char* opcode_to_string(OpCode op) {
+    static const char* names[] = {
+#define BYTECODE_NAME(name) #name,
+        BYTECODE_OPS(BYTECODE_NAME)
+#undef BYTECODE_NAME
+    };
+    if (op < 0 || op >= OP_COUNT) return "INVALID_OPCODE";
+    return names[op];
+}
@@ -0,0 +1,961 @@
+#include "codegen.h"
+#include "types.h"
+#include "diagnostic.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// registradores preservados entre chamadas: as variáveis inteiras que
+// ficam neles sobrevivem às chamadas sem precisar salvar nada
+#define ALLOCATABLE_REGISTERS 5
+static const char* callee_saved[ALLOCATABLE_REGISTERS] = { "%rbx", "%r12", "%r13", "%r14", "%r15" };
+
+#define MAX_INT_ARGS 6
+#define MAX_FLOAT_ARGS 8
+static const char* int_arg_registers[MAX_INT_ARGS] = { "%rdi", "%rsi", "%rdx", "%rcx", "%r8", "%r9" };
+
+// onde uma variável mora durante a função
+typedef struct {
+    int reg;            // índice em callee_saved, ou -1 se estiver na pilha
+    char operand[24];   // texto do operando: "%rbx" ou "-16(%rbp)"
+} Location;
+
+// intervalo de vida de uma variável inteira, em posições da AST
+typedef struct {
+    int address;
+    int start;
+    int end;
+} Interval;
+
+// assinatura de uma função do programa
+typedef struct {
+    const char* name;
+    AstId decl;
+    SymbolDataType return_type;
+    int param_count;
+    SymbolDataType* param_types;
+} FunctionInfo;
+
+typedef struct {
+    FILE* out;
+    const Ast* ast;
+    FunctionInfo* functions;
+    int function_count;
+
+    // função atual
+    SymbolTable* scope;
+    SymbolDataType return_type;
+    Location* locals;       // indexado pelo endereço do símbolo
+    int local_count;
+    int used_registers;     // quantos registradores preservados são salvos
+    int return_label;
+    int depth;              // quantos valores de 8 bytes foram empilhados
+
+    int label_count;
+    double* float_constants;
+    int float_count;
+    int float_capacity;
+    int uses_sign_mask;
+} CodeGen;
+
+static void codegen_error(const char* message, const char* name) {
+    if (name) compile_error("Erro de Geração de Código: %s ('%s').", message, name);
+    compile_error("Erro de Geração de Código: %s.", message);
+}
+
+static int new_label(CodeGen* g) {
+    return g->label_count++;
+}
+
+static FunctionInfo* find_function(CodeGen* g, NameId name) {
+    for (int i = 0; i < g->function_count; i++) {
+        if (ast_name(g->ast, g->functions[i].decl) == name) return &g->functions[i];
+    }
+    codegen_error("função desconhecida", intern_name(name));
+    return NULL;
+}
+
+// variável ligada ao nó pelo parser
+static SymbolNode* node_variable(CodeGen* g, AstId node) {
+    SymbolNode* sym = ast_symbol(g->ast, node);
+    if (sym->kind != KIND_VARIABLE && sym->kind != KIND_PARAMETER) {
+        codegen_error("identificador não é uma variável", sym->name);
+    }
+    return sym;
+}
+
+static const char* variable_operand(CodeGen* g, AstId node) {
+    return g->locals[node_variable(g, node)->address].operand;
+}
+
+// índice da constante float no .rodata (rótulo .LCF<índice>)
+static int float_constant(CodeGen* g, double value) {
+    for (int i = 0; i < g->float_count; i++) {
+        if (memcmp(&g->float_constants[i], &value, sizeof(double)) == 0) return i;
+    }
+    if (g->float_count >= g->float_capacity) {
+        g->float_capacity = g->float_capacity ? g->float_capacity * 2 : 16;
+        g->float_constants = (double*)realloc(g->float_constants, g->float_capacity * sizeof(double));
+    }
+    g->float_constants[g->float_count] = value;
+    return g->float_count++;
+}
+
+// ---------------------------------------------------------------------------
+// alocação de registradores por varredura linear
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    CodeGen* g;
+    Interval* intervals;    // indexado pelo endereço
+    int position;
+} LivenessScan;
+
+static void touch(LivenessScan* s, SymbolNode* sym) {
+    if (!sym || (sym->kind != KIND_VARIABLE && sym->kind != KIND_PARAMETER)) return;
+    Interval* it = &s->intervals[sym->address];
+    if (it->start < 0) it->start = s->position;
+    it->end = s->position;
+    s->position++;
+}
+
+// numera os usos das variáveis na ordem do código. uma variável usada dentro
+// de um laço fica viva durante o laço inteiro, pois o valor volta pelo desvio.
+static void compute_intervals(LivenessScan* s, AstId node) {
+    for (; node; node = ast_sibling(s->g->ast, node)) {
+        switch (ast_type(s->g->ast, node)) {
+            case NODE_LOOP: {
+                int loop_start = s->position++;
+                compute_intervals(s, ast_child(s->g->ast, node));
+                int loop_end = s->position++;
+                for (int i = 0; i < s->g->local_count; i++) {
+                    Interval* it = &s->intervals[i];
+                    if (it->start >= 0 && it->start <= loop_end && it->end >= loop_start) {
+                        if (it->start > loop_start) it->start = loop_start;
+                        if (it->end < loop_end) it->end = loop_end;
+                    }
+                }
+                break;
+            }
+            case NODE_IDENTIFIER:
+            case NODE_ASSIGNMENT:
+            case NODE_DECLARATION:
+                compute_intervals(s, ast_child(s->g->ast, node));
+                touch(s, ast_symbol(s->g->ast, node));
+                break;
+            default:
+                compute_intervals(s, ast_child(s->g->ast, node));
+                break;
+        }
+    }
+}
+
+static int compare_start(const void* a, const void* b) {
+    const Interval* x = (const Interval*)a;
+    const Interval* y = (const Interval*)b;
+    if (x->start != y->start) return x->start - y->start;
+    return x->address - y->address;
+}
+
+// decide o lugar de cada variável: inteiros disputam os registradores
+// preservados pela varredura linear, floats e derramados vão para a pilha
+static int allocate_locals(CodeGen* g, AstId params, AstId body) {
+    Interval* intervals = (Interval*)malloc((g->local_count ? g->local_count : 1) * sizeof(Interval));
+    for (int i = 0; i < g->local_count; i++) {
+        intervals[i].address = i;
+        intervals[i].start = -1;
+        intervals[i].end = -1;
+        g->locals[i].reg = -1;
+    }
+
+    LivenessScan scan = { g, intervals, 0 };
+    // parâmetros chegam vivos na entrada da função
+    for (AstId p = params; p; p = ast_sibling(g->ast, p)) touch(&scan, ast_symbol(g->ast, p));
+    compute_intervals(&scan, body);
+
+    // só inteiros disputam registradores
+    int* is_int = (int*)calloc(g->local_count ? g->local_count : 1, sizeof(int));
+    for (SymbolNode* sym = g->scope->first; sym; sym = sym->next) {
+        if ((sym->kind == KIND_VARIABLE || sym->kind == KIND_PARAMETER) && sym->type == TYPE_INTEGER) {
+            is_int[sym->address] = 1;
+        }
+    }
+    Interval* sorted = (Interval*)malloc((g->local_count ? g->local_count : 1) * sizeof(Interval));
+    int count = 0;
+    for (int i = 0; i < g->local_count; i++) {
+        if (intervals[i].start >= 0 && is_int[i]) sorted[count++] = intervals[i];
+    }
+    free(is_int);
+    qsort(sorted, count, sizeof(Interval), compare_start);
+
+    Interval* active[ALLOCATABLE_REGISTERS];
+    int active_count = 0;
+    int in_use[ALLOCATABLE_REGISTERS] = { 0 };
+    int used = 0;
+    for (int i = 0; i < count; i++) {
+        Interval* current = &sorted[i];
+
+        // libera os registradores de intervalos que já terminaram
+        for (int j = 0; j < active_count;) {
+            if (active[j]->end < current->start) {
+                in_use[g->locals[active[j]->address].reg] = 0;
+                active[j] = active[--active_count];
+            } else {
+                j++;
+            }
+        }
+
+        if (active_count == ALLOCATABLE_REGISTERS) {
+            // derrama quem termina mais tarde
+            int victim = 0;
+            for (int j = 1; j < active_count; j++) {
+                if (active[j]->end > active[victim]->end) victim = j;
+            }
+            if (active[victim]->end > current->end) {
+                g->locals[current->address].reg = g->locals[active[victim]->address].reg;
+                g->locals[active[victim]->address].reg = -1;
+                active[victim] = current;
+            }
+            continue;
+        }
+
+        int reg = 0;
+        while (in_use[reg]) reg++;
+        in_use[reg] = 1;
+        if (reg + 1 > used) used = reg + 1;
+        g->locals[current->address].reg = reg;
+        active[active_count++] = current;
+    }
+    free(sorted);
+
+    // o restante ganha uma posição na pilha, abaixo dos registradores salvos
+    g->used_registers = used;
+    int slots = 0;
+    for (int i = 0; i < g->local_count; i++) {
+        Location* loc = &g->locals[i];
+        if (loc->reg >= 0) {
+            snprintf(loc->operand, sizeof(loc->operand), "%s", callee_saved[loc->reg]);
+        } else if (intervals[i].start >= 0) {
+            slots++;
+            snprintf(loc->operand, sizeof(loc->operand), "%d(%%rbp)", -8 * (used + slots));
+        }
+    }
+    free(intervals);
+
+    // mantém a pilha alinhada em 16 bytes depois do prólogo
+    int frame = 8 * slots;
+    if ((8 * used + frame) % 16 != 0) frame += 8;
+    return frame;
+}
+
+// ---------------------------------------------------------------------------
+// expressões: inteiros terminam em %rax, floats em %xmm0
+// ---------------------------------------------------------------------------
+
+static void gen_int(CodeGen* g, AstId e);
+static void gen_float(CodeGen* g, AstId e);
+
+static int is_memory(const char* operand) {
+    return operand[0] != '%' && operand[0] != '$';
+}
+
+// operando que pode ir direto na instrução: imediato de 32 bits ou variável inteira
+static int int_operand(CodeGen* g, AstId e, char* buf, size_t size) {
+    if (ast_type(g->ast, e) == NODE_INT_LITERAL) {
+        long long v = strtoll(ast_value(g->ast, e), NULL, 10);
+        if (v < INT32_MIN || v > INT32_MAX) return 0;
+        snprintf(buf, size, "$%lld", v);
+        return 1;
+    }
+    if (ast_type(g->ast, e) == NODE_IDENTIFIER && node_variable(g, e)->type == TYPE_INTEGER) {
+        snprintf(buf, size, "%s", variable_operand(g, e));
+        return 1;
+    }
+    return 0;
+}
+
+// operando float que pode ir direto na instrução: constante ou variável float
+static int float_operand(CodeGen* g, AstId e, char* buf, size_t size) {
+    if (ast_type(g->ast, e) == NODE_FLOAT_LITERAL) {
+        snprintf(buf, size, ".LCF%d(%%rip)", float_constant(g, strtod(ast_value(g->ast, e), NULL)));
+        return 1;
+    }
+    if (ast_type(g->ast, e) == NODE_IDENTIFIER && node_variable(g, e)->type == TYPE_FLOAT) {
+        snprintf(buf, size, "%s", variable_operand(g, e));
+        return 1;
+    }
+    return 0;
+}
+
+static void push_int(CodeGen* g) {
+    fprintf(g->out, "\tpushq %%rax\n");
+    g->depth++;
+}
+
+static void pop_int(CodeGen* g, const char* reg) {
+    fprintf(g->out, "\tpopq %s\n", reg);
+    g->depth--;
+}
+
+static void push_float(CodeGen* g) {
+    fprintf(g->out, "\tsubq $8, %%rsp\n\tmovsd %%xmm0, (%%rsp)\n");
+    g->depth++;
+}
+
+static void pop_float(CodeGen* g, const char* reg) {
+    fprintf(g->out, "\tmovsd (%%rsp), %s\n\taddq $8, %%rsp\n", reg);
+    g->depth--;
+}
+
+// chama uma função com a pilha alinhada em 16 bytes
+static void emit_call(CodeGen* g, const char* target) {
+    if (g->depth % 2) fprintf(g->out, "\tsubq $8, %%rsp\n");
+    fprintf(g->out, "\tcall %s\n", target);
+    if (g->depth % 2) fprintf(g->out, "\taddq $8, %%rsp\n");
+}
+
+// avalia a expressão convertendo para o tipo pedido
+static void gen_value(CodeGen* g, AstId e, SymbolDataType type) {
+    if (type == TYPE_FLOAT) {
+        gen_float(g, e);
+    } else if (expr_type(g->ast, e) == TYPE_FLOAT) {
+        gen_float(g, e);
+        fprintf(g->out, "\tcvttsd2siq %%xmm0, %%rax\n");
+    } else {
+        gen_int(g, e);
+    }
+}
+
+static void gen_call(CodeGen* g, AstId e) {
+    // as funções estão na ordem de declaração, a mesma de symbol->order
+    FunctionInfo* callee = &g->functions[ast_symbol(g->ast, e)->order];
+    AstId args = ast_child(g->ast, e) ? ast_child(g->ast, ast_child(g->ast, e)) : AST_NONE;
+    int argc = 0;
+    for (AstId a = args; a; a = ast_sibling(g->ast, a)) argc++;
+    if (argc != callee->param_count) codegen_error("número de argumentos incorreto na chamada", ast_value(g->ast, e));
+
+    // os que não cabem nos registradores vão pela pilha (System V)
+    int ints = 0, floats = 0, stacked = 0;
+    for (int i = 0; i < argc; i++) {
+        if (callee->param_types[i] == TYPE_FLOAT) stacked += floats++ >= MAX_FLOAT_ARGS;
+        else stacked += ints++ >= MAX_INT_ARGS;
+    }
+
+    // avalia todos os argumentos na pilha; o argumento i fica em
+    // 8 * (argc - 1 - i + above)(%rsp), com above valores empilhados depois
+    int i = 0;
+    for (AstId a = args; a; a = ast_sibling(g->ast, a), i++) {
+        gen_value(g, a, callee->param_types[i]);
+        if (callee->param_types[i] == TYPE_FLOAT) push_float(g);
+        else push_int(g);
+    }
+    int above = 0;
+    if ((g->depth + stacked) % 2) {
+        // a pilha precisa estar alinhada em 16 bytes na chamada
+        fprintf(g->out, "\tsubq $8, %%rsp\n");
+        above++;
+    }
+
+    // copia os argumentos da pilha da direita para a esquerda, e o primeiro
+    // deles fica em (%rsp)
+    int int_index = ints, float_index = floats;
+    for (i = argc - 1; i >= 0; i--) {
+        int on_stack = callee->param_types[i] == TYPE_FLOAT ? --float_index >= MAX_FLOAT_ARGS : --int_index >= MAX_INT_ARGS;
+        if (!on_stack) continue;
+        fprintf(g->out, "\tpushq %d(%%rsp)\n", 8 * (argc - 1 - i + above));
+        above++;
+    }
+    for (i = argc - 1; i >= 0; i--) {
+        int offset = 8 * (argc - 1 - i + above);
+        if (callee->param_types[i] == TYPE_FLOAT) {
+            if (--floats < MAX_FLOAT_ARGS) fprintf(g->out, "\tmovsd %d(%%rsp), %%xmm%d\n", offset, floats);
+        } else if (--ints < MAX_INT_ARGS) {
+            fprintf(g->out, "\tmovq %d(%%rsp), %s\n", offset, int_arg_registers[ints]);
+        }
+    }
+    fprintf(g->out, "\tcall lang_%s\n", callee->name);
+    fprintf(g->out, "\taddq $%d, %%rsp\n", 8 * (argc + above));
+    g->depth -= argc;
+}
+
+static const char* int_condition(NodeType type) {
+    switch (type) {
+        case NODE_EQ: return "e";
+        case NODE_NEQ: return "ne";
+        case NODE_LT: return "l";
+        case NODE_LTE: return "le";
+        case NODE_GT: return "g";
+        default: return "ge";
+    }
+}
+
+static const char* negate_condition(const char* cc) {
+    if (strcmp(cc, "e") == 0) return "ne";
+    if (strcmp(cc, "ne") == 0) return "e";
+    if (strcmp(cc, "l") == 0) return "ge";
+    if (strcmp(cc, "ge") == 0) return "l";
+    if (strcmp(cc, "le") == 0) return "g";
+    return "le";
+}
+
+// compara dois inteiros deixando o resultado nas flags (esquerda - direita)
+static void gen_int_compare(CodeGen* g, AstId left, AstId right) {
+    char l[32], r[32];
+    if (ast_type(g->ast, left) == NODE_IDENTIFIER && int_operand(g, left, l, sizeof(l)) && int_operand(g, right, r, sizeof(r)) &&
+        !(is_memory(l) && is_memory(r))) {
+        fprintf(g->out, "\tcmpq %s, %s\n", r, l);
+        return;
+    }
+    gen_int(g, left);
+    if (int_operand(g, right, r, sizeof(r))) {
+        fprintf(g->out, "\tcmpq %s, %%rax\n", r);
+        return;
+    }
+    push_int(g);
+    gen_int(g, right);
+    fprintf(g->out, "\tmovq %%rax, %%rcx\n");
+    pop_int(g, "%rax");
+    fprintf(g->out, "\tcmpq %%rcx, %%rax\n");
+}
+
+// coloca o operando esquerdo em %xmm0 e o direito em %xmm1
+static void gen_float_operands(CodeGen* g, AstId left, AstId right) {
+    gen_float(g, left);
+    char r[32];
+    if (float_operand(g, right, r, sizeof(r))) {
+        fprintf(g->out, "\tmovsd %s, %%xmm1\n", r);
+        return;
+    }
+    push_float(g);
+    gen_float(g, right);
+    fprintf(g->out, "\tmovapd %%xmm0, %%xmm1\n");
+    pop_float(g, "%xmm0");
+}
+
+// compara floats para a condição `type`. depois disso a condição vale quando
+// "a" (acima) ou "ae" for verdadeiro; comparações sem ordem (NaN) dão falso.
+// devolve o sufixo a usar, ou NULL para == e != (que precisam da paridade)
+static const char* gen_float_compare(CodeGen* g, NodeType type, AstId left, AstId right) {
+    gen_float_operands(g, left, right);
+    switch (type) {
+        case NODE_GT: fprintf(g->out, "\tucomisd %%xmm1, %%xmm0\n"); return "a";
+        case NODE_GTE: fprintf(g->out, "\tucomisd %%xmm1, %%xmm0\n"); return "ae";
+        case NODE_LT: fprintf(g->out, "\tucomisd %%xmm0, %%xmm1\n"); return "a";
+        case NODE_LTE: fprintf(g->out, "\tucomisd %%xmm0, %%xmm1\n"); return "ae";
+        default: fprintf(g->out, "\tucomisd %%xmm1, %%xmm0\n"); return NULL;
+    }
+}
+
+static void gen_comparison_value(CodeGen* g, AstId e) {
+    AstId left = ast_child(g->ast, e);
+    AstId right = ast_sibling(g->ast, left);
+    if (operand_type(g->ast, e) == TYPE_INTEGER) {
+        gen_int_compare(g, left, right);
+        fprintf(g->out, "\tset%s %%al\n", int_condition(ast_type(g->ast, e)));
+    } else {
+        const char* cc = gen_float_compare(g, ast_type(g->ast, e), left, right);
+        if (cc) {
+            fprintf(g->out, "\tset%s %%al\n", cc);
+        } else if (ast_type(g->ast, e) == NODE_EQ) {
+            fprintf(g->out, "\tsete %%al\n\tsetnp %%cl\n\tandb %%cl, %%al\n");
+        } else {
+            fprintf(g->out, "\tsetne %%al\n\tsetp %%cl\n\torb %%cl, %%al\n");
+        }
+    }
+    fprintf(g->out, "\tmovzbl %%al, %%eax\n");
+}
+
+static void gen_int(CodeGen* g, AstId e) {
+    char r[32];
+    switch (ast_type(g->ast, e)) {
+        case NODE_INT_LITERAL: {
+            long long v = strtoll(ast_value(g->ast, e), NULL, 10);
+            if (v >= INT32_MIN && v <= INT32_MAX) fprintf(g->out, "\tmovq $%lld, %%rax\n", v);
+            else fprintf(g->out, "\tmovabsq $%lld, %%rax\n", v);
+            return;
+        }
+        case NODE_IDENTIFIER:
+            fprintf(g->out, "\tmovq %s, %%rax\n", variable_operand(g, e));
+            return;
+        case NODE_FUNC_CALL:
+            gen_call(g, e);
+            return;
+        case NODE_NEGATE:
+            gen_int(g, ast_child(g->ast, e));
+            fprintf(g->out, "\tnegq %%rax\n");
+            return;
+        case NODE_ADD:
+        case NODE_SUB:
+        case NODE_MUL: {
+            const char* op = ast_type(g->ast, e) == NODE_ADD ? "addq" : ast_type(g->ast, e) == NODE_SUB ? "subq" : "imulq";
+            AstId left = ast_child(g->ast, e);
+            AstId right = ast_sibling(g->ast, left);
+            // soma e produto comutam: deixa o operando simples para a direita
+            if (ast_type(g->ast, e) != NODE_SUB && int_operand(g, left, r, sizeof(r)) && !int_operand(g, right, r, sizeof(r))) {
+                AstId t = left; left = right; right = t;
+            }
+            gen_int(g, left);
+            if (int_operand(g, right, r, sizeof(r))) {
+                fprintf(g->out, "\t%s %s, %%rax\n", op, r);
+            } else {
+                push_int(g);
+                gen_int(g, right);
+                fprintf(g->out, "\tmovq %%rax, %%rcx\n");
+                pop_int(g, "%rax");
+                fprintf(g->out, "\t%s %%rcx, %%rax\n", op);
+            }
+            return;
+        }
+        case NODE_DIV: {
+            AstId right = ast_sibling(g->ast, ast_child(g->ast, e));
+            gen_int(g, ast_child(g->ast, e));
+            if (int_operand(g, right, r, sizeof(r))) {
+                fprintf(g->out, "\tmovq %s, %%rcx\n", r);
+            } else {
+                push_int(g);
+                gen_int(g, right);
+                fprintf(g->out, "\tmovq %%rax, %%rcx\n");
+                pop_int(g, "%rax");
+            }
+            fprintf(g->out, "\ttestq %%rcx, %%rcx\n\tje __lang_div_error\n");
+            // x / -1 vira -x, como nos outros backends (idiv daria SIGFPE
+            // com o menor inteiro)
+            int divide = new_label(g);
+            int done = new_label(g);
+            fprintf(g->out, "\tcmpq $-1, %%rcx\n\tjne .L%d\n\tnegq %%rax\n\tjmp .L%d\n", divide, done);
+            fprintf(g->out, ".L%d:\n\tcqto\n\tidivq %%rcx\n.L%d:\n", divide, done);
+            return;
+        }
+        default:
+            if (is_comparison(ast_type(g->ast, e))) {
+                gen_comparison_value(g, e);
+                return;
+            }
+            codegen_error("expressão inteira inválida", ast_value(g->ast, e));
+    }
+}
+
+static void gen_float(CodeGen* g, AstId e) {
+    if (expr_type(g->ast, e) == TYPE_INTEGER) {
+        gen_int(g, e);
+        fprintf(g->out, "\tcvtsi2sdq %%rax, %%xmm0\n");
+        return;
+    }
+    char r[32];
+    switch (ast_type(g->ast, e)) {
+        case NODE_FLOAT_LITERAL:
+        case NODE_IDENTIFIER:
+            float_operand(g, e, r, sizeof(r));
+            fprintf(g->out, "\tmovsd %s, %%xmm0\n", r);
+            return;
+        case NODE_FUNC_CALL:
+            gen_call(g, e);
+            return;
+        case NODE_NEGATE:
+            gen_float(g, ast_child(g->ast, e));
+            fprintf(g->out, "\txorpd .LCsign(%%rip), %%xmm0\n");
+            g->uses_sign_mask = 1;
+            return;
+        case NODE_ADD:
+        case NODE_SUB:
+        case NODE_MUL:
+        case NODE_DIV: {
+            const char* op = ast_type(g->ast, e) == NODE_ADD ? "addsd" : ast_type(g->ast, e) == NODE_SUB ? "subsd" : ast_type(g->ast, e) == NODE_MUL ? "mulsd" : "divsd";
+            AstId right = ast_sibling(g->ast, ast_child(g->ast, e));
+            gen_float(g, ast_child(g->ast, e));
+            if (float_operand(g, right, r, sizeof(r))) {
+                fprintf(g->out, "\t%s %s, %%xmm0\n", op, r);
+            } else {
+                push_float(g);
+                gen_float(g, right);
+                fprintf(g->out, "\tmovapd %%xmm0, %%xmm1\n");
+                pop_float(g, "%xmm0");
+                fprintf(g->out, "\t%s %%xmm1, %%xmm0\n", op);
+            }
+            return;
+        }
+        default:
+            codegen_error("expressão float inválida", ast_value(g->ast, e));
+    }
+}
+
+// salta para .L<label> quando a condição for igual a `when`
+static void gen_branch(CodeGen* g, AstId cond, int when, int label) {
+    if (is_comparison(ast_type(g->ast, cond))) {
+        AstId left = ast_child(g->ast, cond);
+        AstId right = ast_sibling(g->ast, left);
+        if (operand_type(g->ast, cond) == TYPE_INTEGER) {
+            gen_int_compare(g, left, right);
+            const char* cc = int_condition(ast_type(g->ast, cond));
+            fprintf(g->out, "\tj%s .L%d\n", when ? cc : negate_condition(cc), label);
+            return;
+        }
+        const char* cc = gen_float_compare(g, ast_type(g->ast, cond), left, right);
+        if (cc) {
+            // "a"/"ae" já são falsos para NaN; a negação precisa ser "be"/"b"
+            fprintf(g->out, "\tj%s .L%d\n", when ? cc : (strcmp(cc, "a") == 0 ? "be" : "b"), label);
+            return;
+        }
+        // == é verdadeiro com ZF=1 e PF=0; != é o complemento
+        int equal_taken = (ast_type(g->ast, cond) == NODE_EQ) == (when != 0);
+        if (equal_taken) {
+            int skip = new_label(g);
+            fprintf(g->out, "\tjp .L%d\n\tje .L%d\n.L%d:\n", skip, label, skip);
+        } else {
+            fprintf(g->out, "\tjp .L%d\n\tjne .L%d\n", label, label);
+        }
+        return;
+    }
+
+    if (expr_type(g->ast, cond) == TYPE_FLOAT) {
+        gen_float(g, cond);
+        fprintf(g->out, "\txorpd %%xmm1, %%xmm1\n\tucomisd %%xmm1, %%xmm0\n");
+        if (when) {
+            fprintf(g->out, "\tjp .L%d\n\tjne .L%d\n", label, label);
+        } else {
+            int skip = new_label(g);
+            fprintf(g->out, "\tjp .L%d\n\tje .L%d\n.L%d:\n", skip, label, skip);
+        }
+        return;
+    }
+    gen_int(g, cond);
+    fprintf(g->out, "\ttestq %%rax, %%rax\n\tj%s .L%d\n", when ? "ne" : "e", label);
+}
+
+// ---------------------------------------------------------------------------
+// instruções
+// ---------------------------------------------------------------------------
+
+static void gen_block(CodeGen* g, AstId block);
+
+static void gen_assignment(CodeGen* g, AstId node, AstId expr) {
+    SymbolNode* sym = node_variable(g, node);
+    const char* dst = g->locals[sym->address].operand;
+    if (sym->type == TYPE_FLOAT) {
+        gen_value(g, expr, TYPE_FLOAT);
+        fprintf(g->out, "\tmovsd %%xmm0, %s\n", dst);
+        return;
+    }
+
+    // x = x + y e x = x - y viram uma instrução só sobre a variável
+    char r[32];
+    if ((ast_type(g->ast, expr) == NODE_ADD || ast_type(g->ast, expr) == NODE_SUB) && ast_type(g->ast, ast_child(g->ast, expr)) == NODE_IDENTIFIER &&
+        ast_symbol(g->ast, ast_child(g->ast, expr)) == sym && int_operand(g, ast_sibling(g->ast, ast_child(g->ast, expr)), r, sizeof(r)) &&
+        !(is_memory(dst) && is_memory(r))) {
+        fprintf(g->out, "\t%s %s, %s\n", ast_type(g->ast, expr) == NODE_ADD ? "addq" : "subq", r, dst);
+        return;
+    }
+    gen_value(g, expr, TYPE_INTEGER);
+    fprintf(g->out, "\tmovq %%rax, %s\n", dst);
+}
+
+static void gen_statement(CodeGen* g, AstId node) {
+    switch (ast_type(g->ast, node)) {
+        case NODE_DECLARATION:
+            // variáveis começam valendo zero
+            fprintf(g->out, "\tmovq $0, %s\n", variable_operand(g, node));
+            break;
+
+        case NODE_DECL_ASSIGN:
+            gen_statement(g, ast_child(g->ast, node));
+            gen_statement(g, ast_sibling(g->ast, ast_child(g->ast, node)));
+            break;
+
+        case NODE_ASSIGNMENT:
+            gen_assignment(g, node, ast_child(g->ast, node));
+            break;
+
+        case NODE_BLOCK:
+            gen_block(g, node);
+            break;
+
+        case NODE_CONDITIONAL: {
+            AstId cond = ast_child(g->ast, node);
+            AstId then_block = ast_sibling(g->ast, cond);
+            AstId else_block = ast_sibling(g->ast, then_block);
+            int else_label = new_label(g);
+            gen_branch(g, cond, 0, else_label);
+            gen_block(g, then_block);
+            if (else_block) {
+                int end_label = new_label(g);
+                fprintf(g->out, "\tjmp .L%d\n.L%d:\n", end_label, else_label);
+                gen_block(g, else_block);
+                fprintf(g->out, ".L%d:\n", end_label);
+            } else {
+                fprintf(g->out, ".L%d:\n", else_label);
+            }
+            break;
+        }
+
+        case NODE_LOOP: {
+            // teste no fim: um só desvio por volta
+            int body_label = new_label(g);
+            int test_label = new_label(g);
+            fprintf(g->out, "\tjmp .L%d\n.L%d:\n", test_label, body_label);
+            gen_block(g, ast_sibling(g->ast, ast_child(g->ast, node)));
+            fprintf(g->out, ".L%d:\n", test_label);
+            gen_branch(g, ast_child(g->ast, node), 1, body_label);
+            break;
+        }
+
+        case NODE_RETURN_STMT:
+            gen_value(g, ast_child(g->ast, node), g->return_type);
+            fprintf(g->out, "\tjmp .Lret%d\n", g->return_label);
+            break;
+
+        case NODE_PRINT: {
+            AstId args = ast_child(g->ast, ast_child(g->ast, node));
+            if (!args) {
+                emit_call(g, "__lang_newline");
+                break;
+            }
+            for (AstId a = args; a; a = ast_sibling(g->ast, a)) {
+                int end = ast_sibling(g->ast, a) ? ' ' : '\n';
+                if (expr_type(g->ast, a) == TYPE_FLOAT) {
+                    gen_float(g, a);
+                    fprintf(g->out, "\tmovl $%d, %%edi\n", end);
+                    emit_call(g, "__lang_print_float");
+                } else {
+                    gen_int(g, a);
+                    fprintf(g->out, "\tmovq %%rax, %%rdi\n\tmovl $%d, %%esi\n", end);
+                    emit_call(g, "__lang_print_int");
+                }
+            }
+            break;
+        }
+
+        case NODE_SCAN:
+            for (AstId a = ast_child(g->ast, ast_child(g->ast, node)); a; a = ast_sibling(g->ast, a)) {
+                if (ast_type(g->ast, a) != NODE_IDENTIFIER) codegen_error("scan espera variáveis como argumento", ast_value(g->ast, a));
+                SymbolNode* sym = node_variable(g, a);
+                if (sym->type == TYPE_FLOAT) {
+                    emit_call(g, "__lang_scan_float");
+                    fprintf(g->out, "\tmovsd %%xmm0, %s\n", g->locals[sym->address].operand);
+                } else {
+                    emit_call(g, "__lang_scan_int");
+                    fprintf(g->out, "\tmovq %%rax, %s\n", g->locals[sym->address].operand);
+                }
+            }
+            break;
+
+        case NODE_FUNC_CALL:
+            gen_call(g, node);
+            break;
+
+        default:
+            codegen_error("instrução não suportada", ast_value(g->ast, node));
+    }
+}
+
+static void gen_block(CodeGen* g, AstId block) {
+    for (AstId stmt = ast_child(g->ast, block); stmt; stmt = ast_sibling(g->ast, stmt)) {
+        gen_statement(g, stmt);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// funções e programa
+// ---------------------------------------------------------------------------
+
+static void gen_function(CodeGen* g, const char* symbol, SymbolTable* scope, SymbolDataType return_type,
+                         AstId params, AstId body) {
+    g->scope = scope;
+    g->return_type = return_type;
+    g->return_label = new_label(g);
+    g->depth = 0;
+    g->local_count = scope_frame_size(scope);
+    g->locals = (Location*)calloc(g->local_count ? g->local_count : 1, sizeof(Location));
+    int frame = allocate_locals(g, params, body);
+
+    fprintf(g->out, "\n\t.type %s, @function\n%s:\n", symbol, symbol);
+    fprintf(g->out, "\tpushq %%rbp\n\tmovq %%rsp, %%rbp\n");
+    for (int i = 0; i < g->used_registers; i++) fprintf(g->out, "\tpushq %s\n", callee_saved[i]);
+    if (frame) fprintf(g->out, "\tsubq $%d, %%rsp\n", frame);
+
+    // copia os parâmetros dos registradores de argumento para o seu lugar.
+    // os que não couberam neles estão acima do endereço de retorno, a
+    // partir de 16(%rbp)
+    int ints = 0, floats = 0, stacked = 0;
+    for (AstId p = params; p; p = ast_sibling(g->ast, p)) {
+        SymbolNode* sym = node_variable(g, p);
+        const char* dst = g->locals[sym->address].operand;
+        if (sym->type == TYPE_FLOAT ? floats++ >= MAX_FLOAT_ARGS : ints++ >= MAX_INT_ARGS) {
+            fprintf(g->out, "\tmovq %d(%%rbp), %%rax\n\tmovq %%rax, %s\n", 16 + 8 * stacked++, dst);
+        } else if (sym->type == TYPE_FLOAT) {
+            fprintf(g->out, "\tmovsd %%xmm%d, %s\n", floats - 1, dst);
+        } else {
+            fprintf(g->out, "\tmovq %s, %s\n", int_arg_registers[ints - 1], dst);
+        }
+    }
+
+    gen_block(g, body);
+
+    // sem return explícito a função devolve zero
+    if (return_type == TYPE_FLOAT) fprintf(g->out, "\txorpd %%xmm0, %%xmm0\n");
+    else fprintf(g->out, "\txorl %%eax, %%eax\n");
+    fprintf(g->out, ".Lret%d:\n", g->return_label);
+    if (g->used_registers) {
+        fprintf(g->out, "\tleaq -%d(%%rbp), %%rsp\n", 8 * g->used_registers);
+        for (int i = g->used_registers - 1; i >= 0; i--) fprintf(g->out, "\tpopq %s\n", callee_saved[i]);
+    } else {
+        fprintf(g->out, "\tmovq %%rbp, %%rsp\n");
+    }
+    fprintf(g->out, "\tpopq %%rbp\n\tret\n");
+    fprintf(g->out, "\t.size %s, .-%s\n", symbol, symbol);
+    free(g->locals);
+    g->locals = NULL;
+}
+
+// rotinas de entrada e saída usadas pelo código gerado
+static void emit_runtime(FILE* out) {
+    fprintf(out,
+        "\n\t.type __lang_print_int, @function\n"
+        "__lang_print_int:\n"
+        "\tpushq %%rbp\n\tmovq %%rsp, %%rbp\n"
+        "\tmovl %%esi, %%edx\n\tmovq %%rdi, %%rsi\n"
+        "\tleaq .Lfmt_print_int(%%rip), %%rdi\n\txorl %%eax, %%eax\n"
+        "\tcall printf@PLT\n"
+        "\tpopq %%rbp\n\tret\n"
+        "\n\t.type __lang_print_float, @function\n"
+        "__lang_print_float:\n"
+        "\tpushq %%rbp\n\tmovq %%rsp, %%rbp\n"
+        "\tmovl %%edi, %%esi\n"
+        "\tleaq .Lfmt_print_float(%%rip), %%rdi\n\tmovl $1, %%eax\n"
+        "\tcall printf@PLT\n"
+        "\tpopq %%rbp\n\tret\n"
+        "\n\t.type __lang_newline, @function\n"
+        "__lang_newline:\n"
+        "\tpushq %%rbp\n\tmovq %%rsp, %%rbp\n"
+        "\tmovl $10, %%edi\n\tcall putchar@PLT\n"
+        "\tpopq %%rbp\n\tret\n"
+        "\n\t.type __lang_scan_int, @function\n"
+        "__lang_scan_int:\n"
+        "\tpushq %%rbp\n\tmovq %%rsp, %%rbp\n\tsubq $16, %%rsp\n"
+        "\tleaq -8(%%rbp), %%rsi\n\tleaq .Lfmt_scan_int(%%rip), %%rdi\n\txorl %%eax, %%eax\n"
+        "\tcall scanf@PLT\n"
+        "\tcmpl $1, %%eax\n\tjne __lang_scan_error\n"
+        "\tmovq -8(%%rbp), %%rax\n"
+        "\tleave\n\tret\n"
+        "\n\t.type __lang_scan_float, @function\n"
+        "__lang_scan_float:\n"
+        "\tpushq %%rbp\n\tmovq %%rsp, %%rbp\n\tsubq $16, %%rsp\n"
+        "\tleaq -8(%%rbp), %%rsi\n\tleaq .Lfmt_scan_float(%%rip), %%rdi\n\txorl %%eax, %%eax\n"
+        "\tcall scanf@PLT\n"
+        "\tcmpl $1, %%eax\n\tjne __lang_scan_error\n"
+        "\tmovsd -8(%%rbp), %%xmm0\n"
+        "\tleave\n\tret\n"
+        "\n__lang_scan_error:\n"
+        "\tleaq .Lmsg_scan(%%rip), %%rsi\n\tjmp __lang_runtime_error\n"
+        "\n__lang_div_error:\n"
+        "\tleaq .Lmsg_div(%%rip), %%rsi\n"
+        "__lang_runtime_error:\n"
+        "\tandq $-16, %%rsp\n\tpushq %%rsi\n\tpushq %%rsi\n"
+        "\txorl %%edi, %%edi\n\tcall fflush@PLT\n"
+        "\tpopq %%rsi\n\tmovl $2, %%edi\n\txorl %%eax, %%eax\n\tcall dprintf@PLT\n"
+        "\tmovl $1, %%edi\n\tcall exit@PLT\n");
+
+    fprintf(out,
+        "\n\t.section .rodata\n"
+        ".Lfmt_print_int:\n\t.string \"%%lld%%c\"\n"
+        ".Lfmt_print_float:\n\t.string \"%%g%%c\"\n"
+        ".Lfmt_scan_int:\n\t.string \"%%lld\"\n"
+        ".Lfmt_scan_float:\n\t.string \"%%lf\"\n"
+        ".Lmsg_scan:\n\t.string \"Erro de Execução: entrada inválida para scan.\\n\"\n"
+        ".Lmsg_div:\n\t.string \"Erro de Execução: divisão por zero.\\n\"\n");
+}
+
+static void emit_program(CodeGen* g, SymbolTable* global_scope) {
+    const Ast* ast = g->ast;
+    FILE* out = g->out;
+    AstId root = ast->root;
+
+    // assinaturas de todas as funções
+    for (AstId n = ast_child(ast, root); n; n = ast_sibling(ast, n)) {
+        if (ast_type(ast, n) == NODE_FUNC_DECL) g->function_count++;
+    }
+    g->functions = (FunctionInfo*)calloc(g->function_count ? g->function_count : 1, sizeof(FunctionInfo));
+    int i = 0;
+    AstId main_block = AST_NONE;
+    for (AstId n = ast_child(ast, root); n; n = ast_sibling(ast, n)) {
+        if (ast_type(ast, n) != NODE_FUNC_DECL) {
+            main_block = n;
+            continue;
+        }
+        FunctionInfo* f = &g->functions[i++];
+        f->name = ast_value(ast, n);
+        f->decl = n;
+        SymbolNode* sym = ast_symbol(ast, n);
+        f->return_type = sym ? sym->type : TYPE_INTEGER;
+        for (AstId p = ast_child(ast, ast_child(ast, n)); p; p = ast_sibling(ast, p)) f->param_count++;
+        f->param_types = (SymbolDataType*)malloc((f->param_count ? f->param_count : 1) * sizeof(SymbolDataType));
+        int j = 0;
+        for (AstId p = ast_child(ast, ast_child(ast, n)); p; p = ast_sibling(ast, p), j++) f->param_types[j] = ast_symbol(ast, p)->type;
+    }
+
+    fprintf(out, "\t.text\n");
+    for (i = 0; i < g->function_count; i++) {
+        FunctionInfo* f = &g->functions[i];
+        char symbol[256];
+        snprintf(symbol, sizeof(symbol), "lang_%s", f->name);
+        gen_function(g, symbol, ast_scope(ast, f->decl), f->return_type, ast_child(ast, ast_child(ast, f->decl)), ast_sibling(ast, ast_child(ast, f->decl)));
+    }
+
+    // o ponto de entrada é o bloco principal ou a função main
+    const char* entry = "__lang_main_block";
+    SymbolDataType entry_type = TYPE_INTEGER;
+    if (main_block) {
+        gen_function(g, entry, global_scope, TYPE_INTEGER, AST_NONE, main_block);
+    } else {
+        FunctionInfo* f = find_function(g, intern_cstr("main"));
+        if (f->param_count) codegen_error("a função main não pode ter parâmetros", "main");
+        entry = "lang_main";
+        entry_type = f->return_type;
+    }
+    fprintf(out, "\n\t.globl main\n\t.type main, @function\nmain:\n");
+    fprintf(out, "\tpushq %%rbp\n\tmovq %%rsp, %%rbp\n\tcall %s\n", entry);
+    if (entry_type == TYPE_FLOAT) fprintf(out, "\tcvttsd2sil %%xmm0, %%eax\n");
+    fprintf(out, "\tpopq %%rbp\n\tret\n");
+
+    emit_runtime(out);
+
+    for (i = 0; i < g->float_count; i++) {
+        uint64_t bits;
+        memcpy(&bits, &g->float_constants[i], sizeof(bits));
+        fprintf(out, "\t.align 8\n.LCF%d:\n\t.quad %llu\n", i, (unsigned long long)bits);
+    }
+    if (g->uses_sign_mask) {
+        fprintf(out, "\t.align 16\n.LCsign:\n\t.quad 0x8000000000000000, 0\n");
+    }
+    fprintf(out, "\t.section .note.GNU-stack,\"\",@progbits\n");
+}
+
+static void free_codegen(CodeGen* g) {
+    free(g->locals);
+    if (g->functions) {
+        for (int i = 0; i < g->function_count; i++) free(g->functions[i].param_types);
+    }
+    free(g->functions);
+    free(g->float_constants);
+    free(g);
+}
+
+void codegen_emit_asm(const Ast* ast, SymbolTable* global_scope, FILE* out) {
+    // o estado fica fora da pilha para continuar válido depois do longjmp
+    CodeGen* g = (CodeGen*)calloc(1, sizeof(CodeGen));
+    if (!g) compile_error("Erro: memória insuficiente para gerar código.");
+    g->out = out;
+    g->ast = ast;
+
+    // um erro no meio da geração volta aqui, libera o que foi alocado e
+    // segue para quem chamou (ou termina o processo, fora da biblioteca)
+    ErrorTrap trap;
+    error_trap_push(&trap);
+    if (setjmp(trap.jump)) {
+        error_trap_pop(&trap);
+        free_codegen(g);
+        compile_error("%s", trap.message);
+    }
+    emit_program(g, global_scope);
+    error_trap_pop(&trap);
+    free_codegen(g);
+}
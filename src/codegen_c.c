@@ -0,0 +1,413 @@
+#include "codegen.h"
+#include "types.h"
+#include "diagnostic.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+// os nomes da linguagem ganham prefixo para não colidir com palavras
+// reservadas, com funções da biblioteca C nem com as rotinas lang_ do
+// próprio código gerado (um identificador pode ter qualquer texto depois
+// do prefixo, então cada tipo de nome tem o seu)
+#define FUNCTION_PREFIX "f_"
+#define VARIABLE_PREFIX "v_"
+#define TEMP_PREFIX "t_"
+
+typedef struct {
+    FILE* out;
+    const Ast* ast;
+    SymbolTable* scope;     // escopo da função atual
+    int indent;
+    int* temp;              // por nó: a temporária que já tem o valor dele (0 se não tem)
+    int temp_count;
+} CEmitter;
+
+static void emit_c_error(const char* message, const char* name) {
+    if (name) compile_error("Erro de Geração de Código: %s ('%s').", message, name);
+    compile_error("Erro de Geração de Código: %s.", message);
+}
+
+static const char* c_type(SymbolDataType type) {
+    return type == TYPE_FLOAT ? "double" : "long long";
+}
+
+static void indent(CEmitter* e) {
+    for (int i = 0; i < e->indent; i++) fputs("    ", e->out);
+}
+
+static void emit_expr(CEmitter* e, AstId node);
+
+static void emit_binary(CEmitter* e, AstId node, const char* op) {
+    fputc('(', e->out);
+    emit_expr(e, ast_child(e->ast, node));
+    fprintf(e->out, " %s ", op);
+    emit_expr(e, ast_sibling(e->ast, ast_child(e->ast, node)));
+    fputc(')', e->out);
+}
+
+// soma, subtração e multiplicação inteiras em complemento de dois, como na
+// execução: feitas em unsigned long long, onde o estouro é definido
+static void emit_arithmetic(CEmitter* e, AstId node, const char* op) {
+    if (operand_type(e->ast, node) != TYPE_INTEGER) {
+        emit_binary(e, node, op);
+        return;
+    }
+    fputs("(long long)((unsigned long long)", e->out);
+    emit_expr(e, ast_child(e->ast, node));
+    fprintf(e->out, " %s (unsigned long long)", op);
+    emit_expr(e, ast_sibling(e->ast, ast_child(e->ast, node)));
+    fputs(")", e->out);
+}
+
+static void emit_expr(CEmitter* e, AstId node) {
+    if (e->temp[node]) {
+        fprintf(e->out, TEMP_PREFIX "%d", e->temp[node]);
+        return;
+    }
+    switch (ast_type(e->ast, node)) {
+        case NODE_INT_LITERAL: {
+            // lido como decimal, como nos outros backends (no C, um 0 na
+            // frente faria o literal ser octal)
+            long long value = strtoll(ast_value(e->ast, node), NULL, 10);
+            if (value == LLONG_MIN) fputs("(-9223372036854775807LL - 1)", e->out);
+            else fprintf(e->out, "%lldLL", value);
+            break;
+        }
+        case NODE_FLOAT_LITERAL: fprintf(e->out, "%s", ast_value(e->ast, node)); break;
+        case NODE_IDENTIFIER: fprintf(e->out, VARIABLE_PREFIX "%s", ast_value(e->ast, node)); break;
+        case NODE_FUNC_CALL:
+            fprintf(e->out, FUNCTION_PREFIX "%s(", ast_value(e->ast, node));
+            for (AstId a = ast_child(e->ast, node) ? ast_child(e->ast, ast_child(e->ast, node)) : AST_NONE; a; a = ast_sibling(e->ast, a)) {
+                emit_expr(e, a);
+                if (ast_sibling(e->ast, a)) fputs(", ", e->out);
+            }
+            fputc(')', e->out);
+            break;
+        case NODE_NEGATE:
+            fputs(expr_type(e->ast, node) == TYPE_INTEGER ? "(long long)(0ULL - (unsigned long long)" : "(-", e->out);
+            emit_expr(e, ast_child(e->ast, node));
+            fputc(')', e->out);
+            break;
+        case NODE_ADD: emit_arithmetic(e, node, "+"); break;
+        case NODE_SUB: emit_arithmetic(e, node, "-"); break;
+        case NODE_MUL: emit_arithmetic(e, node, "*"); break;
+        case NODE_DIV:
+            // divisão inteira passa pela checagem de divisão por zero
+            if (operand_type(e->ast, node) == TYPE_INTEGER) {
+                fputs("lang_div(", e->out);
+                emit_expr(e, ast_child(e->ast, node));
+                fputs(", ", e->out);
+                emit_expr(e, ast_sibling(e->ast, ast_child(e->ast, node)));
+                fputc(')', e->out);
+            } else {
+                emit_binary(e, node, "/");
+            }
+            break;
+        case NODE_EQ: emit_binary(e, node, "=="); break;
+        case NODE_NEQ: emit_binary(e, node, "!="); break;
+        case NODE_LT: emit_binary(e, node, "<"); break;
+        case NODE_LTE: emit_binary(e, node, "<="); break;
+        case NODE_GT: emit_binary(e, node, ">"); break;
+        case NODE_GTE: emit_binary(e, node, ">="); break;
+        default: emit_c_error("expressão inválida", ast_value(e->ast, node));
+    }
+}
+
+// chamadas e divisões inteiras que podem falhar. o C não fixa a ordem de
+// avaliação dos operandos nem dos argumentos, então quando há mais de uma
+// na expressão elas vão antes, da esquerda para a direita, para temporárias
+static int has_effect(CEmitter* e, AstId node) {
+    switch (ast_type(e->ast, node)) {
+        case NODE_FUNC_CALL:
+            return 1;
+        case NODE_DIV: {
+            AstId divisor = ast_sibling(e->ast, ast_child(e->ast, node));
+            return operand_type(e->ast, node) == TYPE_INTEGER &&
+                   (ast_type(e->ast, divisor) != NODE_INT_LITERAL || strtoll(ast_value(e->ast, divisor), NULL, 10) == 0);
+        }
+        default:
+            return 0;
+    }
+}
+
+static int count_effects(CEmitter* e, AstId node) {
+    int count = has_effect(e, node);
+    for (AstId c = ast_child(e->ast, node); c && count < 2; c = ast_sibling(e->ast, c)) count += count_effects(e, c);
+    return count;
+}
+
+// emite os efeitos da subárvore na ordem de execução, menos o da raiz
+static void hoist_effects(CEmitter* e, AstId node, int root) {
+    for (AstId c = ast_child(e->ast, node); c; c = ast_sibling(e->ast, c)) hoist_effects(e, c, 0);
+    if (root || !has_effect(e, node)) return;
+    indent(e);
+    fprintf(e->out, "%s " TEMP_PREFIX "%d = ", c_type(expr_type(e->ast, node)), e->temp_count + 1);
+    emit_expr(e, node);
+    fputs(";\n", e->out);
+    e->temp[node] = ++e->temp_count;
+}
+
+static void emit_effects_first(CEmitter* e, AstId expr) {
+    if (count_effects(e, expr) > 1) hoist_effects(e, expr, 1);
+}
+
+static void emit_block(CEmitter* e, AstId block);
+
+static void emit_statement(CEmitter* e, AstId node) {
+    switch (ast_type(e->ast, node)) {
+        case NODE_DECLARATION:
+            // as variáveis são declaradas no topo da função; aqui só zeram
+            indent(e);
+            fprintf(e->out, VARIABLE_PREFIX "%s = 0;\n", ast_value(e->ast, node));
+            break;
+
+        case NODE_DECL_ASSIGN:
+            emit_statement(e, ast_child(e->ast, node));
+            emit_statement(e, ast_sibling(e->ast, ast_child(e->ast, node)));
+            break;
+
+        case NODE_ASSIGNMENT:
+            emit_effects_first(e, ast_child(e->ast, node));
+            indent(e);
+            fprintf(e->out, VARIABLE_PREFIX "%s = ", ast_value(e->ast, node));
+            emit_expr(e, ast_child(e->ast, node));
+            fputs(";\n", e->out);
+            break;
+
+        case NODE_BLOCK:
+            emit_block(e, node);
+            break;
+
+        case NODE_CONDITIONAL: {
+            AstId cond = ast_child(e->ast, node);
+            AstId else_block = ast_sibling(e->ast, ast_sibling(e->ast, cond));
+            emit_effects_first(e, cond);
+            indent(e);
+            fputs("if (", e->out);
+            emit_expr(e, cond);
+            fputs(") {\n", e->out);
+            e->indent++;
+            emit_block(e, ast_sibling(e->ast, cond));
+            e->indent--;
+            if (else_block) {
+                indent(e);
+                fputs("} else {\n", e->out);
+                e->indent++;
+                emit_block(e, else_block);
+                e->indent--;
+            }
+            indent(e);
+            fputs("}\n", e->out);
+            break;
+        }
+
+        case NODE_LOOP: {
+            AstId cond = ast_child(e->ast, node);
+            indent(e);
+            if (count_effects(e, cond) > 1) {
+                // a condição é recalculada a cada volta, junto com as temporárias
+                fputs("while (1) {\n", e->out);
+                e->indent++;
+                hoist_effects(e, cond, 1);
+                indent(e);
+                fputs("if (!", e->out);
+                emit_expr(e, cond);
+                fputs(") break;\n", e->out);
+            } else {
+                fputs("while (", e->out);
+                emit_expr(e, cond);
+                fputs(") {\n", e->out);
+                e->indent++;
+            }
+            emit_block(e, ast_sibling(e->ast, cond));
+            e->indent--;
+            indent(e);
+            fputs("}\n", e->out);
+            break;
+        }
+
+        case NODE_RETURN_STMT:
+            emit_effects_first(e, ast_child(e->ast, node));
+            indent(e);
+            fputs("return ", e->out);
+            emit_expr(e, ast_child(e->ast, node));
+            fputs(";\n", e->out);
+            break;
+
+        case NODE_PRINT: {
+            AstId args = ast_child(e->ast, ast_child(e->ast, node));
+            if (!args) {
+                indent(e);
+                fputs("putchar('\\n');\n", e->out);
+                break;
+            }
+            for (AstId a = args; a; a = ast_sibling(e->ast, a)) {
+                emit_effects_first(e, a);
+                indent(e);
+                fprintf(e->out, "lang_print_%s(", expr_type(e->ast, a) == TYPE_FLOAT ? "float" : "int");
+                emit_expr(e, a);
+                fprintf(e->out, ", '%s');\n", ast_sibling(e->ast, a) ? " " : "\\n");
+            }
+            break;
+        }
+
+        case NODE_SCAN:
+            for (AstId a = ast_child(e->ast, ast_child(e->ast, node)); a; a = ast_sibling(e->ast, a)) {
+                if (ast_type(e->ast, a) != NODE_IDENTIFIER) emit_c_error("scan espera variáveis como argumento", ast_value(e->ast, a));
+                indent(e);
+                fprintf(e->out, VARIABLE_PREFIX "%s = lang_scan_%s();\n", ast_value(e->ast, a),
+                        expr_type(e->ast, a) == TYPE_FLOAT ? "float" : "int");
+            }
+            break;
+
+        case NODE_FUNC_CALL:
+            emit_effects_first(e, node);
+            indent(e);
+            emit_expr(e, node);
+            fputs(";\n", e->out);
+            break;
+
+        default:
+            emit_c_error("instrução não suportada", ast_value(e->ast, node));
+    }
+}
+
+static void emit_block(CEmitter* e, AstId block) {
+    for (AstId stmt = ast_child(e->ast, block); stmt; stmt = ast_sibling(e->ast, stmt)) {
+        emit_statement(e, stmt);
+    }
+}
+
+// declara as variáveis locais (não os parâmetros) do escopo, em ordem de endereço
+static void emit_locals(CEmitter* e, SymbolTable* scope) {
+    int size = scope_frame_size(scope);
+    SymbolNode** by_address = (SymbolNode**)calloc(size ? size : 1, sizeof(SymbolNode*));
+    for (SymbolNode* sym = scope->first; sym; sym = sym->next) {
+        if (sym->kind == KIND_VARIABLE) by_address[sym->address] = sym;
+    }
+    for (int i = 0; i < size; i++) {
+        if (!by_address[i]) continue;
+        fprintf(e->out, "    %s " VARIABLE_PREFIX "%s = 0;\n", c_type(by_address[i]->type), by_address[i]->name);
+    }
+    free(by_address);
+}
+
+static void emit_signature(CEmitter* e, AstId func) {
+    SymbolNode* sym = ast_symbol(e->ast, func);
+    fprintf(e->out, "static %s " FUNCTION_PREFIX "%s(", c_type(sym ? sym->type : TYPE_INTEGER), ast_value(e->ast, func));
+    AstId params = ast_child(e->ast, ast_child(e->ast, func));
+    if (!params) fputs("void", e->out);
+    for (AstId p = params; p; p = ast_sibling(e->ast, p)) {
+        SymbolNode* param = ast_symbol(e->ast, p);
+        fprintf(e->out, "%s " VARIABLE_PREFIX "%s", c_type(param->type), ast_value(e->ast, p));
+        if (ast_sibling(e->ast, p)) fputs(", ", e->out);
+    }
+    fputc(')', e->out);
+}
+
+static void emit_body(CEmitter* e, SymbolTable* scope, AstId body) {
+    fputs(" {\n", e->out);
+    e->scope = scope;
+    e->indent = 1;
+    e->temp_count = 0;
+    emit_locals(e, scope);
+    emit_block(e, body);
+    fputs("    return 0;\n}\n", e->out);
+}
+
+static const char* runtime_source =
+    "#include <stdio.h>\n"
+    "#include <stdlib.h>\n"
+    "\n"
+    "static void lang_runtime_error(const char* message) {\n"
+    "    fflush(stdout);\n"
+    "    fprintf(stderr, \"Erro de Execução: %s.\\n\", message);\n"
+    "    exit(EXIT_FAILURE);\n"
+    "}\n"
+    "\n"
+    "static inline long long lang_div(long long a, long long b) {\n"
+    "    if (b == 0) lang_runtime_error(\"divisão por zero\");\n"
+    "    return b == -1 ? (long long)(0ULL - (unsigned long long)a) : a / b;\n"
+    "}\n"
+    "\n"
+    "static inline void lang_print_int(long long value, char end) { printf(\"%lld%c\", value, end); }\n"
+    "static inline void lang_print_float(double value, char end) { printf(\"%g%c\", value, end); }\n"
+    "\n"
+    "static inline long long lang_scan_int(void) {\n"
+    "    long long value;\n"
+    "    if (scanf(\"%lld\", &value) != 1) lang_runtime_error(\"entrada inválida para scan\");\n"
+    "    return value;\n"
+    "}\n"
+    "\n"
+    "static inline double lang_scan_float(void) {\n"
+    "    double value;\n"
+    "    if (scanf(\"%lf\", &value) != 1) lang_runtime_error(\"entrada inválida para scan\");\n"
+    "    return value;\n"
+    "}\n";
+
+static void emit_program(CEmitter* e, SymbolTable* global_scope) {
+    const Ast* ast = e->ast;
+    FILE* out = e->out;
+    AstId root = ast->root;
+
+    fputs("/* gerado pelo compilador a partir da AST */\n", out);
+    fputs(runtime_source, out);
+
+    // protótipos, para que as chamadas possam vir em qualquer ordem
+    fputc('\n', out);
+    AstId main_block = AST_NONE;
+    for (AstId n = ast_child(ast, root); n; n = ast_sibling(ast, n)) {
+        if (ast_type(ast, n) != NODE_FUNC_DECL) {
+            main_block = n;
+            continue;
+        }
+        emit_signature(e, n);
+        fputs(";\n", out);
+    }
+
+    for (AstId n = ast_child(ast, root); n; n = ast_sibling(ast, n)) {
+        if (ast_type(ast, n) != NODE_FUNC_DECL) continue;
+        fputc('\n', out);
+        emit_signature(e, n);
+        emit_body(e, ast_scope(ast, n), ast_sibling(ast, ast_child(ast, n)));
+    }
+
+    if (main_block) {
+        fputs("\nstatic long long lang_main_block(void)", out);
+        emit_body(e, global_scope, main_block);
+        fputs("\nint main(void) {\n    return (int)lang_main_block();\n}\n", out);
+        return;
+    }
+    SymbolNode* entry = scope_lookup_current(global_scope, intern_cstr("main"));
+    if (!entry || entry->kind != KIND_FUNCTION) emit_c_error("programa sem bloco principal nem função", "main");
+    fputs("\nint main(void) {\n    return (int)" FUNCTION_PREFIX "main();\n}\n", out);
+}
+
+static void free_emitter(CEmitter* e) {
+    free(e->temp);
+    free(e);
+}
+
+void codegen_emit_c(const Ast* ast, SymbolTable* global_scope, FILE* out) {
+    // o estado fica fora da pilha para continuar válido depois do longjmp
+    CEmitter* e = (CEmitter*)calloc(1, sizeof(CEmitter));
+    if (!e) compile_error("Erro: memória insuficiente para gerar código.");
+    e->out = out;
+    e->ast = ast;
+    e->scope = global_scope;
+
+    // um erro no meio da geração volta aqui, libera o que foi alocado e
+    // segue para quem chamou (ou termina o processo, fora da biblioteca)
+    ErrorTrap trap;
+    error_trap_push(&trap);
+    if (setjmp(trap.jump)) {
+        error_trap_pop(&trap);
+        free_emitter(e);
+        compile_error("%s", trap.message);
+    }
+    e->temp = (int*)calloc(ast->count ? ast->count : 1, sizeof(int));
+    if (!e->temp) compile_error("Erro: memória insuficiente para gerar código.");
+    emit_program(e, global_scope);
+    error_trap_pop(&trap);
+    free_emitter(e);
+}
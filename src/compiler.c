@@ -0,0 +1,101 @@
+#include "compiler.h"
+#include "lexer.h"
+#include "parser.h"
+#include "codegen.h"
+#include "optimize.h"
+#include "source.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// tudo o que uma compilação aloca. fica fora da pilha para que os
+// ponteiros continuem válidos depois do longjmp de um erro.
+typedef struct {
+    char* text;             // cópia do fonte com os zeros que o lexer espera
+    TokenStream stream;
+    int stream_open;
+    Arena* arena;
+    Ast* ast;
+    FILE* out;              // fluxo em memória do código gerado
+    char* output;
+    size_t output_length;
+} Compilation;
+
+static void compilation_free(Compilation* c) {
+    if (c->out) fclose(c->out);
+    free(c->output);
+    if (c->stream_open) token_stream_close(&c->stream);
+    if (c->ast) ast_free(c->ast);
+    arena_destroy(c->arena);
+    free(c->text);
+    free(c);
+}
+
+static void compile(Compilation* c, const char* text, size_t length, const CompileOptions* options) {
+    c->text = (char*)malloc(length + SOURCE_PADDING);
+    if (!c->text) compile_error("Erro: memória insuficiente para o código-fonte.");
+    memcpy(c->text, text, length);
+    memset(c->text + length, 0, SOURCE_PADDING);
+
+    token_stream_open(&c->stream, c->text, length);
+    c->stream_open = 1;
+    c->arena = arena_create();
+    c->ast = ast_create();
+    SymbolTable* global_scope = scope_create(c->arena);
+
+    // a análise paralela fica desligada: um erro numa thread do pool não
+    // teria como voltar para quem chamou
+    ParserState state = {&c->stream, global_scope, 0, c->arena, c->ast, c->text, 0};
+    state.max_depth = options->max_depth;
+    parse(&state);
+    if (options->target == COMPILE_CHECK) return;
+    if (!options->no_optimize) optimize_program(c->ast, global_scope, NULL);
+
+    c->out = open_memstream(&c->output, &c->output_length);
+    if (!c->out) compile_error("Erro: não foi possível criar a saída em memória.");
+    if (options->target == COMPILE_EMIT_ASM) codegen_emit_asm(c->ast, global_scope, c->out);
+    else codegen_emit_c(c->ast, global_scope, c->out);
+    fclose(c->out);
+    c->out = NULL;
+}
+
+int compile_source(const char* text, size_t length, const CompileOptions* options, CompileResult* result) {
+    static const CompileOptions defaults = { COMPILE_CHECK, 0, 0 };
+    if (!options) options = &defaults;
+    memset(result, 0, sizeof(CompileResult));
+
+    Compilation* c = (Compilation*)calloc(1, sizeof(Compilation));
+    if (!c) {
+        snprintf(result->error, sizeof(result->error), "Erro: memória insuficiente.");
+        return 0;
+    }
+    // os nomes internados só valem durante a compilação
+    intern_retain();
+
+    ErrorTrap trap;
+    error_trap_push(&trap);
+    if (setjmp(trap.jump)) {
+        error_trap_pop(&trap);
+        memcpy(result->error, trap.message, sizeof(result->error));
+        compilation_free(c);
+        intern_release();
+        return 0;
+    }
+    compile(c, text, length, options);
+    error_trap_pop(&trap);
+
+    // o código gerado passa a ser de quem chamou
+    result->ok = 1;
+    result->output = c->output;
+    result->output_length = c->output_length;
+    c->output = NULL;
+    compilation_free(c);
+    intern_release();
+    return 1;
+}
+
+void compile_result_free(CompileResult* result) {
+    free(result->output);
+    result->output = NULL;
+    result->output_length = 0;
+}
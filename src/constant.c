@@ -0,0 +1,150 @@
+#include "constant.h"
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// os backends leem os literais com strtoll/strtod; aqui também
+Constant constant_of_literal(const Ast* ast, AstId node) {
+    Constant c;
+    if (ast_type(ast, node) == NODE_INT_LITERAL) {
+        c.type = TYPE_INTEGER;
+        c.i = strtoll(ast_value(ast, node), NULL, 10);
+    } else {
+        c.type = TYPE_FLOAT;
+        c.f = strtod(ast_value(ast, node), NULL);
+    }
+    return c;
+}
+
+static Constant int_constant(long long value) {
+    Constant c;
+    c.type = TYPE_INTEGER;
+    c.i = value;
+    return c;
+}
+
+static Constant float_constant(double value) {
+    Constant c;
+    c.type = TYPE_FLOAT;
+    c.f = value;
+    return c;
+}
+
+static double as_float(Constant c) {
+    return c.type == TYPE_FLOAT ? c.f : (double)c.i;
+}
+
+int constant_binary(NodeType op, Constant a, Constant b, Constant* out) {
+    if (a.type == TYPE_FLOAT || b.type == TYPE_FLOAT) {
+        double x = as_float(a), y = as_float(b);
+        switch (op) {
+            case NODE_EQ: *out = int_constant(x == y); return 1;
+            case NODE_NEQ: *out = int_constant(x != y); return 1;
+            case NODE_LT: *out = int_constant(x < y); return 1;
+            case NODE_LTE: *out = int_constant(x <= y); return 1;
+            case NODE_GT: *out = int_constant(x > y); return 1;
+            case NODE_GTE: *out = int_constant(x >= y); return 1;
+            default: break;
+        }
+        double r = op == NODE_ADD ? x + y : op == NODE_SUB ? x - y : op == NODE_MUL ? x * y : x / y;
+        if (!isfinite(r)) return 0;
+        *out = float_constant(r);
+        return 1;
+    }
+
+    long long x = a.i, y = b.i;
+    // aritmética com complemento de dois, como na execução
+    unsigned long long ux = (unsigned long long)x, uy = (unsigned long long)y;
+    long long r;
+    switch (op) {
+        case NODE_ADD: r = (long long)(ux + uy); break;
+        case NODE_SUB: r = (long long)(ux - uy); break;
+        case NODE_MUL: r = (long long)(ux * uy); break;
+        case NODE_DIV:
+            if (y == 0) return 0;
+            r = y == -1 ? (long long)(0 - ux) : x / y;
+            break;
+        case NODE_EQ: r = x == y; break;
+        case NODE_NEQ: r = x != y; break;
+        case NODE_LT: r = x < y; break;
+        case NODE_LTE: r = x <= y; break;
+        case NODE_GT: r = x > y; break;
+        default: r = x >= y; break;
+    }
+    *out = int_constant(r);
+    return 1;
+}
+
+int constant_negate(Constant a, Constant* out) {
+    if (a.type == TYPE_FLOAT) *out = float_constant(-a.f);
+    else *out = int_constant((long long)(0 - (unsigned long long)a.i));
+    return 1;
+}
+
+int constant_convert(Constant a, SymbolDataType type, Constant* out) {
+    if (a.type == type) {
+        *out = a;
+        return 1;
+    }
+    if (type == TYPE_FLOAT) {
+        *out = float_constant((double)a.i);
+        return 1;
+    }
+    // só a faixa em que o truncamento é o mesmo em todo lugar
+    if (!(a.f > -9223372036854775808.0 && a.f < 9223372036854775808.0)) return 0;
+    *out = int_constant((long long)a.f);
+    return 1;
+}
+
+int constant_truth(Constant c) {
+    return c.type == TYPE_FLOAT ? c.f != 0 : c.i != 0;
+}
+
+int constant_equal(Constant a, Constant b) {
+    if (a.type != b.type) return 0;
+    if (a.type == TYPE_INTEGER) return a.i == b.i;
+    return memcmp(&a.f, &b.f, sizeof(double)) == 0;
+}
+
+// texto do literal. o de float precisa voltar exatamente ao mesmo double e
+// continuar parecendo float (o backend C copia o literal como está).
+static int literal_text(Constant c, char* text, size_t size) {
+    if (c.type == TYPE_INTEGER) {
+        // "-9223372036854775808LL" não é um literal válido em C
+        if (c.i == LLONG_MIN) return -1;
+        return snprintf(text, size, "%lld", c.i);
+    }
+    if (!isfinite(c.f)) return -1;
+    int length = snprintf(text, size, "%.17g", c.f);
+    if (!strpbrk(text, ".e")) length += snprintf(text + length, size - length, ".0");
+    return length;
+}
+
+int constant_has_literal(Constant c) {
+    return c.type == TYPE_INTEGER ? c.i != LLONG_MIN : isfinite(c.f);
+}
+
+AstId constant_node(Ast* ast, Constant c) {
+    char text[48];
+    int length = literal_text(c, text, sizeof(text));
+    if (length < 0) return AST_NONE;
+    return create_node(ast, c.type == TYPE_INTEGER ? NODE_INT_LITERAL : NODE_FLOAT_LITERAL, intern(text, length));
+}
+
+int constant_replace_node(Ast* ast, AstId node, Constant c) {
+    char text[48];
+    int length = literal_text(c, text, sizeof(text));
+    if (length < 0) return 0;
+    ast->type[node] = (uint8_t)(c.type == TYPE_INTEGER ? NODE_INT_LITERAL : NODE_FLOAT_LITERAL);
+    ast->value[node] = intern(text, length);
+    ast->symbol[node] = NULL;
+    return 1;
+}
+
+void constant_print(FILE* out, Constant c) {
+    char text[48];
+    if (literal_text(c, text, sizeof(text)) >= 0) fputs(text, out);
+    else if (c.type == TYPE_INTEGER) fprintf(out, "%lld", c.i);
+    else fprintf(out, "%g", c.f);
+}
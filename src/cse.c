@@ -0,0 +1,507 @@
+#include "cse.h"
+#include "types.h"
+#include "constant.h"
+#include "diagnostic.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// o que se sabe de cada número de valor
+typedef struct {
+    uint8_t pure;           // sem chamadas nem divisões que possam falhar
+    uint8_t candidate;      // pura e não folha: vale a pena compartilhar
+    uint32_t region;        // região onde a expressão está disponível
+    AstId first;            // primeira ocorrência na região
+    int statement;          // índice, no bloco, da instrução que a contém
+    SymbolNode* holder;     // variável que já guarda o valor (ou NULL)
+    uint32_t holder_version;
+} Number;
+
+// entrada da tabela de hash-consing: (tipo do nó, operandos) -> número
+typedef struct {
+    uint32_t generation;    // a entrada só vale na função atual
+    uint32_t type;
+    uint32_t a;
+    uint32_t b;
+    uint32_t number;
+} ConsEntry;
+
+// atribuição a uma temporária, a inserir antes da instrução index
+typedef struct {
+    int index;
+    int order;              // ordem de criação
+    int level;              // profundidade de dependência entre temporárias
+    AstId node;
+    SymbolNode* temp;
+} Insertion;
+
+typedef struct {
+    AstId* statements;
+    int count;
+    Insertion* inserts;
+    int insert_count;
+    int insert_capacity;
+} BlockWalk;
+
+typedef struct {
+    Ast* ast;
+    SymbolTable* scope;
+    uint32_t* value;        // número de valor de cada nó original da AST
+
+    Number* numbers;        // o 0 fica reservado
+    int number_count;
+    int number_capacity;
+    ConsEntry* table;
+    int table_capacity;     // potência de 2
+    int table_count;
+    uint32_t generation;
+
+    // por endereço: a variável local, a versão atual e, para temporárias,
+    // a posição da inserção no bloco que a criou
+    SymbolNode** slot_symbol;
+    uint32_t* version;
+    int* insertion;
+    int slot_count;
+    int slot_capacity;
+    int temp_count;
+
+    uint32_t region;
+    BlockWalk* walk;
+} Cse;
+
+static void* grow_array(void* array, int* capacity, int needed, size_t element_size) {
+    if (needed <= *capacity) return array;
+    int bigger = *capacity ? *capacity : 16;
+    while (bigger < needed) bigger *= 2;
+    void* p = realloc(array, (size_t)bigger * element_size);
+    if (!p) compile_error("Erro: memória insuficiente para a eliminação de subexpressões.");
+    *capacity = bigger;
+    return p;
+}
+
+// ---------------------------------------------------------------------------
+// numeração de valores
+// ---------------------------------------------------------------------------
+
+static uint32_t new_number(Cse* c, int pure, int candidate) {
+    c->numbers = grow_array(c->numbers, &c->number_capacity, c->number_count + 1, sizeof(Number));
+    Number* n = &c->numbers[c->number_count];
+    memset(n, 0, sizeof(Number));
+    n->pure = (uint8_t)pure;
+    n->candidate = (uint8_t)candidate;
+    return (uint32_t)c->number_count++;
+}
+
+static uint32_t hash_key(uint32_t type, uint32_t a, uint32_t b) {
+    uint64_t h = ((uint64_t)type * 0x9E3779B97F4A7C15ull) ^ ((uint64_t)a * 0xC2B2AE3D27D4EB4Full) ^ ((uint64_t)b * 0x165667B19E3779F9ull);
+    return (uint32_t)(h >> 32) ^ (uint32_t)h;
+}
+
+static void rehash(Cse* c) {
+    int old_capacity = c->table_capacity;
+    ConsEntry* old = c->table;
+    c->table_capacity = old_capacity ? old_capacity * 2 : 1024;
+    c->table = (ConsEntry*)calloc(c->table_capacity, sizeof(ConsEntry));
+    if (!c->table) compile_error("Erro: memória insuficiente para a eliminação de subexpressões.");
+    uint32_t mask = (uint32_t)c->table_capacity - 1;
+    for (int i = 0; i < old_capacity; i++) {
+        if (old[i].generation != c->generation) continue;
+        uint32_t slot = hash_key(old[i].type, old[i].a, old[i].b) & mask;
+        while (c->table[slot].generation == c->generation) slot = (slot + 1) & mask;
+        c->table[slot] = old[i];
+    }
+    free(old);
+}
+
+// o número da chave, criado na primeira vez (hash-consing)
+static uint32_t cons(Cse* c, NodeType type, uint32_t a, uint32_t b, int candidate) {
+    if (2 * (c->table_count + 1) > c->table_capacity) rehash(c);
+    uint32_t mask = (uint32_t)c->table_capacity - 1;
+    uint32_t slot = hash_key(type, a, b) & mask;
+    while (c->table[slot].generation == c->generation) {
+        ConsEntry* e = &c->table[slot];
+        if (e->type == (uint32_t)type && e->a == a && e->b == b) return e->number;
+        slot = (slot + 1) & mask;
+    }
+    ConsEntry* e = &c->table[slot];
+    e->generation = c->generation;
+    e->type = (uint32_t)type;
+    e->a = a;
+    e->b = b;
+    e->number = new_number(c, 1, candidate);
+    c->table_count++;
+    return e->number;
+}
+
+// endereço da variável local, ou -1 (identificador que não é da função)
+static int slot_of(const Cse* c, const SymbolNode* sym) {
+    if (!sym || (sym->kind != KIND_VARIABLE && sym->kind != KIND_PARAMETER)) return -1;
+    if (sym->address < 0 || sym->address >= c->slot_count || c->slot_symbol[sym->address] != sym) return -1;
+    return sym->address;
+}
+
+static int is_commutative(NodeType type) {
+    return type == NODE_ADD || type == NODE_MUL || type == NODE_EQ || type == NODE_NEQ;
+}
+
+// numera a expressão de baixo para cima
+static uint32_t number(Cse* c, AstId node) {
+    Ast* ast = c->ast;
+    NodeType type = ast_type(ast, node);
+    uint32_t v;
+    switch (type) {
+        case NODE_INT_LITERAL:
+        case NODE_FLOAT_LITERAL:
+            v = cons(c, type, ast_name(ast, node), 0, 0);
+            break;
+
+        case NODE_IDENTIFIER: {
+            int slot = slot_of(c, ast_symbol(ast, node));
+            v = slot >= 0 ? cons(c, type, (uint32_t)slot, c->version[slot], 0) : new_number(c, 0, 0);
+            break;
+        }
+
+        case NODE_FUNC_CALL: {
+            AstId args = ast_child(ast, node);
+            for (AstId a = args ? ast_child(ast, args) : AST_NONE; a; a = ast_sibling(ast, a)) number(c, a);
+            v = new_number(c, 0, 0);
+            break;
+        }
+
+        case NODE_NEGATE: {
+            uint32_t x = number(c, ast_child(ast, node));
+            v = c->numbers[x].pure ? cons(c, type, x, 0, 1) : new_number(c, 0, 0);
+            break;
+        }
+
+        default: {
+            AstId left = ast_child(ast, node), right = ast_sibling(ast, left);
+            uint32_t a = number(c, left), b = number(c, right);
+            int pure = c->numbers[a].pure && c->numbers[b].pure;
+            // divisão inteira só com divisor literal diferente de zero
+            if (type == NODE_DIV && operand_type(ast, node) == TYPE_INTEGER &&
+                (ast_type(ast, right) != NODE_INT_LITERAL || constant_of_literal(ast, right).i == 0)) pure = 0;
+            if (!pure) {
+                v = new_number(c, 0, 0);
+                break;
+            }
+            if (is_commutative(type) && a > b) {
+                uint32_t t = a;
+                a = b;
+                b = t;
+            }
+            v = cons(c, type, a, b, 1);
+            break;
+        }
+    }
+    c->value[node] = v;
+    return v;
+}
+
+// ---------------------------------------------------------------------------
+// compartilhamento
+// ---------------------------------------------------------------------------
+
+static void ensure_slots(Cse* c, int count) {
+    int capacity = c->slot_capacity;
+    c->slot_symbol = grow_array(c->slot_symbol, &capacity, count, sizeof(SymbolNode*));
+    capacity = c->slot_capacity;
+    c->version = grow_array(c->version, &capacity, count, sizeof(uint32_t));
+    capacity = c->slot_capacity;
+    c->insertion = grow_array(c->insertion, &capacity, count, sizeof(int));
+    for (int i = c->slot_count; i < count; i++) {
+        c->slot_symbol[i] = NULL;
+        c->version[i] = 0;
+        c->insertion[i] = -1;
+    }
+    c->slot_capacity = capacity;
+    c->slot_count = count;
+}
+
+// uma atribuição a x mata as expressões que usam x
+static void bump(Cse* c, SymbolNode* sym) {
+    int slot = slot_of(c, sym);
+    if (slot >= 0) c->version[slot]++;
+}
+
+// troca o nó, no lugar, pela leitura da variável
+static void become_variable(Ast* ast, AstId node, SymbolNode* sym) {
+    ast->type[node] = NODE_IDENTIFIER;
+    ast->value[node] = sym->id;
+    ast->child[node] = AST_NONE;
+    ast->last_child[node] = AST_NONE;
+    ast->symbol[node] = sym;
+}
+
+static SymbolNode* new_temp(Cse* c, SymbolDataType type) {
+    char name[32];
+    NameId id;
+    do {
+        int length = snprintf(name, sizeof(name), "_cse%d", ++c->temp_count);
+        id = intern(name, length);
+    } while (scope_lookup_current(c->scope, id));
+    int address = c->slot_count;
+    SymbolNode* temp = scope_insert(c->scope, id, KIND_VARIABLE, type, 0, address);
+    ensure_slots(c, address + 1);
+    c->slot_symbol[address] = temp;
+    return temp;
+}
+
+// passa a primeira ocorrência para uma temporária calculada antes da
+// instrução que a contém, e devolve a temporária
+static SymbolNode* make_temp(Cse* c, Number* n) {
+    Ast* ast = c->ast;
+    AstId first = n->first;
+    SymbolNode* temp = new_temp(c, expr_type(ast, first));
+
+    AstId moved = create_node(ast, ast_type(ast, first), ast_name(ast, first));
+    ast->child[moved] = ast->child[first];
+    ast->last_child[moved] = ast->last_child[first];
+    ast->symbol[moved] = ast->symbol[first];
+    become_variable(ast, first, temp);
+    AstId assign = create_node(ast, NODE_ASSIGNMENT, temp->id);
+    ast_set_symbol(ast, assign, temp);
+    add_child(ast, assign, moved);
+
+    BlockWalk* w = c->walk;
+    w->inserts = grow_array(w->inserts, &w->insert_capacity, w->insert_count + 1, sizeof(Insertion));
+    Insertion* ins = &w->inserts[w->insert_count];
+    ins->index = n->statement;
+    ins->order = w->insert_count;
+    ins->level = -1;
+    ins->node = assign;
+    ins->temp = temp;
+    c->insertion[temp->address] = w->insert_count++;
+
+    n->holder = temp;
+    n->holder_version = c->version[temp->address];
+    return temp;
+}
+
+static void share(Cse* c, AstId node, int statement) {
+    Ast* ast = c->ast;
+    NodeType type = ast_type(ast, node);
+    if (type == NODE_INT_LITERAL || type == NODE_FLOAT_LITERAL || type == NODE_IDENTIFIER) return;
+
+    if (type == NODE_FUNC_CALL) {
+        AstId args = ast_child(ast, node);
+        for (AstId a = args ? ast_child(ast, args) : AST_NONE; a; a = ast_sibling(ast, a)) share(c, a, statement);
+        return;
+    }
+
+    uint32_t v = c->value[node];
+    if (c->numbers[v].candidate && c->numbers[v].region == c->region) {
+        // já calculada neste bloco: lê a variável que guarda o valor
+        Number* n = &c->numbers[v];
+        SymbolNode* holder = n->holder;
+        if (!holder || c->version[holder->address] != n->holder_version) holder = make_temp(c, n);
+        become_variable(ast, node, holder);
+        return;
+    }
+
+    for (AstId child = ast_child(ast, node); child; child = ast_sibling(ast, child)) share(c, child, statement);
+    if (c->numbers[v].candidate) {
+        Number* n = &c->numbers[v];
+        n->region = c->region;
+        n->first = node;
+        n->statement = statement;
+        n->holder = NULL;
+    }
+}
+
+static void expression(Cse* c, AstId node, int statement) {
+    number(c, node);
+    share(c, node, statement);
+}
+
+// x = e: daqui em diante x guarda o valor de e (até x mudar)
+static void assignment(Cse* c, AstId node, int statement) {
+    Ast* ast = c->ast;
+    AstId rhs = ast_child(ast, node);
+    SymbolNode* sym = ast_symbol(ast, node);
+    SymbolDataType rhs_type = expr_type(ast, rhs);
+    expression(c, rhs, statement);
+    bump(c, sym);
+    int slot = slot_of(c, sym);
+    Number* n = &c->numbers[c->value[rhs]];
+    if (slot >= 0 && n->candidate && n->region == c->region && rhs_type == sym->type) {
+        n->holder = sym;
+        n->holder_version = c->version[slot];
+    }
+}
+
+// ---------------------------------------------------------------------------
+// blocos
+// ---------------------------------------------------------------------------
+
+static int insertion_level(Cse* c, BlockWalk* w, Insertion* ins);
+
+// maior nível entre as temporárias deste bloco lidas na expressão
+static int reads_level(Cse* c, BlockWalk* w, AstId node) {
+    int level = -1;
+    for (; node; node = ast_sibling(c->ast, node)) {
+        if (ast_type(c->ast, node) == NODE_IDENTIFIER) {
+            SymbolNode* sym = ast_symbol(c->ast, node);
+            int slot = slot_of(c, sym);
+            int index = slot >= 0 ? c->insertion[slot] : -1;
+            if (index >= 0 && index < w->insert_count && w->inserts[index].temp == sym) {
+                int l = insertion_level(c, w, &w->inserts[index]);
+                if (l > level) level = l;
+            }
+        }
+        int l = reads_level(c, w, ast_child(c->ast, node));
+        if (l > level) level = l;
+    }
+    return level;
+}
+
+// uma temporária que lê outra vem depois dela
+static int insertion_level(Cse* c, BlockWalk* w, Insertion* ins) {
+    if (ins->level < 0) ins->level = reads_level(c, w, ast_child(c->ast, ins->node)) + 1;
+    return ins->level;
+}
+
+static int compare_insertions(const void* x, const void* y) {
+    const Insertion* a = (const Insertion*)x;
+    const Insertion* b = (const Insertion*)y;
+    if (a->index != b->index) return a->index - b->index;
+    if (a->level != b->level) return a->level - b->level;
+    return a->order - b->order;
+}
+
+// religa o bloco com as atribuições às temporárias no lugar
+static void finish_block(Cse* c, AstId block, BlockWalk* w) {
+    if (w->insert_count == 0) return;
+    for (int i = 0; i < w->insert_count; i++) insertion_level(c, w, &w->inserts[i]);
+    qsort(w->inserts, w->insert_count, sizeof(Insertion), compare_insertions);
+
+    Ast* ast = c->ast;
+    AstId last = AST_NONE;
+    int k = 0;
+    for (int i = 0; i < w->count; i++) {
+        for (; k < w->insert_count && w->inserts[k].index == i; k++) {
+            AstId node = w->inserts[k].node;
+            if (last) ast->sibling[last] = node;
+            else ast->child[block] = node;
+            last = node;
+        }
+        if (last) ast->sibling[last] = w->statements[i];
+        else ast->child[block] = w->statements[i];
+        last = w->statements[i];
+    }
+    ast->sibling[last] = AST_NONE;
+    ast->last_child[block] = last;
+}
+
+static void walk_block(Cse* c, AstId block);
+
+static void walk_statement(Cse* c, AstId node, int statement) {
+    Ast* ast = c->ast;
+    switch (ast_type(ast, node)) {
+        case NODE_DECLARATION:
+            bump(c, ast_symbol(ast, node));
+            break;
+
+        case NODE_DECL_ASSIGN:
+            walk_statement(c, ast_child(ast, node), statement);
+            walk_statement(c, ast_sibling(ast, ast_child(ast, node)), statement);
+            break;
+
+        case NODE_ASSIGNMENT:
+            assignment(c, node, statement);
+            break;
+
+        case NODE_RETURN_STMT:
+        case NODE_FUNC_CALL:
+            expression(c, ast_type(ast, node) == NODE_FUNC_CALL ? node : ast_child(ast, node), statement);
+            break;
+
+        case NODE_PRINT:
+            for (AstId a = ast_child(ast, ast_child(ast, node)); a; a = ast_sibling(ast, a)) expression(c, a, statement);
+            break;
+
+        case NODE_SCAN:
+            for (AstId a = ast_child(ast, ast_child(ast, node)); a; a = ast_sibling(ast, a)) {
+                if (ast_type(ast, a) == NODE_IDENTIFIER) bump(c, ast_symbol(ast, a));
+            }
+            break;
+
+        case NODE_CONDITIONAL: {
+            // a condição ainda faz parte do bloco básico atual
+            AstId cond = ast_child(ast, node);
+            expression(c, cond, statement);
+            for (AstId b = ast_sibling(ast, cond); b; b = ast_sibling(ast, b)) walk_block(c, b);
+            c->region++;
+            break;
+        }
+
+        case NODE_LOOP:
+            // a condição é calculada de novo a cada volta: fica de fora
+            walk_block(c, ast_sibling(ast, ast_child(ast, node)));
+            c->region++;
+            break;
+
+        case NODE_BLOCK:
+            walk_block(c, node);
+            c->region++;
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void walk_block(Cse* c, AstId block) {
+    Ast* ast = c->ast;
+    BlockWalk w;
+    memset(&w, 0, sizeof(BlockWalk));
+    for (AstId s = ast_child(ast, block); s; s = ast_sibling(ast, s)) w.count++;
+    if (w.count == 0) return;
+    w.statements = (AstId*)malloc(w.count * sizeof(AstId));
+    if (!w.statements) compile_error("Erro: memória insuficiente para a eliminação de subexpressões.");
+    int i = 0;
+    for (AstId s = ast_child(ast, block); s; s = ast_sibling(ast, s)) w.statements[i++] = s;
+
+    BlockWalk* outer = c->walk;
+    c->walk = &w;
+    c->region++;
+    for (i = 0; i < w.count; i++) walk_statement(c, w.statements[i], i);
+    finish_block(c, block, &w);
+    c->walk = outer;
+    free(w.statements);
+    free(w.inserts);
+}
+
+static void optimize_function(Cse* c, AstId body, SymbolTable* scope) {
+    c->scope = scope;
+    c->generation++;
+    c->table_count = 0;
+    c->number_count = 1;
+    c->temp_count = 0;
+    c->slot_count = 0;
+    ensure_slots(c, scope_frame_size(scope));
+    for (SymbolNode* sym = scope->first; sym; sym = sym->next) {
+        if (sym->kind == KIND_VARIABLE || sym->kind == KIND_PARAMETER) c->slot_symbol[sym->address] = sym;
+    }
+    walk_block(c, body);
+}
+
+void cse_optimize_ast(Ast* ast, SymbolTable* global_scope) {
+    Cse c;
+    memset(&c, 0, sizeof(Cse));
+    c.ast = ast;
+    // só os nós que já existem são numerados; os criados aqui não são
+    // visitados de novo
+    c.value = (uint32_t*)calloc(ast->count, sizeof(uint32_t));
+    if (!c.value) compile_error("Erro: memória insuficiente para a eliminação de subexpressões.");
+    for (AstId n = ast_child(ast, ast->root); n; n = ast_sibling(ast, n)) {
+        if (ast_type(ast, n) == NODE_FUNC_DECL) optimize_function(&c, ast_sibling(ast, ast_child(ast, n)), ast_scope(ast, n));
+        else optimize_function(&c, n, global_scope);
+    }
+    free(c.value);
+    free(c.numbers);
+    free(c.table);
+    free(c.slot_symbol);
+    free(c.version);
+    free(c.insertion);
+}
@@ -0,0 +1,35 @@
+#include "diagnostic.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// cada thread tem a sua pilha de armadilhas
+static __thread ErrorTrap* current_trap = NULL;
+
+void error_trap_push(ErrorTrap* trap) {
+    trap->message[0] = '\0';
+    trap->previous = current_trap;
+    current_trap = trap;
+}
+
+void error_trap_pop(ErrorTrap* trap) {
+    current_trap = trap->previous;
+}
+
+int error_trap_active(void) {
+    return current_trap != NULL;
+}
+
+void compile_error(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    if (current_trap) {
+        vsnprintf(current_trap->message, sizeof(current_trap->message), format, args);
+        va_end(args);
+        longjmp(current_trap->jump, 1);
+    }
+    vfprintf(stderr, format, args);
+    va_end(args);
+    fputc('\n', stderr);
+    exit(EXIT_FAILURE);
+}
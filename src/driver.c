@@ -0,0 +1,199 @@
+#include "driver.h"
+#include "source.h"
+#include "threadpool.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+// um arquivo a compilar e, depois da tarefa, o resultado
+typedef struct {
+    char* path;
+    size_t size;            // para enviar os maiores primeiro
+    CompileOptions options;
+    int ok;
+    char* message;          // diagnóstico (malloc), ou NULL
+} FileJob;
+
+typedef struct {
+    FileJob* jobs;
+    int count;
+    int capacity;
+} JobList;
+
+static void driver_error(const char* message, const char* path) {
+    fprintf(stderr, "%s \"%s\".\n", message, path);
+    exit(74);
+}
+
+char* default_output_path(const char* input, const char* extension) {
+    if (strcmp(input, "-") == 0) input = "saida";
+    size_t length = strlen(input);
+    if (length > 5 && strcmp(input + length - 5, ".lang") == 0) length -= 5;
+    char* path = (char*)malloc(length + strlen(extension) + 1);
+    memcpy(path, input, length);
+    strcpy(path + length, extension);
+    return path;
+}
+
+int is_directory(const char* path) {
+    struct stat info;
+    return stat(path, &info) == 0 && S_ISDIR(info.st_mode);
+}
+
+static void add_job(JobList* list, char* path, size_t size) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? 2 * list->capacity : 64;
+        list->jobs = (FileJob*)realloc(list->jobs, list->capacity * sizeof(FileJob));
+        if (!list->jobs) driver_error("Memória insuficiente para compilar", path);
+    }
+    FileJob* job = &list->jobs[list->count++];
+    memset(job, 0, sizeof(FileJob));
+    job->path = path;
+    job->size = size;
+}
+
+static int compare_names(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+static int has_lang_extension(const char* name) {
+    size_t length = strlen(name);
+    return length > 5 && strcmp(name + length - 5, ".lang") == 0;
+}
+
+// junta os .lang de dir (e dos subdiretórios) em ordem de nome, para que a
+// ordem dos arquivos, e portanto a dos erros, seja sempre a mesma
+static void collect_directory(JobList* list, const char* dir) {
+    DIR* handle = opendir(dir);
+    if (!handle) driver_error("Não foi possível abrir o diretório", dir);
+
+    char** names = NULL;
+    int count = 0, capacity = 0;
+    for (struct dirent* entry; (entry = readdir(handle)) != NULL;) {
+        if (entry->d_name[0] == '.') continue;
+        if (count == capacity) {
+            capacity = capacity ? 2 * capacity : 32;
+            names = (char**)realloc(names, capacity * sizeof(char*));
+            if (!names) driver_error("Memória insuficiente para ler o diretório", dir);
+        }
+        names[count++] = strdup(entry->d_name);
+    }
+    closedir(handle);
+    qsort(names, count, sizeof(char*), compare_names);
+
+    size_t dir_length = strlen(dir);
+    while (dir_length > 1 && dir[dir_length - 1] == '/') dir_length--;
+    for (int i = 0; i < count; i++) {
+        char* path = (char*)malloc(dir_length + strlen(names[i]) + 2);
+        sprintf(path, "%.*s/%s", (int)dir_length, dir, names[i]);
+        free(names[i]);
+        struct stat info;
+        if (stat(path, &info) != 0) {
+            free(path);
+            continue;
+        }
+        if (S_ISDIR(info.st_mode)) {
+            collect_directory(list, path);
+            free(path);
+        } else if (S_ISREG(info.st_mode) && has_lang_extension(path)) {
+            add_job(list, path, (size_t)info.st_size);
+        } else {
+            free(path);
+        }
+    }
+    free(names);
+}
+
+// guarda o diagnóstico do job para ser impresso no fim
+static void fail(FileJob* job, const char* message) {
+    job->ok = 0;
+    job->message = strdup(message);
+    if (!job->message) driver_error("Memória insuficiente para compilar", job->path);
+}
+
+// escreve o código gerado no arquivo de saída do job
+static void write_output(FileJob* job, const CompileResult* result) {
+    char* out_path = default_output_path(job->path, job->options.target == COMPILE_EMIT_ASM ? ".s" : ".c");
+    FILE* out = fopen(out_path, "w");
+    if (!out || fwrite(result->output, 1, result->output_length, out) != result->output_length) {
+        char message[DIAGNOSTIC_MESSAGE_SIZE];
+        snprintf(message, sizeof(message), "Não foi possível criar o arquivo \"%s\".", out_path);
+        fail(job, message);
+    }
+    if (out && fclose(out) != 0 && job->ok) fail(job, "Erro ao gravar o arquivo gerado.");
+    free(out_path);
+}
+
+static void compile_file_task(void* arg) {
+    FileJob* job = (FileJob*)arg;
+
+    // um arquivo que não abre vira diagnóstico deste job, não fim do processo
+    ErrorTrap trap;
+    error_trap_push(&trap);
+    if (setjmp(trap.jump)) {
+        error_trap_pop(&trap);
+        fail(job, trap.message);
+        return;
+    }
+    Source* source = source_open(job->path);
+    error_trap_pop(&trap);
+
+    CompileResult result;
+    job->ok = compile_source(source->text, source->length, &job->options, &result);
+    source_close(source);
+    if (!job->ok) {
+        fail(job, result.error);
+        return;
+    }
+    if (job->options.target != COMPILE_CHECK) write_output(job, &result);
+    compile_result_free(&result);
+}
+
+// os maiores primeiro, para que nenhum arquivo grande fique para o fim
+// sozinho numa thread enquanto as outras já terminaram
+static int compare_size_descending(const void* a, const void* b) {
+    size_t sa = (*(FileJob* const*)a)->size, sb = (*(FileJob* const*)b)->size;
+    return sa < sb ? 1 : sa > sb ? -1 : 0;
+}
+
+int driver_compile_files(char* const* paths, int count, const CompileOptions* options) {
+    JobList list = { NULL, 0, 0 };
+    for (int i = 0; i < count; i++) {
+        if (is_directory(paths[i])) {
+            collect_directory(&list, paths[i]);
+            continue;
+        }
+        struct stat info;
+        add_job(&list, strdup(paths[i]), stat(paths[i], &info) == 0 ? (size_t)info.st_size : 0);
+    }
+
+    FileJob** order = (FileJob**)malloc((list.count ? list.count : 1) * sizeof(FileJob*));
+    if (!order) driver_error("Memória insuficiente para compilar", paths[0]);
+    for (int i = 0; i < list.count; i++) {
+        list.jobs[i].options = *options;
+        order[i] = &list.jobs[i];
+    }
+    qsort(order, list.count, sizeof(FileJob*), compare_size_descending);
+
+    ThreadPool* pool = thread_pool_shared();
+    TaskGroup group = TASK_GROUP_INIT;
+    for (int i = 0; i < list.count; i++) thread_pool_submit(pool, &group, compile_file_task, order[i]);
+    thread_pool_wait(pool, &group);
+    free(order);
+
+    // os diagnósticos saem na ordem dos arquivos, não na de término
+    int status = EXIT_SUCCESS;
+    for (int i = 0; i < list.count; i++) {
+        FileJob* job = &list.jobs[i];
+        if (!job->ok) {
+            fprintf(stderr, "%s: %s\n", job->path, job->message);
+            status = EXIT_FAILURE;
+        }
+        free(job->message);
+        free(job->path);
+    }
+    free(list.jobs);
+    return status;
+}
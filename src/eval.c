@@ -0,0 +1,597 @@
+#include "eval.h"
+#include "types.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_CALL_DEPTH 20000
+
+typedef union {
+    long long i;
+    double f;
+} EvalValue;
+
+// variáveis da chamada em andamento, indexadas pelo endereço do símbolo
+typedef struct {
+    EvalValue* locals;
+    EvalValue ret;
+} Frame;
+
+typedef struct Expr Expr;
+typedef struct Stmt Stmt;
+typedef struct EvalFunction EvalFunction;
+
+typedef EvalValue (*ExprFn)(const Expr* e, Frame* f);
+// devolve 1 quando um return foi executado
+typedef int (*StmtFn)(const Stmt* s, Frame* f);
+
+struct Expr {
+    ExprFn fn;
+    int a, b;               // endereços de variáveis
+    EvalValue k;            // constante
+    const Expr* x;
+    const Expr* y;
+    const EvalFunction* callee;
+    const Expr** args;
+    int argc;
+};
+
+struct Stmt {
+    StmtFn fn;
+    int a;                  // endereço de destino ou caractere final do print
+    EvalValue k;
+    const Expr* x;          // valor ou condição
+    const Stmt* body;       // bloco do then ou do laço
+    const Stmt* other;      // bloco do else
+    const Stmt** list;      // instruções de um bloco
+    int count;
+};
+
+struct EvalFunction {
+    const char* name;
+    AstId decl;             // AST_NONE no bloco principal
+    SymbolTable* scope;
+    AstId body_node;
+    SymbolDataType return_type;
+    int param_count;
+    int* param_addresses;
+    SymbolDataType* param_types;
+    int frame_size;
+    const Stmt* body;
+};
+
+typedef struct {
+    const Ast* ast;
+    Arena* arena;           // closures, liberadas juntas no fim
+    EvalFunction* functions;
+    int function_count;
+    SymbolDataType return_type;
+} Evaluator;
+
+static int call_depth = 0;
+
+static void eval_error(const char* message, const char* name) {
+    fprintf(stderr, "Erro do Interpretador: %s", message);
+    if (name) fprintf(stderr, " ('%s')", name);
+    fprintf(stderr, ".\n");
+    exit(EXIT_FAILURE);
+}
+
+static void runtime_error(const char* message) {
+    fflush(stdout);
+    fprintf(stderr, "Erro de Execução: %s.\n", message);
+    exit(EXIT_FAILURE);
+}
+
+// ---------------------------------------------------------------------------
+// closures de expressão
+// ---------------------------------------------------------------------------
+
+#define EVAL(e) ((e)->fn((e), f))
+
+static EvalValue ex_const(const Expr* e, Frame* f) { (void)f; return e->k; }
+static EvalValue ex_local(const Expr* e, Frame* f) { return f->locals[e->a]; }
+
+static EvalValue ex_i2f(const Expr* e, Frame* f) { EvalValue v; v.f = (double)EVAL(e->x).i; return v; }
+static EvalValue ex_f2i(const Expr* e, Frame* f) { EvalValue v; v.i = (long long)EVAL(e->x).f; return v; }
+static EvalValue ex_negi(const Expr* e, Frame* f) { EvalValue v; v.i = -EVAL(e->x).i; return v; }
+static EvalValue ex_negf(const Expr* e, Frame* f) { EvalValue v; v.f = -EVAL(e->x).f; return v; }
+
+// para cada operador inteiro: expressão-expressão, variável-constante e variável-variável
+#define INT_BINARY(name, op) \
+    static EvalValue ex_##name##_ee(const Expr* e, Frame* f) { \
+        EvalValue v; long long l = EVAL(e->x).i; v.i = l op EVAL(e->y).i; return v; } \
+    static EvalValue ex_##name##_lk(const Expr* e, Frame* f) { \
+        EvalValue v; v.i = f->locals[e->a].i op e->k.i; return v; } \
+    static EvalValue ex_##name##_ll(const Expr* e, Frame* f) { \
+        EvalValue v; v.i = f->locals[e->a].i op f->locals[e->b].i; return v; }
+
+INT_BINARY(add, +)
+INT_BINARY(sub, -)
+INT_BINARY(mul, *)
+INT_BINARY(eq, ==)
+INT_BINARY(ne, !=)
+INT_BINARY(lt, <)
+INT_BINARY(le, <=)
+INT_BINARY(gt, >)
+INT_BINARY(ge, >=)
+
+#define FLOAT_BINARY(name, op, field) \
+    static EvalValue ex_##name(const Expr* e, Frame* f) { \
+        EvalValue v; double l = EVAL(e->x).f; v.field = l op EVAL(e->y).f; return v; }
+
+FLOAT_BINARY(addf, +, f)
+FLOAT_BINARY(subf, -, f)
+FLOAT_BINARY(mulf, *, f)
+FLOAT_BINARY(divf, /, f)
+FLOAT_BINARY(eqf, ==, i)
+FLOAT_BINARY(nef, !=, i)
+FLOAT_BINARY(ltf, <, i)
+FLOAT_BINARY(lef, <=, i)
+FLOAT_BINARY(gtf, >, i)
+FLOAT_BINARY(gef, >=, i)
+
+static long long checked_div(long long a, long long b) {
+    if (b == 0) runtime_error("divisão por zero");
+    return b == -1 ? -a : a / b;
+}
+
+static EvalValue ex_div_ee(const Expr* e, Frame* f) {
+    EvalValue v; long long l = EVAL(e->x).i; v.i = checked_div(l, EVAL(e->y).i); return v;
+}
+
+// divisor constante diferente de zero e de -1: nada a checar
+static EvalValue ex_div_lk(const Expr* e, Frame* f) {
+    EvalValue v; v.i = f->locals[e->a].i / e->k.i; return v;
+}
+
+static EvalValue ex_call(const Expr* e, Frame* f) {
+    const EvalFunction* fn = e->callee;
+    EvalValue locals[fn->frame_size];
+    memset(locals, 0, sizeof(locals));
+    for (int i = 0; i < e->argc; i++) {
+        locals[fn->param_addresses[i]] = EVAL(e->args[i]);
+    }
+    if (++call_depth > MAX_CALL_DEPTH) runtime_error("estouro da pilha de chamadas");
+    Frame callee = { locals, { 0 } };
+    fn->body->fn(fn->body, &callee);
+    call_depth--;
+    return callee.ret;
+}
+
+// ---------------------------------------------------------------------------
+// closures de instrução
+// ---------------------------------------------------------------------------
+
+static int st_nop(const Stmt* s, Frame* f) { (void)s; (void)f; return 0; }
+static int st_zero(const Stmt* s, Frame* f) { f->locals[s->a].i = 0; return 0; }
+static int st_assign(const Stmt* s, Frame* f) { f->locals[s->a] = EVAL(s->x); return 0; }
+static int st_store_const(const Stmt* s, Frame* f) { f->locals[s->a] = s->k; return 0; }
+static int st_add_const(const Stmt* s, Frame* f) { f->locals[s->a].i += s->k.i; return 0; }
+static int st_eval(const Stmt* s, Frame* f) { EVAL(s->x); return 0; }
+
+static int st_return(const Stmt* s, Frame* f) {
+    f->ret = EVAL(s->x);
+    return 1;
+}
+
+static int st_block(const Stmt* s, Frame* f) {
+    for (int i = 0; i < s->count; i++) {
+        const Stmt* stmt = s->list[i];
+        if (stmt->fn(stmt, f)) return 1;
+    }
+    return 0;
+}
+
+static int st_if(const Stmt* s, Frame* f) {
+    if (EVAL(s->x).i) return s->body->fn(s->body, f);
+    return 0;
+}
+
+static int st_if_else(const Stmt* s, Frame* f) {
+    if (EVAL(s->x).i) return s->body->fn(s->body, f);
+    return s->other->fn(s->other, f);
+}
+
+static int st_while(const Stmt* s, Frame* f) {
+    while (EVAL(s->x).i) {
+        if (s->body->fn(s->body, f)) return 1;
+    }
+    return 0;
+}
+
+static int st_print_int(const Stmt* s, Frame* f) { printf("%lld%c", EVAL(s->x).i, s->a); return 0; }
+static int st_print_float(const Stmt* s, Frame* f) { printf("%g%c", EVAL(s->x).f, s->a); return 0; }
+static int st_newline(const Stmt* s, Frame* f) { (void)s; (void)f; putchar('\n'); return 0; }
+
+static int st_scan_int(const Stmt* s, Frame* f) {
+    if (scanf("%lld", &f->locals[s->a].i) != 1) runtime_error("entrada inválida para scan");
+    return 0;
+}
+
+static int st_scan_float(const Stmt* s, Frame* f) {
+    if (scanf("%lf", &f->locals[s->a].f) != 1) runtime_error("entrada inválida para scan");
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// conversão da AST em closures
+// ---------------------------------------------------------------------------
+
+static Expr* new_expr(Evaluator* ev, ExprFn fn) {
+    Expr* e = (Expr*)arena_calloc(ev->arena, sizeof(Expr));
+    e->fn = fn;
+    return e;
+}
+
+static Stmt* new_stmt(Evaluator* ev, StmtFn fn) {
+    Stmt* s = (Stmt*)arena_calloc(ev->arena, sizeof(Stmt));
+    s->fn = fn;
+    return s;
+}
+
+// variável ligada ao nó pelo parser
+static SymbolNode* node_variable(Evaluator* ev, AstId node) {
+    SymbolNode* sym = ast_symbol(ev->ast, node);
+    if (sym->kind != KIND_VARIABLE && sym->kind != KIND_PARAMETER) {
+        eval_error("identificador não é uma variável", sym->name);
+    }
+    return sym;
+}
+
+static EvalFunction* find_function(Evaluator* ev, NameId name) {
+    for (int i = 0; i < ev->function_count; i++) {
+        if (ev->functions[i].decl && ast_name(ev->ast, ev->functions[i].decl) == name) return &ev->functions[i];
+    }
+    eval_error("função desconhecida", intern_name(name));
+    return NULL;
+}
+
+static const Expr* compile_expr(Evaluator* ev, AstId node);
+
+static const Expr* compile_expr_as(Evaluator* ev, AstId node, SymbolDataType type) {
+    const Expr* e = compile_expr(ev, node);
+    if (expr_type(ev->ast, node) == type) return e;
+    Expr* conv = new_expr(ev, type == TYPE_FLOAT ? ex_i2f : ex_f2i);
+    conv->x = e;
+    return conv;
+}
+
+static int is_int_local(Evaluator* ev, AstId node) {
+    return ast_type(ev->ast, node) == NODE_IDENTIFIER && node_variable(ev, node)->type == TYPE_INTEGER;
+}
+
+// operador com os operandos trocados: a op b == b mirror(op) a
+static NodeType mirror(NodeType type) {
+    switch (type) {
+        case NODE_LT: return NODE_GT;
+        case NODE_LTE: return NODE_GTE;
+        case NODE_GT: return NODE_LT;
+        case NODE_GTE: return NODE_LTE;
+        case NODE_SUB: case NODE_DIV: return (NodeType)-1;
+        default: return type;   // +, *, ==, != comutam
+    }
+}
+
+static const Expr* compile_int_binary(Evaluator* ev, AstId node) {
+    AstId left = ast_child(ev->ast, node);
+    AstId right = ast_sibling(ev->ast, left);
+    NodeType op = ast_type(ev->ast, node);
+
+    // deixa a variável à esquerda quando o outro lado é constante
+    if (ast_type(ev->ast, left) == NODE_INT_LITERAL && is_int_local(ev, right) && mirror(op) != (NodeType)-1) {
+        AstId t = left; left = right; right = t;
+        op = mirror(op);
+    }
+
+    ExprFn ee, lk, ll;
+    switch (op) {
+        case NODE_ADD: ee = ex_add_ee; lk = ex_add_lk; ll = ex_add_ll; break;
+        case NODE_SUB: ee = ex_sub_ee; lk = ex_sub_lk; ll = ex_sub_ll; break;
+        case NODE_MUL: ee = ex_mul_ee; lk = ex_mul_lk; ll = ex_mul_ll; break;
+        case NODE_EQ:  ee = ex_eq_ee;  lk = ex_eq_lk;  ll = ex_eq_ll; break;
+        case NODE_NEQ: ee = ex_ne_ee;  lk = ex_ne_lk;  ll = ex_ne_ll; break;
+        case NODE_LT:  ee = ex_lt_ee;  lk = ex_lt_lk;  ll = ex_lt_ll; break;
+        case NODE_LTE: ee = ex_le_ee;  lk = ex_le_lk;  ll = ex_le_ll; break;
+        case NODE_GT:  ee = ex_gt_ee;  lk = ex_gt_lk;  ll = ex_gt_ll; break;
+        case NODE_GTE: ee = ex_ge_ee;  lk = ex_ge_lk;  ll = ex_ge_ll; break;
+        default:       ee = ex_div_ee; lk = ex_div_lk; ll = NULL; break;
+    }
+
+    if (is_int_local(ev, left)) {
+        int a = node_variable(ev, left)->address;
+        if (ast_type(ev->ast, right) == NODE_INT_LITERAL) {
+            long long k = strtoll(ast_value(ev->ast, right), NULL, 10);
+            // a divisão só dispensa a checagem com divisor seguro
+            if (op != NODE_DIV || (k != 0 && k != -1)) {
+                Expr* e = new_expr(ev, lk);
+                e->a = a;
+                e->k.i = k;
+                return e;
+            }
+        } else if (is_int_local(ev, right) && ll) {
+            Expr* e = new_expr(ev, ll);
+            e->a = a;
+            e->b = node_variable(ev, right)->address;
+            return e;
+        }
+    }
+    Expr* e = new_expr(ev, ee);
+    e->x = compile_expr(ev, left);
+    e->y = compile_expr(ev, right);
+    return e;
+}
+
+static const Expr* compile_float_binary(Evaluator* ev, AstId node) {
+    ExprFn fn;
+    switch (ast_type(ev->ast, node)) {
+        case NODE_ADD: fn = ex_addf; break;
+        case NODE_SUB: fn = ex_subf; break;
+        case NODE_MUL: fn = ex_mulf; break;
+        case NODE_DIV: fn = ex_divf; break;
+        case NODE_EQ:  fn = ex_eqf; break;
+        case NODE_NEQ: fn = ex_nef; break;
+        case NODE_LT:  fn = ex_ltf; break;
+        case NODE_LTE: fn = ex_lef; break;
+        case NODE_GT:  fn = ex_gtf; break;
+        default:       fn = ex_gef; break;
+    }
+    Expr* e = new_expr(ev, fn);
+    e->x = compile_expr_as(ev, ast_child(ev->ast, node), TYPE_FLOAT);
+    e->y = compile_expr_as(ev, ast_sibling(ev->ast, ast_child(ev->ast, node)), TYPE_FLOAT);
+    return e;
+}
+
+static const Expr* compile_call(Evaluator* ev, AstId node) {
+    // as funções estão na ordem de declaração, a mesma de symbol->order
+    EvalFunction* callee = &ev->functions[ast_symbol(ev->ast, node)->order];
+    Expr* e = new_expr(ev, ex_call);
+    e->callee = callee;
+    for (AstId a = ast_child(ev->ast, node) ? ast_child(ev->ast, ast_child(ev->ast, node)) : AST_NONE; a; a = ast_sibling(ev->ast, a)) e->argc++;
+    if (e->argc != callee->param_count) eval_error("número de argumentos incorreto na chamada", ast_value(ev->ast, node));
+    e->args = (const Expr**)arena_calloc(ev->arena, (e->argc ? e->argc : 1) * sizeof(Expr*));
+    int i = 0;
+    for (AstId a = ast_child(ev->ast, ast_child(ev->ast, node)); a; a = ast_sibling(ev->ast, a), i++) {
+        e->args[i] = compile_expr_as(ev, a, callee->param_types[i]);
+    }
+    return e;
+}
+
+static const Expr* compile_expr(Evaluator* ev, AstId node) {
+    switch (ast_type(ev->ast, node)) {
+        case NODE_INT_LITERAL: {
+            Expr* e = new_expr(ev, ex_const);
+            e->k.i = strtoll(ast_value(ev->ast, node), NULL, 10);
+            return e;
+        }
+        case NODE_FLOAT_LITERAL: {
+            Expr* e = new_expr(ev, ex_const);
+            e->k.f = strtod(ast_value(ev->ast, node), NULL);
+            return e;
+        }
+        case NODE_IDENTIFIER: {
+            Expr* e = new_expr(ev, ex_local);
+            e->a = node_variable(ev, node)->address;
+            return e;
+        }
+        case NODE_FUNC_CALL:
+            return compile_call(ev, node);
+        case NODE_NEGATE: {
+            Expr* e = new_expr(ev, expr_type(ev->ast, node) == TYPE_FLOAT ? ex_negf : ex_negi);
+            e->x = compile_expr(ev, ast_child(ev->ast, node));
+            return e;
+        }
+        case NODE_ADD: case NODE_SUB: case NODE_MUL: case NODE_DIV:
+        case NODE_EQ: case NODE_NEQ: case NODE_LT: case NODE_LTE: case NODE_GT: case NODE_GTE:
+            if (operand_type(ev->ast, node) == TYPE_FLOAT) return compile_float_binary(ev, node);
+            return compile_int_binary(ev, node);
+        default:
+            eval_error("expressão inválida", ast_value(ev->ast, node));
+            return NULL;
+    }
+}
+
+// condições viram inteiros: um float é verdadeiro se for diferente de zero
+static const Expr* compile_condition(Evaluator* ev, AstId node) {
+    if (expr_type(ev->ast, node) == TYPE_INTEGER) return compile_expr(ev, node);
+    Expr* zero = new_expr(ev, ex_const);
+    zero->k.f = 0;
+    Expr* e = new_expr(ev, ex_nef);
+    e->x = compile_expr(ev, node);
+    e->y = zero;
+    return e;
+}
+
+static const Stmt* compile_block(Evaluator* ev, AstId block);
+
+static const Stmt* compile_assignment(Evaluator* ev, AstId node, AstId expr) {
+    SymbolNode* sym = node_variable(ev, node);
+    SymbolDataType value_type = expr_type(ev->ast, expr);
+
+    // x = constante
+    if ((ast_type(ev->ast, expr) == NODE_INT_LITERAL || ast_type(ev->ast, expr) == NODE_FLOAT_LITERAL) && value_type == sym->type) {
+        Stmt* s = new_stmt(ev, st_store_const);
+        s->a = sym->address;
+        s->k = compile_expr(ev, expr)->k;
+        return s;
+    }
+    // x = x + constante (e x = x - constante)
+    if (sym->type == TYPE_INTEGER && (ast_type(ev->ast, expr) == NODE_ADD || ast_type(ev->ast, expr) == NODE_SUB) &&
+        ast_type(ev->ast, ast_child(ev->ast, expr)) == NODE_IDENTIFIER && ast_symbol(ev->ast, ast_child(ev->ast, expr)) == sym &&
+        ast_type(ev->ast, ast_sibling(ev->ast, ast_child(ev->ast, expr))) == NODE_INT_LITERAL) {
+        Stmt* s = new_stmt(ev, st_add_const);
+        s->a = sym->address;
+        long long k = strtoll(ast_value(ev->ast, ast_sibling(ev->ast, ast_child(ev->ast, expr))), NULL, 10);
+        s->k.i = ast_type(ev->ast, expr) == NODE_ADD ? k : -k;
+        return s;
+    }
+    Stmt* s = new_stmt(ev, st_assign);
+    s->a = sym->address;
+    s->x = compile_expr_as(ev, expr, sym->type);
+    return s;
+}
+
+static const Stmt* compile_statement(Evaluator* ev, AstId node) {
+    switch (ast_type(ev->ast, node)) {
+        case NODE_DECLARATION: {
+            Stmt* s = new_stmt(ev, st_zero);
+            s->a = node_variable(ev, node)->address;
+            return s;
+        }
+
+        case NODE_DECL_ASSIGN: {
+            Stmt* s = new_stmt(ev, st_block);
+            s->count = 2;
+            s->list = (const Stmt**)arena_calloc(ev->arena, 2 * sizeof(Stmt*));
+            s->list[0] = compile_statement(ev, ast_child(ev->ast, node));
+            s->list[1] = compile_statement(ev, ast_sibling(ev->ast, ast_child(ev->ast, node)));
+            return s;
+        }
+
+        case NODE_ASSIGNMENT:
+            return compile_assignment(ev, node, ast_child(ev->ast, node));
+
+        case NODE_BLOCK:
+            return compile_block(ev, node);
+
+        case NODE_CONDITIONAL: {
+            AstId cond = ast_child(ev->ast, node);
+            AstId else_block = ast_sibling(ev->ast, ast_sibling(ev->ast, cond));
+            Stmt* s = new_stmt(ev, else_block ? st_if_else : st_if);
+            s->x = compile_condition(ev, cond);
+            s->body = compile_block(ev, ast_sibling(ev->ast, cond));
+            if (else_block) s->other = compile_block(ev, else_block);
+            return s;
+        }
+
+        case NODE_LOOP: {
+            Stmt* s = new_stmt(ev, st_while);
+            s->x = compile_condition(ev, ast_child(ev->ast, node));
+            s->body = compile_block(ev, ast_sibling(ev->ast, ast_child(ev->ast, node)));
+            return s;
+        }
+
+        case NODE_RETURN_STMT: {
+            Stmt* s = new_stmt(ev, st_return);
+            s->x = compile_expr_as(ev, ast_child(ev->ast, node), ev->return_type);
+            return s;
+        }
+
+        case NODE_PRINT: {
+            AstId args = ast_child(ev->ast, ast_child(ev->ast, node));
+            if (!args) return new_stmt(ev, st_newline);
+            Stmt* s = new_stmt(ev, st_block);
+            for (AstId a = args; a; a = ast_sibling(ev->ast, a)) s->count++;
+            s->list = (const Stmt**)arena_calloc(ev->arena, s->count * sizeof(Stmt*));
+            int i = 0;
+            for (AstId a = args; a; a = ast_sibling(ev->ast, a), i++) {
+                Stmt* p = new_stmt(ev, expr_type(ev->ast, a) == TYPE_FLOAT ? st_print_float : st_print_int);
+                p->x = compile_expr(ev, a);
+                p->a = ast_sibling(ev->ast, a) ? ' ' : '\n';
+                s->list[i] = p;
+            }
+            return s;
+        }
+
+        case NODE_SCAN: {
+            Stmt* s = new_stmt(ev, st_block);
+            for (AstId a = ast_child(ev->ast, ast_child(ev->ast, node)); a; a = ast_sibling(ev->ast, a)) s->count++;
+            s->list = (const Stmt**)arena_calloc(ev->arena, (s->count ? s->count : 1) * sizeof(Stmt*));
+            int i = 0;
+            for (AstId a = ast_child(ev->ast, ast_child(ev->ast, node)); a; a = ast_sibling(ev->ast, a), i++) {
+                if (ast_type(ev->ast, a) != NODE_IDENTIFIER) eval_error("scan espera variáveis como argumento", ast_value(ev->ast, a));
+                SymbolNode* sym = node_variable(ev, a);
+                Stmt* r = new_stmt(ev, sym->type == TYPE_FLOAT ? st_scan_float : st_scan_int);
+                r->a = sym->address;
+                s->list[i] = r;
+            }
+            return s;
+        }
+
+        case NODE_FUNC_CALL: {
+            Stmt* s = new_stmt(ev, st_eval);
+            s->x = compile_call(ev, node);
+            return s;
+        }
+
+        default:
+            eval_error("instrução não suportada", ast_value(ev->ast, node));
+            return new_stmt(ev, st_nop);
+    }
+}
+
+static const Stmt* compile_block(Evaluator* ev, AstId block) {
+    Stmt* s = new_stmt(ev, st_block);
+    for (AstId stmt = ast_child(ev->ast, block); stmt; stmt = ast_sibling(ev->ast, stmt)) s->count++;
+    s->list = (const Stmt**)arena_calloc(ev->arena, (s->count ? s->count : 1) * sizeof(Stmt*));
+    int i = 0;
+    for (AstId stmt = ast_child(ev->ast, block); stmt; stmt = ast_sibling(ev->ast, stmt), i++) {
+        s->list[i] = compile_statement(ev, stmt);
+    }
+    return s;
+}
+
+int eval_run(const Ast* ast, SymbolTable* global_scope) {
+    AstId root = ast->root;
+    Evaluator evaluator = { 0 };
+    Evaluator* ev = &evaluator;
+    ev->ast = ast;
+    ev->arena = arena_create();
+
+    for (AstId n = ast_child(ast, root); n; n = ast_sibling(ast, n)) ev->function_count++;
+    ev->functions = (EvalFunction*)calloc(ev->function_count ? ev->function_count : 1, sizeof(EvalFunction));
+
+    // assinaturas primeiro, para que as chamadas possam apontar para as funções
+    EvalFunction* entry = NULL;
+    int i = 0;
+    for (AstId n = ast_child(ast, root); n; n = ast_sibling(ast, n), i++) {
+        EvalFunction* fn = &ev->functions[i];
+        fn->body_node = n;
+        if (ast_type(ast, n) != NODE_FUNC_DECL) {
+            fn->name = "<principal>";
+            fn->scope = global_scope;
+            fn->return_type = TYPE_INTEGER;
+            entry = fn;
+        } else {
+            fn->name = ast_value(ast, n);
+            fn->decl = n;
+            fn->scope = ast_scope(ast, n);
+            fn->body_node = ast_sibling(ast, ast_child(ast, n));
+            SymbolNode* sym = ast_symbol(ast, n);
+            fn->return_type = sym ? sym->type : TYPE_INTEGER;
+            for (AstId p = ast_child(ast, ast_child(ast, n)); p; p = ast_sibling(ast, p)) fn->param_count++;
+            fn->param_addresses = (int*)arena_calloc(ev->arena, (fn->param_count ? fn->param_count : 1) * sizeof(int));
+            fn->param_types = (SymbolDataType*)arena_calloc(ev->arena, (fn->param_count ? fn->param_count : 1) * sizeof(SymbolDataType));
+            int k = 0;
+            for (AstId p = ast_child(ast, ast_child(ast, n)); p; p = ast_sibling(ast, p), k++) {
+                SymbolNode* param = ast_symbol(ast, p);
+                fn->param_addresses[k] = param->address;
+                fn->param_types[k] = param->type;
+            }
+        }
+        fn->frame_size = scope_frame_size(fn->scope);
+        if (fn->frame_size == 0) fn->frame_size = 1;
+    }
+    if (!entry) {
+        entry = find_function(ev, intern_cstr("main"));
+        if (entry->param_count) eval_error("a função main não pode ter parâmetros", "main");
+    }
+
+    for (i = 0; i < ev->function_count; i++) {
+        ev->return_type = ev->functions[i].return_type;
+        ev->functions[i].body = compile_block(ev, ev->functions[i].body_node);
+    }
+
+    // a entrada é executada como uma chamada sem argumentos
+    Expr call = { 0 };
+    call.fn = ex_call;
+    call.callee = entry;
+    Frame top = { NULL, { 0 } };
+    EvalValue v = ex_call(&call, &top);
+    int result = entry->return_type == TYPE_FLOAT ? (int)v.f : (int)v.i;
+    fflush(stdout);
+
+    free(ev->functions);
+    arena_destroy(ev->arena);
+    return result;
+}
@@ -0,0 +1,537 @@
+#include "inline.h"
+#include "types.h"
+#include "constant.h"
+#include "diagnostic.h"
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+// trecho de instruções que substitui uma instrução num bloco
+// (vazio quando first == AST_NONE)
+typedef struct {
+    AstId first;
+    AstId last;
+} StmtRange;
+
+typedef struct {
+    Ast* ast;
+    FILE* stats;
+    AstId* functions;       // NODE_FUNC_DECL de cada função, pela ordem
+    int function_count;
+    long budget;            // nós que ainda podem ser acrescentados
+    int calls;
+    int expanded;
+
+    // quem recebe as expansões (caller NULL no bloco principal)
+    SymbolNode* caller;
+    SymbolTable* scope;
+    int next_address;
+    int temp_count;
+
+    // a expansão atual, por endereço na função chamada: o símbolo dela, a
+    // variável nova do chamador e o argumento de cada parâmetro
+    SymbolTable* callee_scope;
+    SymbolNode** callee_symbol;
+    SymbolNode** rename;
+    AstId* argument;
+    int slot_count;
+    int slot_capacity;
+} Inliner;
+
+static void* grow_array(void* array, int* capacity, int needed, size_t element_size) {
+    if (needed <= *capacity) return array;
+    int bigger = *capacity ? *capacity : 16;
+    while (bigger < needed) bigger *= 2;
+    void* p = realloc(array, (size_t)bigger * element_size);
+    if (!p) compile_error("Erro: memória insuficiente para expandir as funções.");
+    *capacity = bigger;
+    return p;
+}
+
+static void report(Inliner* in, const SymbolNode* callee, const char* format, ...) {
+    if (!in->stats) return;
+    fprintf(in->stats, "  %s -> %s: ", in->caller ? in->caller->name : "principal", callee->name);
+    va_list args;
+    va_start(args, format);
+    vfprintf(in->stats, format, args);
+    va_end(args);
+    fputc('\n', in->stats);
+}
+
+// chamada que fica como está, com o motivo (e o tamanho do corpo, se já
+// foi contado)
+static void report_kept(Inliner* in, const SymbolNode* callee, const char* reason, int size) {
+    if (size > 0) report(in, callee, "mantida, %s (%d nós)", reason, size);
+    else report(in, callee, "mantida, %s", reason);
+}
+
+static int count_nodes(const Ast* ast, AstId node) {
+    int count = 0;
+    for (; node; node = ast_sibling(ast, node)) count += 1 + count_nodes(ast, ast_child(ast, node));
+    return count;
+}
+
+static int is_leaf(const Ast* ast, AstId node) {
+    NodeType type = ast_type(ast, node);
+    return type == NODE_INT_LITERAL || type == NODE_FLOAT_LITERAL || type == NODE_IDENTIFIER;
+}
+
+// sem chamadas nem divisões inteiras que possam falhar
+static int is_pure(const Ast* ast, AstId node) {
+    switch (ast_type(ast, node)) {
+        case NODE_FUNC_CALL:
+            return 0;
+        case NODE_DIV: {
+            AstId divisor = ast_sibling(ast, ast_child(ast, node));
+            if (operand_type(ast, node) == TYPE_INTEGER &&
+                (ast_type(ast, divisor) != NODE_INT_LITERAL || constant_of_literal(ast, divisor).i == 0)) return 0;
+            break;
+        }
+        default:
+            break;
+    }
+    for (AstId c = ast_child(ast, node); c; c = ast_sibling(ast, c)) {
+        if (!is_pure(ast, c)) return 0;
+    }
+    return 1;
+}
+
+static int uses(const Ast* ast, AstId node, const SymbolNode* sym) {
+    int count = ast_type(ast, node) == NODE_IDENTIFIER && ast_symbol(ast, node) == sym;
+    for (AstId c = ast_child(ast, node); c; c = ast_sibling(ast, c)) count += uses(ast, c, sym);
+    return count;
+}
+
+static int contains_return(const Ast* ast, AstId node) {
+    for (; node; node = ast_sibling(ast, node)) {
+        NodeType type = ast_type(ast, node);
+        if (type == NODE_RETURN_STMT) return 1;
+        if ((type == NODE_BLOCK || type == NODE_CONDITIONAL || type == NODE_LOOP) && contains_return(ast, ast_child(ast, node))) return 1;
+    }
+    return 0;
+}
+
+// o único return possível é a última instrução do corpo
+static int returns_only_at_end(const Ast* ast, AstId body) {
+    for (AstId s = ast_child(ast, body); s; s = ast_sibling(ast, s)) {
+        NodeType type = ast_type(ast, s);
+        if (type == NODE_RETURN_STMT) {
+            if (ast_sibling(ast, s)) return 0;
+        } else if ((type == NODE_BLOCK || type == NODE_CONDITIONAL || type == NODE_LOOP) && contains_return(ast, ast_child(ast, s))) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// o literal convertido para o tipo (AST_NONE se não tiver literal)
+static AstId convert_literal(Ast* ast, AstId node, SymbolDataType type) {
+    Constant c;
+    if (!constant_convert(constant_of_literal(ast, node), type, &c)) return AST_NONE;
+    return constant_node(ast, c);
+}
+
+static int argument_fits(Ast* ast, AstId arg, SymbolDataType type) {
+    if (expr_type(ast, arg) == type) return 1;
+    NodeType t = ast_type(ast, arg);
+    if (t != NODE_INT_LITERAL && t != NODE_FLOAT_LITERAL) return 0;
+    Constant c;
+    return constant_convert(constant_of_literal(ast, arg), type, &c) && constant_has_literal(c);
+}
+
+// ---------------------------------------------------------------------------
+// cópia do corpo
+// ---------------------------------------------------------------------------
+
+// prepara os mapas para expandir a função decl
+static void begin_expansion(Inliner* in, AstId decl) {
+    SymbolTable* scope = ast_scope(in->ast, decl);
+    int count = scope_frame_size(scope);
+    int capacity = in->slot_capacity;
+    in->callee_symbol = grow_array(in->callee_symbol, &capacity, count, sizeof(SymbolNode*));
+    capacity = in->slot_capacity;
+    in->rename = grow_array(in->rename, &capacity, count, sizeof(SymbolNode*));
+    capacity = in->slot_capacity;
+    in->argument = grow_array(in->argument, &capacity, count, sizeof(AstId));
+    in->slot_capacity = capacity;
+    in->slot_count = count;
+    for (int i = 0; i < count; i++) {
+        in->callee_symbol[i] = NULL;
+        in->rename[i] = NULL;
+        in->argument[i] = AST_NONE;
+    }
+    for (SymbolNode* sym = scope->first; sym; sym = sym->next) {
+        if (sym->kind == KIND_VARIABLE || sym->kind == KIND_PARAMETER) in->callee_symbol[sym->address] = sym;
+    }
+    in->callee_scope = scope;
+}
+
+// endereço de uma variável da função chamada, ou -1
+static int callee_slot(const Inliner* in, const SymbolNode* sym) {
+    if (!sym || (sym->kind != KIND_VARIABLE && sym->kind != KIND_PARAMETER)) return -1;
+    if (sym->address < 0 || sym->address >= in->slot_count || in->callee_symbol[sym->address] != sym) return -1;
+    return sym->address;
+}
+
+// variável nova do chamador para a variável var da função chamada
+static SymbolNode* new_variable(Inliner* in, const SymbolNode* callee, const char* var, SymbolDataType type) {
+    char name[256];
+    NameId id;
+    do {
+        int length = snprintf(name, sizeof(name), "_%s_%s%d", callee->name, var, ++in->temp_count);
+        if (length >= (int)sizeof(name)) length = snprintf(name, sizeof(name), "_inl%d", in->temp_count);
+        id = intern(name, length);
+    } while (scope_lookup_current(in->scope, id));
+    return scope_insert(in->scope, id, KIND_VARIABLE, type, 0, in->next_address++);
+}
+
+static SymbolNode* renamed(Inliner* in, const SymbolNode* callee, int slot) {
+    if (!in->rename[slot]) {
+        const SymbolNode* sym = in->callee_symbol[slot];
+        in->rename[slot] = new_variable(in, callee, sym->name, sym->type);
+    }
+    return in->rename[slot];
+}
+
+// copia a subárvore trocando as variáveis da função pelas do chamador
+static AstId copy_renamed(Inliner* in, const SymbolNode* callee, AstId node) {
+    Ast* ast = in->ast;
+    AstId copy = create_node(ast, ast_type(ast, node), ast_name(ast, node));
+    SymbolNode* sym = ast_symbol(ast, node);
+    int slot = callee_slot(in, sym);
+    if (slot >= 0) {
+        sym = renamed(in, callee, slot);
+        ast->value[copy] = sym->id;
+    }
+    ast_set_symbol(ast, copy, sym);
+    for (AstId c = ast_child(ast, node); c; c = ast_sibling(ast, c)) add_child(ast, copy, copy_renamed(in, callee, c));
+    return copy;
+}
+
+// copia a expressão trocando cada parâmetro pelo seu argumento
+static AstId copy_substituted(Inliner* in, AstId node) {
+    Ast* ast = in->ast;
+    int slot = ast_type(ast, node) == NODE_IDENTIFIER ? callee_slot(in, ast_symbol(ast, node)) : -1;
+    if (slot >= 0) {
+        AstId arg = in->argument[slot];
+        SymbolDataType type = in->callee_symbol[slot]->type;
+        if (expr_type(ast, arg) != type) return convert_literal(ast, arg, type);
+        return copy_substituted(in, arg);
+    }
+    AstId copy = create_node(ast, ast_type(ast, node), ast_name(ast, node));
+    ast_set_symbol(ast, copy, ast_symbol(ast, node));
+    for (AstId c = ast_child(ast, node); c; c = ast_sibling(ast, c)) add_child(ast, copy, copy_substituted(in, c));
+    return copy;
+}
+
+static AstId variable_node(Ast* ast, SymbolNode* sym) {
+    AstId node = create_node(ast, NODE_IDENTIFIER, sym->id);
+    ast_set_symbol(ast, node, sym);
+    return node;
+}
+
+static AstId assignment_node(Ast* ast, SymbolNode* var, AstId value) {
+    AstId node = create_node(ast, NODE_ASSIGNMENT, var->id);
+    ast_set_symbol(ast, node, var);
+    ast->sibling[value] = AST_NONE;
+    add_child(ast, node, value);
+    return node;
+}
+
+static void append(Ast* ast, StmtRange* range, AstId node) {
+    if (range->last) ast->sibling[range->last] = node;
+    else range->first = node;
+    range->last = node;
+    ast->sibling[node] = AST_NONE;
+}
+
+// ---------------------------------------------------------------------------
+// decisões
+// ---------------------------------------------------------------------------
+
+static AstId callee_decl(const Inliner* in, const SymbolNode* callee) {
+    if (callee->kind != KIND_FUNCTION || callee->order < 0 || callee->order >= in->function_count) return AST_NONE;
+    return in->functions[callee->order];
+}
+
+static int argument_count(const Ast* ast, AstId list) {
+    int count = 0;
+    for (AstId a = list ? ast_child(ast, list) : AST_NONE; a; a = ast_sibling(ast, a)) count++;
+    return count;
+}
+
+// o que impede qualquer expansão (NULL se nada); size recebe o tamanho do corpo
+static const char* check_call(Inliner* in, AstId call, AstId decl, int* size) {
+    Ast* ast = in->ast;
+    SymbolNode* callee = ast_symbol(ast, call);
+    if (!decl) return "função sem corpo";
+    if (callee == in->caller) return "recursiva";
+    if (argument_count(ast, ast_child(ast, call)) != argument_count(ast, ast_child(ast, decl))) return "número de argumentos diferente";
+    *size = count_nodes(ast, ast_child(ast, ast_sibling(ast, ast_child(ast, decl))));
+    if (*size > INLINE_MAX_NODES) return "corpo grande demais";
+    if (*size > in->budget) return "orçamento esgotado";
+    return NULL;
+}
+
+// o que impede de trocar a chamada pela expressão do return (NULL se nada)
+static const char* check_expression(Inliner* in, AstId call, AstId decl) {
+    Ast* ast = in->ast;
+    AstId body = ast_sibling(ast, ast_child(ast, decl));
+    AstId ret = ast_child(ast, body);
+    if (!ret || ast_sibling(ast, ret) || ast_type(ast, ret) != NODE_RETURN_STMT) return "o corpo não é só um return";
+    AstId value = ast_child(ast, ret);
+    if (expr_type(ast, value) != ast_symbol(ast, call)->type) return "o return converte o valor";
+    AstId p = ast_child(ast, ast_child(ast, decl));
+    for (AstId a = ast_child(ast, ast_child(ast, call)); a; a = ast_sibling(ast, a), p = ast_sibling(ast, p)) {
+        SymbolNode* param = ast_symbol(ast, p);
+        if (!argument_fits(ast, a, param->type)) return "argumento de outro tipo";
+        if (is_leaf(ast, a)) continue;
+        if (!is_pure(ast, a)) return "argumento com chamada ou divisão que pode falhar";
+        if (uses(ast, value, param) > 1) return "argumento usado mais de uma vez";
+    }
+    return NULL;
+}
+
+static void charge(Inliner* in, int size) {
+    in->budget -= size;
+    in->expanded++;
+}
+
+// troca a chamada, no lugar, pela expressão do return
+static void expand_expression(Inliner* in, AstId call, AstId decl, int size) {
+    Ast* ast = in->ast;
+    begin_expansion(in, decl);
+    AstId p = ast_child(ast, ast_child(ast, decl));
+    for (AstId a = ast_child(ast, ast_child(ast, call)); a; a = ast_sibling(ast, a), p = ast_sibling(ast, p)) {
+        in->argument[ast_symbol(ast, p)->address] = a;
+    }
+    AstId ret = ast_child(ast, ast_sibling(ast, ast_child(ast, decl)));
+    AstId value = copy_substituted(in, ast_child(ast, ret));
+    ast->type[call] = ast->type[value];
+    ast->value[call] = ast->value[value];
+    ast->child[call] = ast->child[value];
+    ast->last_child[call] = ast->last_child[value];
+    ast->symbol[call] = ast->symbol[value];
+    charge(in, size);
+}
+
+// a instrução stmt, cuja expressão inteira é a chamada, vira as instruções
+// do corpo: os argumentos vão para variáveis novas, o corpo é copiado com
+// as variáveis trocadas e o return final vira o valor da instrução
+static StmtRange expand_statements(Inliner* in, AstId stmt, AstId call, AstId decl, int size) {
+    Ast* ast = in->ast;
+    SymbolNode* callee = ast_symbol(ast, call);
+    NodeType type = ast_type(ast, stmt);
+    StmtRange range = { AST_NONE, AST_NONE };
+    begin_expansion(in, decl);
+
+    AstId target = stmt;
+    if (type == NODE_DECL_ASSIGN) {
+        target = ast_sibling(ast, ast_child(ast, stmt));
+        append(ast, &range, ast_child(ast, stmt));
+    }
+
+    AstId p = ast_child(ast, ast_child(ast, decl));
+    for (AstId a = ast_child(ast, ast_child(ast, call)); a; p = ast_sibling(ast, p)) {
+        AstId next = ast_sibling(ast, a);
+        SymbolNode* param = renamed(in, callee, ast_symbol(ast, p)->address);
+        append(ast, &range, assignment_node(ast, param, a));
+        a = next;
+    }
+
+    AstId ret = AST_NONE;
+    for (AstId s = ast_child(ast, ast_sibling(ast, ast_child(ast, decl))); s; s = ast_sibling(ast, s)) {
+        if (ast_type(ast, s) == NODE_RETURN_STMT) ret = s;
+        else append(ast, &range, copy_renamed(in, callee, s));
+    }
+
+    // sem return o valor é zero
+    AstId value;
+    if (ret) value = copy_renamed(in, callee, ast_child(ast, ret));
+    else {
+        Constant zero;
+        memset(&zero, 0, sizeof(Constant));
+        zero.type = callee->type;
+        value = constant_node(ast, zero);
+    }
+
+    if (type == NODE_FUNC_CALL) {
+        // o valor não é usado, mas a conta pode ter efeito
+        if (!is_pure(ast, value)) append(ast, &range, assignment_node(ast, new_variable(in, callee, "ret", callee->type), value));
+    } else {
+        if (expr_type(ast, value) != callee->type) {
+            SymbolNode* result = new_variable(in, callee, "ret", callee->type);
+            append(ast, &range, assignment_node(ast, result, value));
+            value = variable_node(ast, result);
+        }
+        ast->child[target] = value;
+        ast->last_child[target] = value;
+        ast->sibling[value] = AST_NONE;
+        append(ast, &range, target);
+    }
+    charge(in, size);
+    return range;
+}
+
+// ---------------------------------------------------------------------------
+// percurso
+// ---------------------------------------------------------------------------
+
+static void inline_expr(Inliner* in, AstId node);
+
+static void inline_arguments(Inliner* in, AstId call) {
+    AstId args = ast_child(in->ast, call);
+    for (AstId a = args ? ast_child(in->ast, args) : AST_NONE; a; a = ast_sibling(in->ast, a)) inline_expr(in, a);
+}
+
+static void inline_expr(Inliner* in, AstId node) {
+    Ast* ast = in->ast;
+    if (ast_type(ast, node) != NODE_FUNC_CALL) {
+        for (AstId c = ast_child(ast, node); c; c = ast_sibling(ast, c)) inline_expr(in, c);
+        return;
+    }
+    inline_arguments(in, node);
+    in->calls++;
+    SymbolNode* callee = ast_symbol(ast, node);
+    AstId decl = callee_decl(in, callee);
+    int size = 0;
+    const char* reason = check_call(in, node, decl, &size);
+    if (!reason) reason = check_expression(in, node, decl);
+    if (reason) {
+        report_kept(in, callee, reason, size);
+        return;
+    }
+    expand_expression(in, node, decl, size);
+    report(in, callee, "expandida na expressão (%d nós)", size);
+}
+
+// instrução cuja expressão inteira é a chamada
+static StmtRange inline_call_statement(Inliner* in, AstId stmt, AstId call) {
+    Ast* ast = in->ast;
+    StmtRange range = { stmt, stmt };
+    inline_arguments(in, call);
+    in->calls++;
+    SymbolNode* callee = ast_symbol(ast, call);
+    AstId decl = callee_decl(in, callee);
+    int size = 0;
+    const char* reason = check_call(in, call, decl, &size);
+    // uma chamada sozinha como instrução não pode virar só uma conta
+    if (!reason && stmt != call && !check_expression(in, call, decl)) {
+        expand_expression(in, call, decl, size);
+        report(in, callee, "expandida na expressão (%d nós)", size);
+        return range;
+    }
+    if (!reason && !returns_only_at_end(ast, ast_sibling(ast, ast_child(ast, decl)))) reason = "return no meio do corpo";
+    if (reason) {
+        report_kept(in, callee, reason, size);
+        return range;
+    }
+    range = expand_statements(in, stmt, call, decl, size);
+    report(in, callee, "expandida em instruções (%d nós)", size);
+    return range;
+}
+
+static void inline_block(Inliner* in, AstId block);
+
+static StmtRange inline_statement(Inliner* in, AstId node) {
+    Ast* ast = in->ast;
+    StmtRange range = { node, node };
+    switch (ast_type(ast, node)) {
+        case NODE_ASSIGNMENT:
+        case NODE_RETURN_STMT: {
+            AstId value = ast_child(ast, node);
+            if (ast_type(ast, value) == NODE_FUNC_CALL) return inline_call_statement(in, node, value);
+            inline_expr(in, value);
+            break;
+        }
+        case NODE_DECL_ASSIGN: {
+            AstId value = ast_child(ast, ast_sibling(ast, ast_child(ast, node)));
+            if (ast_type(ast, value) == NODE_FUNC_CALL) return inline_call_statement(in, node, value);
+            inline_expr(in, value);
+            break;
+        }
+        case NODE_FUNC_CALL:
+            return inline_call_statement(in, node, node);
+        case NODE_PRINT:
+            inline_expr(in, ast_child(ast, node));
+            break;
+        case NODE_CONDITIONAL:
+        case NODE_LOOP: {
+            AstId cond = ast_child(ast, node);
+            inline_expr(in, cond);
+            for (AstId b = ast_sibling(ast, cond); b; b = ast_sibling(ast, b)) inline_block(in, b);
+            break;
+        }
+        case NODE_BLOCK:
+            inline_block(in, node);
+            break;
+        default:
+            break;
+    }
+    return range;
+}
+
+// troca cada instrução pelo trecho que sobrou dela
+static void inline_block(Inliner* in, AstId block) {
+    Ast* ast = in->ast;
+    AstId last = AST_NONE;
+    for (AstId stmt = ast_child(ast, block); stmt;) {
+        AstId next = ast_sibling(ast, stmt);
+        StmtRange range = inline_statement(in, stmt);
+        if (range.first) {
+            if (last) ast->sibling[last] = range.first;
+            else ast->child[block] = range.first;
+            last = range.last;
+        }
+        stmt = next;
+    }
+    if (last) ast->sibling[last] = AST_NONE;
+    else ast->child[block] = AST_NONE;
+    ast->last_child[block] = last;
+}
+
+static void inline_function(Inliner* in, SymbolNode* caller, AstId body, SymbolTable* scope) {
+    in->caller = caller;
+    in->scope = scope;
+    in->next_address = scope_frame_size(scope);
+    in->temp_count = 0;
+    inline_block(in, body);
+}
+
+void inline_optimize_ast(Ast* ast, SymbolTable* global_scope, FILE* stats) {
+    Inliner in;
+    memset(&in, 0, sizeof(Inliner));
+    in.ast = ast;
+    in.stats = stats;
+    in.budget = ast->count > INLINE_MIN_BUDGET ? ast->count : INLINE_MIN_BUDGET;
+    long budget = in.budget;
+
+    for (AstId n = ast_child(ast, ast->root); n; n = ast_sibling(ast, n)) {
+        if (ast_type(ast, n) == NODE_FUNC_DECL && ast_symbol(ast, n)->order >= in.function_count) {
+            in.function_count = ast_symbol(ast, n)->order + 1;
+        }
+    }
+    in.functions = (AstId*)calloc(in.function_count + 1, sizeof(AstId));
+    if (!in.functions) compile_error("Erro: memória insuficiente para expandir as funções.");
+    for (AstId n = ast_child(ast, ast->root); n; n = ast_sibling(ast, n)) {
+        if (ast_type(ast, n) == NODE_FUNC_DECL) in.functions[ast_symbol(ast, n)->order] = n;
+    }
+
+    if (stats) {
+        fprintf(stats, "--- Expansão de Funções ---\n");
+        fprintf(stats, "orçamento: corpos de até %d nós, até %ld nós novos no programa\n", INLINE_MAX_NODES, budget);
+    }
+    for (AstId n = ast_child(ast, ast->root); n; n = ast_sibling(ast, n)) {
+        if (ast_type(ast, n) == NODE_FUNC_DECL) inline_function(&in, ast_symbol(ast, n), ast_sibling(ast, ast_child(ast, n)), ast_scope(ast, n));
+        else inline_function(&in, NULL, n, global_scope);
+    }
+    if (stats) {
+        fprintf(stats, "%d de %d chamadas expandidas, %ld nós novos (sobram %ld)\n",
+                in.expanded, in.calls, budget - in.budget, in.budget);
+    }
+
+    free(in.functions);
+    free(in.callee_symbol);
+    free(in.rename);
+    free(in.argument);
+}
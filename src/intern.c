@@ -0,0 +1,163 @@
+#include "intern.h"
+#include "arena.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// a tabela é dividida em partes, cada uma com seu lock, para que as
+// threads do lexer paralelo quase nunca disputem o mesmo. a parte de um
+// texto vem dos bits baixos do hash e faz parte do número:
+// id = (posição na parte + 1) << SHARD_BITS | parte
+#define SHARD_BITS 6
+#define SHARD_COUNT (1 << SHARD_BITS)
+
+// as entradas ficam em páginas que nunca mudam de lugar, então intern_name
+// lê sem lock mesmo enquanto outra thread acrescenta nomes
+#define PAGE_BITS 12
+#define PAGE_SIZE (1 << PAGE_BITS)
+#define MAX_PAGES 1024
+
+#define INITIAL_SLOTS 256
+
+typedef struct {
+    const char* text;
+    uint32_t hash;
+    uint32_t length;
+} NameEntry;
+
+typedef struct {
+    pthread_mutex_t lock;
+    uint32_t* slots;            // endereçamento aberto: posição + 1 (0 = vazio)
+    uint32_t slot_mask;
+    uint32_t count;
+    NameEntry* pages[MAX_PAGES];
+    Arena* arena;               // os textos
+} Shard;
+
+static Shard shards[SHARD_COUNT];
+static pthread_once_t shards_once = PTHREAD_ONCE_INIT;
+
+// compilações da biblioteca em andamento (ver intern_retain)
+static pthread_mutex_t users_lock = PTHREAD_MUTEX_INITIALIZER;
+static int users;
+
+static void intern_error(const char* message) {
+    fprintf(stderr, "Erro: %s.\n", message);
+    exit(EXIT_FAILURE);
+}
+
+static void init_shards(void) {
+    for (int i = 0; i < SHARD_COUNT; i++) pthread_mutex_init(&shards[i].lock, NULL);
+}
+
+// FNV-1a
+static uint32_t hash_text(const char* s, size_t length) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static NameEntry* entry_at(Shard* shard, uint32_t index) {
+    return &shard->pages[index >> PAGE_BITS][index & (PAGE_SIZE - 1)];
+}
+
+// dobra a tabela de posições (com o lock obtido)
+static void grow_slots(Shard* shard) {
+    uint32_t capacity = shard->slots ? 2 * (shard->slot_mask + 1) : INITIAL_SLOTS;
+    uint32_t* slots = (uint32_t*)calloc(capacity, sizeof(uint32_t));
+    if (!slots) intern_error("memória insuficiente para a tabela de nomes");
+    for (uint32_t i = 0; i < shard->count; i++) {
+        uint32_t at = (entry_at(shard, i)->hash >> SHARD_BITS) & (capacity - 1);
+        while (slots[at]) at = (at + 1) & (capacity - 1);
+        slots[at] = i + 1;
+    }
+    free(shard->slots);
+    shard->slots = slots;
+    shard->slot_mask = capacity - 1;
+}
+
+NameId intern(const char* s, size_t length) {
+    pthread_once(&shards_once, init_shards);
+    uint32_t hash = hash_text(s, length);
+    uint32_t part = hash & (SHARD_COUNT - 1);
+    Shard* shard = &shards[part];
+
+    pthread_mutex_lock(&shard->lock);
+    // a tabela fica no máximo metade cheia
+    if (2 * (shard->count + 1) > (shard->slots ? shard->slot_mask + 1 : 0)) grow_slots(shard);
+    uint32_t at = (hash >> SHARD_BITS) & shard->slot_mask;
+    while (shard->slots[at]) {
+        uint32_t index = shard->slots[at] - 1;
+        NameEntry* entry = entry_at(shard, index);
+        if (entry->hash == hash && entry->length == length && memcmp(entry->text, s, length) == 0) {
+            pthread_mutex_unlock(&shard->lock);
+            return ((index + 1) << SHARD_BITS) | part;
+        }
+        at = (at + 1) & shard->slot_mask;
+    }
+
+    uint32_t index = shard->count;
+    if ((index >> PAGE_BITS) >= MAX_PAGES) intern_error("nomes distintos demais");
+    if (!shard->pages[index >> PAGE_BITS]) {
+        shard->pages[index >> PAGE_BITS] = (NameEntry*)malloc(PAGE_SIZE * sizeof(NameEntry));
+        if (!shard->pages[index >> PAGE_BITS]) intern_error("memória insuficiente para a tabela de nomes");
+    }
+    if (!shard->arena) shard->arena = arena_create();
+    NameEntry* entry = entry_at(shard, index);
+    entry->text = arena_strndup(shard->arena, s, length);
+    entry->hash = hash;
+    entry->length = (uint32_t)length;
+    shard->slots[at] = index + 1;
+    shard->count++;
+    pthread_mutex_unlock(&shard->lock);
+    return ((index + 1) << SHARD_BITS) | part;
+}
+
+NameId intern_cstr(const char* s) {
+    return intern(s, strlen(s));
+}
+
+const char* intern_name(NameId id) {
+    if (id == NAME_NONE) return NULL;
+    Shard* shard = &shards[id & (SHARD_COUNT - 1)];
+    return entry_at(shard, (id >> SHARD_BITS) - 1)->text;
+}
+
+// volta a parte ao estado inicial, mantendo a primeira página, a tabela de
+// posições se ainda for a pequena e o primeiro bloco da arena
+static void reset_shard(Shard* shard) {
+    pthread_mutex_lock(&shard->lock);
+    for (int p = 1; p < MAX_PAGES && shard->pages[p]; p++) {
+        free(shard->pages[p]);
+        shard->pages[p] = NULL;
+    }
+    if (shard->slots && shard->slot_mask + 1 > INITIAL_SLOTS) {
+        free(shard->slots);
+        shard->slots = NULL;
+        shard->slot_mask = 0;
+    } else if (shard->slots) {
+        memset(shard->slots, 0, (shard->slot_mask + 1) * sizeof(uint32_t));
+    }
+    if (shard->arena) arena_reset(shard->arena);
+    shard->count = 0;
+    pthread_mutex_unlock(&shard->lock);
+}
+
+void intern_retain(void) {
+    pthread_mutex_lock(&users_lock);
+    users++;
+    pthread_mutex_unlock(&users_lock);
+}
+
+void intern_release(void) {
+    pthread_once(&shards_once, init_shards);
+    pthread_mutex_lock(&users_lock);
+    if (--users == 0) {
+        for (int i = 0; i < SHARD_COUNT; i++) reset_shard(&shards[i]);
+    }
+    pthread_mutex_unlock(&users_lock);
+}
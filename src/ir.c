@@ -0,0 +1,608 @@
+#include "ir.h"
+#include "types.h"
+#include "diagnostic.h"
+#include <stdlib.h>
+#include <string.h>
+
+// definição desfeita ao sair de um ramo: o endereço e o valor de antes
+typedef struct {
+    int slot;
+    IrValue old;
+} Definition;
+
+typedef struct {
+    const Ast* ast;
+    IrFunction* f;
+    int current;                // bloco onde as instruções entram
+
+    // as variáveis que viram SSA, indexadas pelo endereço
+    SymbolNode** slot_symbol;
+    IrValue* value;             // valor atual de cada variável
+    int slot_count;
+    uint32_t* stamp;            // marca de visita por endereço (ver epoch)
+    uint32_t epoch;
+
+    Definition* log;            // definições feitas, para desfazer
+    int log_count;
+    int log_capacity;
+
+    // pilha de trabalho: argumentos de chamadas e pares (endereço, valor)
+    IrValue* pending;
+    int pending_count;
+    int pending_capacity;
+} Builder;
+
+// garante espaço para mais um elemento num vetor que dobra
+static void* reserve(void* array, int* capacity, int count, size_t element_size) {
+    if (count < *capacity) return array;
+    int bigger = *capacity ? *capacity * 2 : 16;
+    void* p = realloc(array, (size_t)bigger * element_size);
+    if (!p) compile_error("Erro: memória insuficiente para a IR.");
+    *capacity = bigger;
+    return p;
+}
+
+static int new_block(IrFunction* f) {
+    f->blocks = reserve(f->blocks, &f->block_capacity, f->block_count, sizeof(IrBlock));
+    IrBlock* block = &f->blocks[f->block_count];
+    memset(block, 0, sizeof(IrBlock));
+    return f->block_count++;
+}
+
+static void add_edge(IrFunction* f, int from, int to) {
+    f->blocks[from].succ[f->blocks[from].succ_count++] = to;
+    f->blocks[to].pred[f->blocks[to].pred_count++] = from;
+}
+
+// acrescenta uma instrução no fim do bloco atual
+static IrValue emit(Builder* b, IrOp op, SymbolDataType type, const IrValue* operands, int count) {
+    IrFunction* f = b->f;
+    f->instrs = reserve(f->instrs, &f->instr_capacity, f->instr_count, sizeof(IrInstr));
+    IrValue v = (IrValue)f->instr_count++;
+    IrInstr* in = &f->instrs[v];
+    memset(in, 0, sizeof(IrInstr));
+    in->op = (uint8_t)op;
+    in->type = (uint8_t)type;
+    in->block = b->current;
+    in->operand_start = f->operand_count;
+    in->operand_count = count;
+    for (int i = 0; i < count; i++) {
+        f->operands = reserve(f->operands, &f->operand_capacity, f->operand_count, sizeof(IrValue));
+        f->operands[f->operand_count++] = operands[i];
+    }
+
+    IrBlock* block = &f->blocks[b->current];
+    if (block->last) f->instrs[block->last].next = v;
+    else block->first = v;
+    block->last = v;
+    return v;
+}
+
+static IrValue emit_constant(Builder* b, Constant c) {
+    IrValue v = emit(b, IR_CONST, c.type, NULL, 0);
+    b->f->instrs[v].value = c;
+    return v;
+}
+
+static void push_pending(Builder* b, IrValue v) {
+    b->pending = reserve(b->pending, &b->pending_capacity, b->pending_count, sizeof(IrValue));
+    b->pending[b->pending_count++] = v;
+}
+
+static void add_link(IrLink** links, int* count, int* capacity, AstId node, uint32_t index) {
+    *links = reserve(*links, capacity, *count, sizeof(IrLink));
+    (*links)[*count].node = node;
+    (*links)[*count].index = index;
+    (*count)++;
+}
+
+// endereço da variável, ou -1 se ela não virou SSA
+static int slot_of(const Builder* b, const SymbolNode* sym) {
+    if (!sym || (sym->kind != KIND_VARIABLE && sym->kind != KIND_PARAMETER)) return -1;
+    if (sym->address < 0 || sym->address >= b->slot_count || b->slot_symbol[sym->address] != sym) return -1;
+    return sym->address;
+}
+
+static void define(Builder* b, int slot, IrValue v) {
+    b->log = reserve(b->log, &b->log_capacity, b->log_count, sizeof(Definition));
+    b->log[b->log_count].slot = slot;
+    b->log[b->log_count].old = b->value[slot];
+    b->log_count++;
+    b->value[slot] = v;
+}
+
+// volta os valores das variáveis para como estavam na marca
+static void undo(Builder* b, int mark) {
+    while (b->log_count > mark) {
+        b->log_count--;
+        b->value[b->log[b->log_count].slot] = b->log[b->log_count].old;
+    }
+}
+
+static IrValue build_expr(Builder* b, AstId node) {
+    const Ast* ast = b->ast;
+    switch (ast_type(ast, node)) {
+        case NODE_INT_LITERAL:
+        case NODE_FLOAT_LITERAL:
+            return emit_constant(b, constant_of_literal(ast, node));
+
+        case NODE_IDENTIFIER: {
+            SymbolNode* sym = ast_symbol(ast, node);
+            int slot = slot_of(b, sym);
+            IrValue v;
+            if (slot >= 0) {
+                v = b->value[slot];
+            } else {
+                v = emit(b, IR_UNDEF, expr_type(ast, node), NULL, 0);
+                b->f->instrs[v].var = sym;
+            }
+            add_link(&b->f->uses, &b->f->use_count, &b->f->use_capacity, node, v);
+            return v;
+        }
+
+        case NODE_FUNC_CALL: {
+            int base = b->pending_count;
+            AstId args = ast_child(ast, node);
+            for (AstId a = args ? ast_child(ast, args) : AST_NONE; a; a = ast_sibling(ast, a)) {
+                IrValue v = build_expr(b, a);
+                push_pending(b, v);
+            }
+            IrValue v = emit(b, IR_CALL, expr_type(ast, node), b->pending + base, b->pending_count - base);
+            b->f->instrs[v].var = ast_symbol(ast, node);
+            b->pending_count = base;
+            return v;
+        }
+
+        case NODE_NEGATE: {
+            IrValue operand = build_expr(b, ast_child(ast, node));
+            return emit(b, IR_NEGATE, expr_type(ast, node), &operand, 1);
+        }
+
+        default: {
+            IrValue operands[2];
+            AstId left = ast_child(ast, node);
+            operands[0] = build_expr(b, left);
+            operands[1] = build_expr(b, ast_sibling(ast, left));
+            IrValue v = emit(b, IR_BINARY, expr_type(ast, node), operands, 2);
+            b->f->instrs[v].node_op = (uint8_t)ast_type(ast, node);
+            return v;
+        }
+    }
+}
+
+// atribuição do valor à variável do nó (NODE_ASSIGNMENT ou NODE_DECLARATION)
+static void build_copy(Builder* b, AstId node, IrValue value, IrValue expr_start) {
+    SymbolNode* sym = ast_symbol(b->ast, node);
+    if (b->f->instrs[value].type != sym->type) value = emit(b, IR_CONVERT, sym->type, &value, 1);
+    IrValue copy = emit(b, IR_COPY, sym->type, &value, 1);
+    IrInstr* in = &b->f->instrs[copy];
+    in->var = sym;
+    in->origin = node;
+    in->expr_start = expr_start;
+    int slot = slot_of(b, sym);
+    if (slot >= 0) define(b, slot, copy);
+    else in->flags |= IR_PINNED;
+}
+
+static void add_assigned(Builder* b, const SymbolNode* sym) {
+    int slot = slot_of(b, sym);
+    if (slot >= 0 && b->stamp[slot] != b->epoch) {
+        b->stamp[slot] = b->epoch;
+        push_pending(b, (IrValue)slot);
+    }
+}
+
+// variáveis atribuídas em algum ponto da lista de nós (e dentro deles)
+static void collect_assigned(Builder* b, AstId node) {
+    const Ast* ast = b->ast;
+    for (; node; node = ast_sibling(ast, node)) {
+        switch (ast_type(ast, node)) {
+            case NODE_ASSIGNMENT:
+            case NODE_DECLARATION:
+                add_assigned(b, ast_symbol(ast, node));
+                break;
+            case NODE_SCAN:
+                for (AstId a = ast_child(ast, ast_child(ast, node)); a; a = ast_sibling(ast, a)) {
+                    if (ast_type(ast, a) == NODE_IDENTIFIER) add_assigned(b, ast_symbol(ast, a));
+                }
+                break;
+            case NODE_DECL_ASSIGN:
+            case NODE_BLOCK:
+            case NODE_CONDITIONAL:
+            case NODE_LOOP:
+                collect_assigned(b, ast_child(ast, node));
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+static IrValue emit_phi(Builder* b, int slot, IrValue first, IrValue second) {
+    IrValue operands[2] = { first, second };
+    IrValue phi = emit(b, IR_PHI, b->slot_symbol[slot]->type, operands, 2);
+    b->f->instrs[phi].var = b->slot_symbol[slot];
+    return phi;
+}
+
+static void build_block(Builder* b, AstId block);
+
+static void build_conditional(Builder* b, AstId node) {
+    IrFunction* f = b->f;
+    AstId cond = ast_child(b->ast, node);
+    AstId then_block = ast_sibling(b->ast, cond);
+    AstId else_block = ast_sibling(b->ast, then_block);
+
+    IrValue c = build_expr(b, cond);
+    emit(b, IR_BRANCH, TYPE_VOID, &c, 1);
+    int cond_end = b->current;
+
+    int mark = b->log_count;
+    b->current = new_block(f);
+    add_edge(f, cond_end, b->current);
+    build_block(b, then_block);
+    emit(b, IR_JUMP, TYPE_VOID, NULL, 0);
+    int then_end = b->current;
+
+    // o que o then mudou, com o valor do fim do ramo
+    int base = b->pending_count;
+    b->epoch++;
+    for (int i = mark; i < b->log_count; i++) {
+        int slot = b->log[i].slot;
+        if (b->stamp[slot] == b->epoch) continue;
+        b->stamp[slot] = b->epoch;
+        push_pending(b, (IrValue)slot);
+        push_pending(b, b->value[slot]);
+    }
+    undo(b, mark);
+
+    int else_end = cond_end;
+    if (else_block) {
+        b->current = new_block(f);
+        add_edge(f, cond_end, b->current);
+        build_block(b, else_block);
+        emit(b, IR_JUMP, TYPE_VOID, NULL, 0);
+        else_end = b->current;
+    }
+
+    int join = new_block(f);
+    add_edge(f, then_end, join);
+    add_edge(f, else_end, join);
+    b->current = join;
+
+    // um phi para cada variável mudada em algum dos ramos. o log do else
+    // começa na marca e guarda o valor de antes do if.
+    int else_log = b->log_count;
+    b->epoch++;
+    for (int i = base; i < b->pending_count; i += 2) b->stamp[b->pending[i]] = b->epoch;
+    for (int i = mark; i < else_log; i++) {
+        int slot = b->log[i].slot;
+        if (b->stamp[slot] == b->epoch) continue;
+        b->stamp[slot] = b->epoch;
+        define(b, slot, emit_phi(b, slot, b->log[i].old, b->value[slot]));
+    }
+    for (int i = base; i < b->pending_count; i += 2) {
+        int slot = (int)b->pending[i];
+        define(b, slot, emit_phi(b, slot, b->pending[i + 1], b->value[slot]));
+    }
+    b->pending_count = base;
+}
+
+static void build_loop(Builder* b, AstId node) {
+    IrFunction* f = b->f;
+    AstId cond = ast_child(b->ast, node);
+    AstId body = ast_sibling(b->ast, cond);
+
+    emit(b, IR_JUMP, TYPE_VOID, NULL, 0);
+    int header = new_block(f);
+    add_edge(f, b->current, header);
+    b->current = header;
+
+    // as variáveis atribuídas no corpo recebem um phi no cabeçalho; o
+    // operando da volta é preenchido depois do corpo
+    int base = b->pending_count;
+    b->epoch++;
+    collect_assigned(b, ast_child(b->ast, body));
+    int end = b->pending_count;
+    for (int i = base; i < end; i++) {
+        int slot = (int)b->pending[i];
+        IrValue phi = emit_phi(b, slot, b->value[slot], IR_NONE);
+        define(b, slot, phi);
+        b->pending[i] = phi;
+    }
+
+    IrValue c = build_expr(b, cond);
+    emit(b, IR_BRANCH, TYPE_VOID, &c, 1);
+
+    int mark = b->log_count;
+    b->current = new_block(f);
+    add_edge(f, header, b->current);
+    build_block(b, body);
+    emit(b, IR_JUMP, TYPE_VOID, NULL, 0);
+    add_edge(f, b->current, header);
+
+    for (int i = base; i < end; i++) {
+        IrInstr* phi = &f->instrs[b->pending[i]];
+        f->operands[phi->operand_start + 1] = b->value[slot_of(b, phi->var)];
+    }
+    undo(b, mark);
+    b->pending_count = base;
+
+    int exit = new_block(f);
+    add_edge(f, header, exit);
+    b->current = exit;
+}
+
+static void build_statement(Builder* b, AstId node) {
+    IrFunction* f = b->f;
+    const Ast* ast = b->ast;
+    add_link(&f->statements, &f->statement_count, &f->statement_capacity, node, (uint32_t)b->current);
+
+    switch (ast_type(ast, node)) {
+        case NODE_DECLARATION: {
+            // variáveis começam valendo zero
+            Constant zero;
+            zero.type = ast_symbol(ast, node)->type;
+            if (zero.type == TYPE_FLOAT) zero.f = 0.0;
+            else zero.i = 0;
+            IrValue v = emit_constant(b, zero);
+            build_copy(b, node, v, v);
+            break;
+        }
+
+        case NODE_DECL_ASSIGN:
+            build_statement(b, ast_child(ast, node));
+            build_statement(b, ast_sibling(ast, ast_child(ast, node)));
+            break;
+
+        case NODE_ASSIGNMENT: {
+            IrValue start = (IrValue)f->instr_count;
+            IrValue v = build_expr(b, ast_child(ast, node));
+            build_copy(b, node, v, start);
+            break;
+        }
+
+        case NODE_BLOCK:
+            build_block(b, node);
+            break;
+
+        case NODE_CONDITIONAL:
+            build_conditional(b, node);
+            break;
+
+        case NODE_LOOP:
+            build_loop(b, node);
+            break;
+
+        case NODE_RETURN_STMT: {
+            IrValue v = build_expr(b, ast_child(ast, node));
+            emit(b, IR_RETURN, TYPE_VOID, &v, 1);
+            // o que vem depois do return fica num bloco sem predecessores
+            b->current = new_block(f);
+            break;
+        }
+
+        case NODE_PRINT: {
+            int base = b->pending_count;
+            for (AstId a = ast_child(ast, ast_child(ast, node)); a; a = ast_sibling(ast, a)) {
+                IrValue v = build_expr(b, a);
+                push_pending(b, v);
+            }
+            emit(b, IR_PRINT, TYPE_VOID, b->pending + base, b->pending_count - base);
+            b->pending_count = base;
+            break;
+        }
+
+        case NODE_SCAN:
+            for (AstId a = ast_child(ast, ast_child(ast, node)); a; a = ast_sibling(ast, a)) {
+                if (ast_type(ast, a) != NODE_IDENTIFIER) continue;
+                SymbolNode* sym = ast_symbol(ast, a);
+                IrValue v = emit(b, IR_SCAN, sym->type, NULL, 0);
+                f->instrs[v].var = sym;
+                int slot = slot_of(b, sym);
+                if (slot >= 0) define(b, slot, v);
+            }
+            break;
+
+        case NODE_FUNC_CALL:
+            build_expr(b, node);
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void build_block(Builder* b, AstId block) {
+    for (AstId stmt = ast_child(b->ast, block); stmt; stmt = ast_sibling(b->ast, stmt)) build_statement(b, stmt);
+}
+
+IrFunction* ir_build(const Ast* ast, AstId func, AstId body, SymbolTable* scope) {
+    IrFunction* f = (IrFunction*)calloc(1, sizeof(IrFunction));
+    if (!f) compile_error("Erro: memória insuficiente para a IR.");
+    f->symbol = func ? ast_symbol(ast, func) : NULL;
+    f->scope = scope;
+    f->body = body;
+
+    Builder b;
+    memset(&b, 0, sizeof(Builder));
+    b.ast = ast;
+    b.f = f;
+    b.slot_count = scope_frame_size(scope);
+    int slots = b.slot_count ? b.slot_count : 1;
+    b.slot_symbol = (SymbolNode**)calloc(slots, sizeof(SymbolNode*));
+    b.value = (IrValue*)calloc(slots, sizeof(IrValue));
+    b.stamp = (uint32_t*)calloc(slots, sizeof(uint32_t));
+    if (!b.slot_symbol || !b.value || !b.stamp) compile_error("Erro: memória insuficiente para a IR.");
+    for (SymbolNode* sym = scope->first; sym; sym = sym->next) {
+        if (sym->kind == KIND_VARIABLE || sym->kind == KIND_PARAMETER) b.slot_symbol[sym->address] = sym;
+    }
+
+    // a instrução 0 é IR_NONE
+    f->instrs = reserve(f->instrs, &f->instr_capacity, 0, sizeof(IrInstr));
+    memset(&f->instrs[0], 0, sizeof(IrInstr));
+    f->instr_count = 1;
+
+    // valores de entrada: os parâmetros e, para as outras variáveis, um
+    // valor indefinido
+    b.current = new_block(f);
+    for (int slot = 0; slot < b.slot_count; slot++) {
+        SymbolNode* sym = b.slot_symbol[slot];
+        if (!sym) continue;
+        IrValue v = emit(&b, sym->kind == KIND_PARAMETER ? IR_PARAM : IR_UNDEF, sym->type, NULL, 0);
+        f->instrs[v].var = sym;
+        b.value[slot] = v;
+    }
+
+    build_block(&b, body);
+    // cair no fim da função devolve zero
+    emit(&b, IR_RETURN, TYPE_VOID, NULL, 0);
+
+    free(b.slot_symbol);
+    free(b.value);
+    free(b.stamp);
+    free(b.log);
+    free(b.pending);
+    return f;
+}
+
+void ir_free(IrFunction* f) {
+    if (!f) return;
+    free(f->instrs);
+    free(f->operands);
+    free(f->blocks);
+    free(f->uses);
+    free(f->statements);
+    free(f);
+}
+
+// ---------------------------------------------------------------------------
+// listagem
+// ---------------------------------------------------------------------------
+
+static const char* op_name(const IrInstr* in) {
+    switch (in->op) {
+        case IR_CONST: return "const";
+        case IR_PARAM: return "param";
+        case IR_UNDEF: return "undef";
+        case IR_PHI: return "phi";
+        case IR_COPY: return "copy";
+        case IR_NEGATE: return "neg";
+        case IR_CONVERT: return "conv";
+        case IR_CALL: return "call";
+        case IR_SCAN: return "scan";
+        case IR_PRINT: return "print";
+        case IR_RETURN: return "ret";
+        case IR_JUMP: return "jump";
+        case IR_BRANCH: return "br";
+        default: break;
+    }
+    switch (in->node_op) {
+        case NODE_ADD: return "add";
+        case NODE_SUB: return "sub";
+        case NODE_MUL: return "mul";
+        case NODE_DIV: return "div";
+        case NODE_EQ: return "eq";
+        case NODE_NEQ: return "ne";
+        case NODE_LT: return "lt";
+        case NODE_LTE: return "le";
+        case NODE_GT: return "gt";
+        default: return "ge";
+    }
+}
+
+// na listagem otimizada, um valor constante aparece como o literal
+static void print_value(const IrFunction* f, IrValue v, int optimized, FILE* out) {
+    if (optimized && f->instrs[v].lattice == LATTICE_CONSTANT) constant_print(out, f->instrs[v].value);
+    else fprintf(out, "%%%u", v);
+}
+
+// a aresta pred -> bloco foi tomada
+static int edge_taken(const IrFunction* f, int pred, int optimized) {
+    return !optimized || f->blocks[pred].executable;
+}
+
+static void print_instr(const IrFunction* f, IrValue v, int optimized, FILE* out) {
+    const IrInstr* in = &f->instrs[v];
+    const IrBlock* block = &f->blocks[in->block];
+    fprintf(out, "  ");
+    if (in->op == IR_BRANCH && optimized && f->instrs[ir_operand(f, v, 0)].lattice == LATTICE_CONSTANT) {
+        // o ramo que nunca é tomado sumiu
+        int taken = constant_truth(f->instrs[ir_operand(f, v, 0)].value) ? 0 : 1;
+        fprintf(out, "jump bb%d\n", block->succ[taken]);
+        return;
+    }
+    if (in->op == IR_JUMP) {
+        fprintf(out, "jump bb%d\n", block->succ[0]);
+        return;
+    }
+    if (in->op == IR_BRANCH) {
+        fprintf(out, "br ");
+        print_value(f, ir_operand(f, v, 0), optimized, out);
+        fprintf(out, ", bb%d, bb%d\n", block->succ[0], block->succ[1]);
+        return;
+    }
+
+    int has_value = in->op != IR_PRINT && in->op != IR_RETURN;
+    if (has_value) fprintf(out, "%%%u = %s %s", v, op_name(in), in->type == TYPE_FLOAT ? "float" : "int");
+    else fprintf(out, "%s", op_name(in));
+    if (in->op == IR_CONST) {
+        fputc(' ', out);
+        constant_print(out, in->value);
+    } else if (in->op == IR_CALL) {
+        fprintf(out, " %s(", in->var->name);
+    }
+
+    for (int i = 0; i < in->operand_count; i++) {
+        IrValue operand = ir_operand(f, v, i);
+        if (in->op == IR_PHI) {
+            if (!edge_taken(f, block->pred[i], optimized)) continue;
+            fprintf(out, "%s[", i > 0 && edge_taken(f, block->pred[0], optimized) ? ", " : " ");
+            print_value(f, operand, optimized, out);
+            fprintf(out, ", bb%d]", block->pred[i]);
+            continue;
+        }
+        fprintf(out, i > 0 ? ", " : in->op == IR_CALL ? "" : " ");
+        print_value(f, operand, optimized, out);
+    }
+    if (in->op == IR_CALL) fputc(')', out);
+    if (in->var && in->op != IR_CALL) fprintf(out, "    ; %s", in->var->name);
+    fputc('\n', out);
+}
+
+void ir_print(const IrFunction* f, int optimized, FILE* out) {
+    if (f->symbol) fprintf(out, "function %s:\n", f->symbol->name);
+    else fprintf(out, "principal:\n");
+    for (int i = 0; i < f->block_count; i++) {
+        const IrBlock* block = &f->blocks[i];
+        if (optimized && !block->executable) continue;
+        fprintf(out, "bb%d:", i);
+        int shown = 0;
+        for (int k = 0; k < block->pred_count; k++) {
+            if (!edge_taken(f, block->pred[k], optimized)) continue;
+            fprintf(out, "%s bb%d", shown++ ? "," : "    ; preds", block->pred[k]);
+        }
+        fputc('\n', out);
+        for (IrValue v = block->first; v; v = f->instrs[v].next) {
+            if (optimized && !(f->instrs[v].flags & IR_LIVE)) continue;
+            print_instr(f, v, optimized, out);
+        }
+    }
+}
+
+void ir_dump_program(const Ast* ast, SymbolTable* global_scope, int optimized, FILE* out) {
+    int first = 1;
+    for (AstId n = ast_child(ast, ast->root); n; n = ast_sibling(ast, n)) {
+        IrFunction* f;
+        if (ast_type(ast, n) == NODE_FUNC_DECL) f = ir_build(ast, n, ast_sibling(ast, ast_child(ast, n)), ast_scope(ast, n));
+        else f = ir_build(ast, AST_NONE, n, global_scope);
+        if (optimized) {
+            ir_propagate_constants(f);
+            ir_mark_live(f);
+        }
+        if (!first) fputc('\n', out);
+        first = 0;
+        ir_print(f, optimized, out);
+        ir_free(f);
+    }
+}
@@ -0,0 +1,319 @@
+#include "ir.h"
+#include "diagnostic.h"
+#include <stdlib.h>
+#include <string.h>
+
+// estado da propagação de constantes
+typedef struct {
+    IrFunction* f;
+    uint8_t* edge_taken;        // [bloco * 2 + k]: a aresta para succ[k] executa
+    int* user_start;            // usuários de cada valor (CSR)
+    IrValue* users;
+    int* edges;                 // pilha de arestas (bloco * 2 + k)
+    int edge_count;
+    IrValue* values;            // pilha de valores que mudaram
+    int value_count;
+    int value_capacity;
+} Propagation;
+
+static void* checked_calloc(size_t count, size_t size) {
+    void* p = calloc(count ? count : 1, size);
+    if (!p) compile_error("Erro: memória insuficiente para a IR.");
+    return p;
+}
+
+static int edge_index(const IrFunction* f, int from, int to) {
+    return from * 2 + (f->blocks[from].succ[0] == to ? 0 : 1);
+}
+
+static void push_edge(Propagation* p, int block, int k) {
+    // cada aresta entra uma vez só, então a pilha cabe em 2 * blocos
+    if (!p->edge_taken[block * 2 + k]) p->edges[p->edge_count++] = block * 2 + k;
+}
+
+static void set_lattice(Propagation* p, IrValue v, Lattice lattice, Constant value) {
+    IrInstr* in = &p->f->instrs[v];
+    // valores sem literal não podem ir para a AST; contam como variáveis
+    if (lattice == LATTICE_CONSTANT && !constant_has_literal(value)) lattice = LATTICE_VARYING;
+    if (lattice == LATTICE_CONSTANT && in->lattice == LATTICE_CONSTANT) {
+        if (constant_equal(value, in->value)) return;
+        lattice = LATTICE_VARYING;
+    }
+    // o reticulado só sobe
+    if (lattice <= in->lattice) return;
+    in->lattice = (uint8_t)lattice;
+    if (lattice == LATTICE_CONSTANT) in->value = value;
+    if (p->value_count >= p->value_capacity) {
+        p->value_capacity = p->value_capacity ? p->value_capacity * 2 : 64;
+        p->values = (IrValue*)realloc(p->values, p->value_capacity * sizeof(IrValue));
+        if (!p->values) compile_error("Erro: memória insuficiente para a IR.");
+    }
+    p->values[p->value_count++] = v;
+}
+
+static void evaluate(Propagation* p, IrValue v) {
+    IrFunction* f = p->f;
+    IrInstr* in = &f->instrs[v];
+    Constant result = in->value;
+    Lattice lattice = LATTICE_UNKNOWN;
+
+    switch (in->op) {
+        case IR_CONST:
+            lattice = LATTICE_CONSTANT;
+            break;
+
+        case IR_PARAM: case IR_UNDEF: case IR_CALL: case IR_SCAN:
+            lattice = LATTICE_VARYING;
+            break;
+
+        case IR_PHI: {
+            // só contam os valores que chegam por arestas já executadas
+            const IrBlock* block = &f->blocks[in->block];
+            for (int i = 0; i < in->operand_count && lattice != LATTICE_VARYING; i++) {
+                if (!p->edge_taken[edge_index(f, block->pred[i], in->block)]) continue;
+                const IrInstr* operand = &f->instrs[ir_operand(f, v, i)];
+                if (operand->lattice == LATTICE_VARYING) lattice = LATTICE_VARYING;
+                else if (operand->lattice == LATTICE_CONSTANT) {
+                    if (lattice == LATTICE_UNKNOWN) {
+                        lattice = LATTICE_CONSTANT;
+                        result = operand->value;
+                    } else if (!constant_equal(result, operand->value)) {
+                        lattice = LATTICE_VARYING;
+                    }
+                }
+            }
+            break;
+        }
+
+        case IR_COPY: case IR_NEGATE: case IR_CONVERT: case IR_BINARY: {
+            lattice = LATTICE_CONSTANT;
+            for (int i = 0; i < in->operand_count; i++) {
+                Lattice operand = (Lattice)f->instrs[ir_operand(f, v, i)].lattice;
+                if (operand == LATTICE_VARYING) lattice = LATTICE_VARYING;
+                else if (operand == LATTICE_UNKNOWN && lattice == LATTICE_CONSTANT) lattice = LATTICE_UNKNOWN;
+            }
+            if (lattice != LATTICE_CONSTANT) break;
+            Constant a = f->instrs[ir_operand(f, v, 0)].value;
+            int ok = 1;
+            if (in->op == IR_COPY) result = a;
+            else if (in->op == IR_NEGATE) ok = constant_negate(a, &result);
+            else if (in->op == IR_CONVERT) ok = constant_convert(a, (SymbolDataType)in->type, &result);
+            else ok = constant_binary((NodeType)in->node_op, a, f->instrs[ir_operand(f, v, 1)].value, &result);
+            if (!ok) lattice = LATTICE_VARYING;
+            break;
+        }
+
+        case IR_JUMP:
+            push_edge(p, in->block, 0);
+            return;
+
+        case IR_BRANCH: {
+            const IrInstr* cond = &f->instrs[ir_operand(f, v, 0)];
+            if (cond->lattice == LATTICE_CONSTANT) {
+                push_edge(p, in->block, constant_truth(cond->value) ? 0 : 1);
+            } else if (cond->lattice == LATTICE_VARYING) {
+                push_edge(p, in->block, 0);
+                push_edge(p, in->block, 1);
+            }
+            return;
+        }
+
+        default:
+            return;
+    }
+    if (lattice != LATTICE_UNKNOWN) set_lattice(p, v, lattice, result);
+}
+
+void ir_propagate_constants(IrFunction* f) {
+    Propagation p;
+    memset(&p, 0, sizeof(Propagation));
+    p.f = f;
+    p.edge_taken = (uint8_t*)checked_calloc((size_t)f->block_count * 2, sizeof(uint8_t));
+    p.edges = (int*)checked_calloc((size_t)f->block_count * 2, sizeof(int));
+
+    // lista de usuários de cada valor
+    p.user_start = (int*)checked_calloc((size_t)f->instr_count + 1, sizeof(int));
+    p.users = (IrValue*)checked_calloc((size_t)f->operand_count, sizeof(IrValue));
+    for (int i = 0; i < f->operand_count; i++) p.user_start[f->operands[i] + 1]++;
+    for (int v = 0; v < f->instr_count; v++) p.user_start[v + 1] += p.user_start[v];
+    int* fill = (int*)checked_calloc((size_t)f->instr_count, sizeof(int));
+    for (int v = 1; v < f->instr_count; v++) {
+        for (int i = 0; i < f->instrs[v].operand_count; i++) {
+            IrValue operand = ir_operand(f, (IrValue)v, i);
+            p.users[p.user_start[operand] + fill[operand]++] = (IrValue)v;
+        }
+    }
+    free(fill);
+
+    for (int v = 0; v < f->instr_count; v++) f->instrs[v].lattice = LATTICE_UNKNOWN;
+    for (int b = 0; b < f->block_count; b++) f->blocks[b].executable = 0;
+
+    // o bloco de entrada executa sempre
+    f->blocks[0].executable = 1;
+    for (IrValue v = f->blocks[0].first; v; v = f->instrs[v].next) evaluate(&p, v);
+
+    while (p.edge_count || p.value_count) {
+        if (p.edge_count) {
+            int edge = p.edges[--p.edge_count];
+            if (p.edge_taken[edge]) continue;
+            p.edge_taken[edge] = 1;
+            int target = f->blocks[edge / 2].succ[edge % 2];
+            IrBlock* block = &f->blocks[target];
+            // na primeira vez o bloco inteiro; depois, só os phis mudam
+            int first_visit = !block->executable;
+            block->executable = 1;
+            for (IrValue v = block->first; v; v = f->instrs[v].next) {
+                if (!first_visit && f->instrs[v].op != IR_PHI) break;
+                evaluate(&p, v);
+            }
+            continue;
+        }
+        IrValue v = p.values[--p.value_count];
+        for (int i = p.user_start[v]; i < p.user_start[v + 1]; i++) {
+            IrValue user = p.users[i];
+            if (f->blocks[f->instrs[user].block].executable) evaluate(&p, user);
+        }
+    }
+
+    free(p.edge_taken);
+    free(p.edges);
+    free(p.user_start);
+    free(p.users);
+    free(p.values);
+}
+
+// ---------------------------------------------------------------------------
+// código morto
+// ---------------------------------------------------------------------------
+
+// divisão inteira cujo divisor pode ser zero (o erro na execução é um efeito)
+static int may_trap(const IrFunction* f, IrValue v) {
+    const IrInstr* in = &f->instrs[v];
+    if (in->op != IR_BINARY || in->node_op != NODE_DIV || in->type != TYPE_INTEGER) return 0;
+    const IrInstr* divisor = &f->instrs[ir_operand(f, v, 1)];
+    return !(divisor->lattice == LATTICE_CONSTANT && divisor->value.i != 0);
+}
+
+static int has_effect(const IrFunction* f, IrValue v) {
+    const IrInstr* in = &f->instrs[v];
+    switch (in->op) {
+        case IR_PRINT: case IR_CALL: case IR_SCAN: case IR_RETURN: case IR_JUMP: case IR_BRANCH:
+            return 1;
+        case IR_COPY:
+            // a atribuição fica na AST se a expressão tiver efeito
+            if (in->flags & IR_PINNED) return 1;
+            for (IrValue e = in->expr_start; e < v; e++) {
+                if (f->instrs[e].op == IR_CALL || may_trap(f, e)) return 1;
+            }
+            return 0;
+        default:
+            return may_trap(f, v);
+    }
+}
+
+void ir_mark_live(IrFunction* f) {
+    IrValue* stack = (IrValue*)checked_calloc((size_t)f->instr_count, sizeof(IrValue));
+    int count = 0;
+    for (int v = 1; v < f->instr_count; v++) f->instrs[v].flags &= (uint8_t)~IR_LIVE;
+    for (int v = 1; v < f->instr_count; v++) {
+        if (!f->blocks[f->instrs[v].block].executable || !has_effect(f, (IrValue)v)) continue;
+        f->instrs[v].flags |= IR_LIVE;
+        stack[count++] = (IrValue)v;
+    }
+
+    while (count) {
+        IrValue v = stack[--count];
+        const IrInstr* in = &f->instrs[v];
+        const IrBlock* block = &f->blocks[in->block];
+        for (int i = 0; i < in->operand_count; i++) {
+            // phi: valores de arestas que nunca executam não são lidos
+            if (in->op == IR_PHI && !f->blocks[block->pred[i]].executable) continue;
+            IrValue operand = ir_operand(f, v, i);
+            IrInstr* def = &f->instrs[operand];
+            // constantes viram literais e não precisam de quem as calculou,
+            // menos as que chegam num phi variável: na AST elas continuam
+            // sendo uma atribuição que o laço ou o if lê
+            if ((def->lattice == LATTICE_CONSTANT && in->op != IR_PHI) || (def->flags & IR_LIVE)) continue;
+            def->flags |= IR_LIVE;
+            stack[count++] = operand;
+        }
+    }
+    free(stack);
+}
+
+// ---------------------------------------------------------------------------
+// de volta para a AST
+// ---------------------------------------------------------------------------
+
+static void remove_dead(Ast* ast, AstId block, const uint8_t* dead);
+
+// o que sobra da instrução (AST_NONE se ela sair inteira)
+static AstId live_part(Ast* ast, AstId stmt, const uint8_t* dead) {
+    if (dead[stmt]) return AST_NONE;
+    switch (ast_type(ast, stmt)) {
+        case NODE_DECL_ASSIGN: {
+            // int x = e; vira só x = e; quando o zero da declaração nunca é lido
+            AstId decl = ast_child(ast, stmt), assign = ast_sibling(ast, decl);
+            if (dead[decl] && dead[assign]) return AST_NONE;
+            if (dead[decl]) return assign;
+            if (dead[assign]) return decl;
+            break;
+        }
+        case NODE_BLOCK:
+            remove_dead(ast, stmt, dead);
+            break;
+        case NODE_CONDITIONAL:
+        case NODE_LOOP:
+            for (AstId c = ast_sibling(ast, ast_child(ast, stmt)); c; c = ast_sibling(ast, c)) remove_dead(ast, c, dead);
+            break;
+        default:
+            break;
+    }
+    return stmt;
+}
+
+static void remove_dead(Ast* ast, AstId block, const uint8_t* dead) {
+    AstId last = AST_NONE;
+    for (AstId stmt = ast_child(ast, block); stmt;) {
+        AstId next = ast_sibling(ast, stmt);
+        AstId keep = live_part(ast, stmt, dead);
+        if (keep) {
+            if (last) ast->sibling[last] = keep;
+            else ast->child[block] = keep;
+            last = keep;
+        }
+        stmt = next;
+    }
+    if (last) ast->sibling[last] = AST_NONE;
+    else ast->child[block] = AST_NONE;
+    ast->last_child[block] = last;
+}
+
+static void apply(Ast* ast, const IrFunction* f, uint8_t* dead) {
+    for (int i = 0; i < f->use_count; i++) {
+        const IrInstr* value = &f->instrs[f->uses[i].index];
+        if (value->lattice == LATTICE_CONSTANT) constant_replace_node(ast, f->uses[i].node, value->value);
+    }
+    for (int i = 0; i < f->statement_count; i++) {
+        if (!f->blocks[f->statements[i].index].executable) dead[f->statements[i].node] = 1;
+    }
+    for (int v = 1; v < f->instr_count; v++) {
+        const IrInstr* in = &f->instrs[v];
+        if (in->op == IR_COPY && !(in->flags & IR_LIVE)) dead[in->origin] = 1;
+    }
+    remove_dead(ast, f->body, dead);
+}
+
+void ir_optimize_ast(Ast* ast, SymbolTable* global_scope) {
+    uint8_t* dead = (uint8_t*)checked_calloc((size_t)ast->count, sizeof(uint8_t));
+    for (AstId n = ast_child(ast, ast->root); n; n = ast_sibling(ast, n)) {
+        IrFunction* f;
+        if (ast_type(ast, n) == NODE_FUNC_DECL) f = ir_build(ast, n, ast_sibling(ast, ast_child(ast, n)), ast_scope(ast, n));
+        else f = ir_build(ast, AST_NONE, n, global_scope);
+        ir_propagate_constants(f);
+        ir_mark_live(f);
+        apply(ast, f, dead);
+        ir_free(f);
+    }
+    free(dead);
+}
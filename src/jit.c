@@ -0,0 +1,811 @@
+#include "jit.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(__x86_64__) && (defined(__unix__) || defined(__APPLE__))
+
+#include "types.h"
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#define MAX_INT_ARGS 6
+#define MAX_FLOAT_ARGS 8
+
+// registradores x86-64 na numeração do encoding
+enum { RAX = 0, RCX = 1, RDX = 2, RSP = 4, RBP = 5, RSI = 6, RDI = 7, R8 = 8, R9 = 9 };
+static const int int_arg_registers[MAX_INT_ARGS] = { RDI, RSI, RDX, RCX, R8, R9 };
+
+// códigos de condição (o mesmo nibble serve para jcc e setcc; cc ^ 1 é a negação)
+enum { CC_B = 0x2, CC_AE = 0x3, CC_E = 0x4, CC_NE = 0x5, CC_BE = 0x6, CC_A = 0x7,
+       CC_P = 0xA, CC_NP = 0xB, CC_L = 0xC, CC_GE = 0xD, CC_LE = 0xE, CC_G = 0xF };
+
+typedef struct {
+    const char* name;
+    AstId decl;             // AST_NONE para o bloco principal
+    SymbolTable* scope;
+    AstId body;
+    SymbolDataType return_type;
+    int param_count;
+    SymbolDataType* param_types;
+    size_t offset;          // início do código da função no buffer
+} JitFunction;
+
+// chamada a uma função ainda não gerada, corrigida no fim
+typedef struct {
+    size_t at;              // posição do rel32
+    int function;
+} CallFixup;
+
+typedef struct {
+    const Ast* ast;
+    uint8_t* code;
+    size_t size;
+    size_t capacity;
+
+    JitFunction* functions;
+    int function_count;
+    CallFixup* fixups;
+    int fixup_count;
+    int fixup_capacity;
+
+    SymbolDataType return_type;
+    int depth;              // valores de 8 bytes empilhados
+} Jit;
+
+static void jit_error(const char* message, const char* name) {
+    fprintf(stderr, "Erro do JIT: %s", message);
+    if (name) fprintf(stderr, " ('%s')", name);
+    fprintf(stderr, ".\n");
+    exit(EXIT_FAILURE);
+}
+
+// ---------------------------------------------------------------------------
+// rotinas chamadas pelo código gerado
+// ---------------------------------------------------------------------------
+
+static void runtime_error(const char* message) {
+    fflush(stdout);
+    fprintf(stderr, "Erro de Execução: %s.\n", message);
+    exit(EXIT_FAILURE);
+}
+
+static void rt_print_int(long long value, int end) { printf("%lld%c", value, end); }
+static void rt_print_float(double value, int end) { printf("%g%c", value, end); }
+static void rt_newline(void) { putchar('\n'); }
+static void rt_div_error(void) { runtime_error("divisão por zero"); }
+
+static long long rt_scan_int(void) {
+    long long value;
+    if (scanf("%lld", &value) != 1) runtime_error("entrada inválida para scan");
+    return value;
+}
+
+static double rt_scan_float(void) {
+    double value;
+    if (scanf("%lf", &value) != 1) runtime_error("entrada inválida para scan");
+    return value;
+}
+
+// ---------------------------------------------------------------------------
+// emissão de bytes
+// ---------------------------------------------------------------------------
+
+static void emit_byte(Jit* j, uint8_t b) {
+    if (j->size >= j->capacity) {
+        j->capacity = j->capacity ? j->capacity * 2 : 4096;
+        j->code = (uint8_t*)realloc(j->code, j->capacity);
+        if (!j->code) jit_error("memória insuficiente", NULL);
+    }
+    j->code[j->size++] = b;
+}
+
+static void emit_bytes(Jit* j, const uint8_t* bytes, int count) {
+    for (int i = 0; i < count; i++) emit_byte(j, bytes[i]);
+}
+
+#define EMIT(j, ...) do { \
+    static const uint8_t bytes_[] = { __VA_ARGS__ }; \
+    emit_bytes(j, bytes_, sizeof(bytes_)); \
+} while (0)
+
+static void emit_u32(Jit* j, uint32_t v) {
+    for (int i = 0; i < 4; i++) emit_byte(j, (uint8_t)(v >> (8 * i)));
+}
+
+static void emit_u64(Jit* j, uint64_t v) {
+    for (int i = 0; i < 8; i++) emit_byte(j, (uint8_t)(v >> (8 * i)));
+}
+
+static void patch_rel32(Jit* j, size_t at, size_t target) {
+    int32_t rel = (int32_t)((int64_t)target - (int64_t)(at + 4));
+    memcpy(j->code + at, &rel, 4);
+}
+
+// deslocamento da variável no quadro: [rbp - 8 * (endereço + 1)]
+static int32_t slot(int address) {
+    return -8 * (address + 1);
+}
+
+// mov reg, [rbp + disp32] / mov [rbp + disp32], reg
+static void emit_load(Jit* j, int reg, int address) {
+    emit_byte(j, reg >= 8 ? 0x4C : 0x48);
+    emit_byte(j, 0x8B);
+    emit_byte(j, 0x85 | ((reg & 7) << 3));
+    emit_u32(j, (uint32_t)slot(address));
+}
+
+static void emit_store(Jit* j, int reg, int address) {
+    emit_byte(j, reg >= 8 ? 0x4C : 0x48);
+    emit_byte(j, 0x89);
+    emit_byte(j, 0x85 | ((reg & 7) << 3));
+    emit_u32(j, (uint32_t)slot(address));
+}
+
+// movsd xmmN, [rbp + disp32] / movsd [rbp + disp32], xmmN
+static void emit_load_xmm(Jit* j, int xmm, int address) {
+    EMIT(j, 0xF2, 0x0F, 0x10);
+    emit_byte(j, 0x85 | (xmm << 3));
+    emit_u32(j, (uint32_t)slot(address));
+}
+
+static void emit_store_xmm(Jit* j, int xmm, int address) {
+    EMIT(j, 0xF2, 0x0F, 0x11);
+    emit_byte(j, 0x85 | (xmm << 3));
+    emit_u32(j, (uint32_t)slot(address));
+}
+
+// mov rax/rcx, imediato
+static void emit_mov_imm(Jit* j, int reg, long long value) {
+    if (value >= INT32_MIN && value <= INT32_MAX) {
+        EMIT(j, 0x48, 0xC7);
+        emit_byte(j, 0xC0 | reg);
+        emit_u32(j, (uint32_t)value);
+    } else {
+        emit_byte(j, 0x48);
+        emit_byte(j, 0xB8 | reg);
+        emit_u64(j, (uint64_t)value);
+    }
+}
+
+// carrega a constante float em xmm0 ou xmm1 passando por rax
+static void emit_load_float_imm(Jit* j, int xmm, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    emit_byte(j, 0x48);
+    emit_byte(j, 0xB8);
+    emit_u64(j, bits);
+    EMIT(j, 0x66, 0x48, 0x0F, 0x6E);    // movq xmmN, rax
+    emit_byte(j, 0xC0 | (xmm << 3));
+}
+
+static void emit_push_rax(Jit* j) {
+    emit_byte(j, 0x50);
+    j->depth++;
+}
+
+static void emit_pop(Jit* j, int reg) {
+    if (reg >= 8) emit_byte(j, 0x41);
+    emit_byte(j, 0x58 | (reg & 7));
+    j->depth--;
+}
+
+static void emit_push_xmm0(Jit* j) {
+    EMIT(j, 0x48, 0x83, 0xEC, 0x08);            // sub rsp, 8
+    EMIT(j, 0xF2, 0x0F, 0x11, 0x04, 0x24);      // movsd [rsp], xmm0
+    j->depth++;
+}
+
+static void emit_pop_xmm(Jit* j, int xmm) {
+    EMIT(j, 0xF2, 0x0F, 0x10);                  // movsd xmmN, [rsp]
+    emit_byte(j, 0x04 | (xmm << 3));
+    emit_byte(j, 0x24);
+    EMIT(j, 0x48, 0x83, 0xC4, 0x08);            // add rsp, 8
+    j->depth--;
+}
+
+// mov reg, [rsp + disp32] / movsd xmmN, [rsp + disp32] / push qword [rsp + disp32]
+static void emit_load_stack(Jit* j, int reg, int offset) {
+    emit_byte(j, reg >= 8 ? 0x4C : 0x48);
+    emit_byte(j, 0x8B);
+    emit_byte(j, 0x84 | ((reg & 7) << 3));
+    emit_byte(j, 0x24);
+    emit_u32(j, (uint32_t)offset);
+}
+
+static void emit_load_stack_xmm(Jit* j, int xmm, int offset) {
+    EMIT(j, 0xF2, 0x0F, 0x10);
+    emit_byte(j, 0x84 | (xmm << 3));
+    emit_byte(j, 0x24);
+    emit_u32(j, (uint32_t)offset);
+}
+
+static void emit_push_stack(Jit* j, int offset) {
+    EMIT(j, 0xFF, 0xB4, 0x24);
+    emit_u32(j, (uint32_t)offset);
+}
+
+// salto com destino a corrigir; devolve a posição do rel32
+static size_t emit_jump(Jit* j) {
+    emit_byte(j, 0xE9);
+    emit_u32(j, 0);
+    return j->size - 4;
+}
+
+static size_t emit_jcc(Jit* j, int cc) {
+    emit_byte(j, 0x0F);
+    emit_byte(j, 0x80 | cc);
+    emit_u32(j, 0);
+    return j->size - 4;
+}
+
+// chama uma função C com a pilha alinhada em 16 bytes
+static void emit_call_native(Jit* j, void* target) {
+    if (j->depth % 2) EMIT(j, 0x48, 0x83, 0xEC, 0x08);
+    emit_byte(j, 0x48);
+    emit_byte(j, 0xB8);
+    emit_u64(j, (uint64_t)(uintptr_t)target);   // mov rax, imm64
+    EMIT(j, 0xFF, 0xD0);                        // call rax
+    if (j->depth % 2) EMIT(j, 0x48, 0x83, 0xC4, 0x08);
+}
+
+// ---------------------------------------------------------------------------
+// expressões: inteiros terminam em rax, floats em xmm0
+// ---------------------------------------------------------------------------
+
+// variável ligada ao nó pelo parser
+static SymbolNode* node_variable(Jit* j, AstId node) {
+    SymbolNode* sym = ast_symbol(j->ast, node);
+    if (sym->kind != KIND_VARIABLE && sym->kind != KIND_PARAMETER) {
+        jit_error("identificador não é uma variável", sym->name);
+    }
+    return sym;
+}
+
+static int find_function(Jit* j, NameId name) {
+    for (int i = 0; i < j->function_count; i++) {
+        if (j->functions[i].decl && ast_name(j->ast, j->functions[i].decl) == name) return i;
+    }
+    jit_error("função desconhecida", intern_name(name));
+    return -1;
+}
+
+static void gen_int(Jit* j, AstId e);
+static void gen_float(Jit* j, AstId e);
+
+static void gen_value(Jit* j, AstId e, SymbolDataType type) {
+    if (type == TYPE_FLOAT) {
+        gen_float(j, e);
+    } else if (expr_type(j->ast, e) == TYPE_FLOAT) {
+        gen_float(j, e);
+        EMIT(j, 0xF2, 0x48, 0x0F, 0x2C, 0xC0);  // cvttsd2si rax, xmm0
+    } else {
+        gen_int(j, e);
+    }
+}
+
+// coloca o operando direito em rcx sem mexer em rax, se for simples
+static int load_simple_rcx(Jit* j, AstId e) {
+    if (ast_type(j->ast, e) == NODE_INT_LITERAL) {
+        emit_mov_imm(j, RCX, strtoll(ast_value(j->ast, e), NULL, 10));
+        return 1;
+    }
+    if (ast_type(j->ast, e) == NODE_IDENTIFIER && expr_type(j->ast, e) == TYPE_INTEGER) {
+        emit_load(j, RCX, node_variable(j, e)->address);
+        return 1;
+    }
+    return 0;
+}
+
+// esquerdo em rax, direito em rcx
+static void gen_int_operands(Jit* j, AstId left, AstId right) {
+    gen_int(j, left);
+    if (load_simple_rcx(j, right)) return;
+    emit_push_rax(j);
+    gen_int(j, right);
+    EMIT(j, 0x48, 0x89, 0xC1);                  // mov rcx, rax
+    emit_pop(j, RAX);
+}
+
+// esquerdo em xmm0, direito em xmm1
+static void gen_float_operands(Jit* j, AstId left, AstId right) {
+    gen_float(j, left);
+    if (ast_type(j->ast, right) == NODE_FLOAT_LITERAL) {
+        emit_load_float_imm(j, 1, strtod(ast_value(j->ast, right), NULL));
+        return;
+    }
+    if (ast_type(j->ast, right) == NODE_IDENTIFIER && expr_type(j->ast, right) == TYPE_FLOAT) {
+        emit_load_xmm(j, 1, node_variable(j, right)->address);
+        return;
+    }
+    emit_push_xmm0(j);
+    gen_float(j, right);
+    EMIT(j, 0x66, 0x0F, 0x28, 0xC8);            // movapd xmm1, xmm0
+    emit_pop_xmm(j, 0);
+}
+
+static int int_condition(NodeType type) {
+    switch (type) {
+        case NODE_EQ: return CC_E;
+        case NODE_NEQ: return CC_NE;
+        case NODE_LT: return CC_L;
+        case NODE_LTE: return CC_LE;
+        case NODE_GT: return CC_G;
+        default: return CC_GE;
+    }
+}
+
+// compara floats; devolve o código de condição verdadeiro ou -1 para ==/!=
+static int gen_float_compare(Jit* j, AstId cmp) {
+    gen_float_operands(j, ast_child(j->ast, cmp), ast_sibling(j->ast, ast_child(j->ast, cmp)));
+    switch (ast_type(j->ast, cmp)) {
+        case NODE_GT:  EMIT(j, 0x66, 0x0F, 0x2E, 0xC1); return CC_A;   // ucomisd xmm0, xmm1
+        case NODE_GTE: EMIT(j, 0x66, 0x0F, 0x2E, 0xC1); return CC_AE;
+        case NODE_LT:  EMIT(j, 0x66, 0x0F, 0x2E, 0xC8); return CC_A;   // ucomisd xmm1, xmm0
+        case NODE_LTE: EMIT(j, 0x66, 0x0F, 0x2E, 0xC8); return CC_AE;
+        default:       EMIT(j, 0x66, 0x0F, 0x2E, 0xC1); return -1;
+    }
+}
+
+static void gen_call(Jit* j, AstId e) {
+    // as funções estão na ordem de declaração, a mesma de symbol->order
+    int index = ast_symbol(j->ast, e)->order;
+    JitFunction* callee = &j->functions[index];
+    AstId args = ast_child(j->ast, e) ? ast_child(j->ast, ast_child(j->ast, e)) : AST_NONE;
+    int argc = 0;
+    for (AstId a = args; a; a = ast_sibling(j->ast, a)) argc++;
+    if (argc != callee->param_count) jit_error("número de argumentos incorreto na chamada", ast_value(j->ast, e));
+
+    // os que não cabem nos registradores vão pela pilha (System V)
+    int ints = 0, floats = 0, stacked = 0;
+    for (int i = 0; i < argc; i++) {
+        if (callee->param_types[i] == TYPE_FLOAT) stacked += floats++ >= MAX_FLOAT_ARGS;
+        else stacked += ints++ >= MAX_INT_ARGS;
+    }
+
+    // o argumento i fica em [rsp + 8 * (argc - 1 - i + above)], com above
+    // valores empilhados depois dele
+    int i = 0;
+    for (AstId a = args; a; a = ast_sibling(j->ast, a), i++) {
+        gen_value(j, a, callee->param_types[i]);
+        if (callee->param_types[i] == TYPE_FLOAT) emit_push_xmm0(j);
+        else emit_push_rax(j);
+    }
+    int above = 0;
+    if ((j->depth + stacked) % 2) {
+        EMIT(j, 0x48, 0x83, 0xEC, 0x08);        // sub rsp, 8
+        above++;
+    }
+
+    // copia os argumentos da pilha da direita para a esquerda
+    int int_index = ints, float_index = floats;
+    for (i = argc - 1; i >= 0; i--) {
+        int on_stack = callee->param_types[i] == TYPE_FLOAT ? --float_index >= MAX_FLOAT_ARGS : --int_index >= MAX_INT_ARGS;
+        if (!on_stack) continue;
+        emit_push_stack(j, 8 * (argc - 1 - i + above));
+        above++;
+    }
+    for (i = argc - 1; i >= 0; i--) {
+        int offset = 8 * (argc - 1 - i + above);
+        if (callee->param_types[i] == TYPE_FLOAT) {
+            if (--floats < MAX_FLOAT_ARGS) emit_load_stack_xmm(j, floats, offset);
+        } else if (--ints < MAX_INT_ARGS) {
+            emit_load_stack(j, int_arg_registers[ints], offset);
+        }
+    }
+
+    emit_byte(j, 0xE8);                         // call rel32
+    if (j->fixup_count >= j->fixup_capacity) {
+        j->fixup_capacity = j->fixup_capacity ? j->fixup_capacity * 2 : 16;
+        j->fixups = (CallFixup*)realloc(j->fixups, j->fixup_capacity * sizeof(CallFixup));
+    }
+    j->fixups[j->fixup_count++] = (CallFixup){ j->size, index };
+    emit_u32(j, 0);
+    EMIT(j, 0x48, 0x81, 0xC4);                  // add rsp, imm32
+    emit_u32(j, (uint32_t)(8 * (argc + above)));
+    j->depth -= argc;
+}
+
+static void gen_int(Jit* j, AstId e) {
+    switch (ast_type(j->ast, e)) {
+        case NODE_INT_LITERAL:
+            emit_mov_imm(j, RAX, strtoll(ast_value(j->ast, e), NULL, 10));
+            return;
+        case NODE_IDENTIFIER:
+            emit_load(j, RAX, node_variable(j, e)->address);
+            return;
+        case NODE_FUNC_CALL:
+            gen_call(j, e);
+            return;
+        case NODE_NEGATE:
+            gen_int(j, ast_child(j->ast, e));
+            EMIT(j, 0x48, 0xF7, 0xD8);          // neg rax
+            return;
+        case NODE_ADD:
+            gen_int_operands(j, ast_child(j->ast, e), ast_sibling(j->ast, ast_child(j->ast, e)));
+            EMIT(j, 0x48, 0x01, 0xC8);          // add rax, rcx
+            return;
+        case NODE_SUB:
+            gen_int_operands(j, ast_child(j->ast, e), ast_sibling(j->ast, ast_child(j->ast, e)));
+            EMIT(j, 0x48, 0x29, 0xC8);          // sub rax, rcx
+            return;
+        case NODE_MUL:
+            gen_int_operands(j, ast_child(j->ast, e), ast_sibling(j->ast, ast_child(j->ast, e)));
+            EMIT(j, 0x48, 0x0F, 0xAF, 0xC1);    // imul rax, rcx
+            return;
+        case NODE_DIV: {
+            gen_int_operands(j, ast_child(j->ast, e), ast_sibling(j->ast, ast_child(j->ast, e)));
+            EMIT(j, 0x48, 0x85, 0xC9);          // test rcx, rcx
+            size_t ok = emit_jcc(j, CC_NE);
+            EMIT(j, 0x48, 0x83, 0xE4, 0xF0);    // and rsp, -16
+            int depth = j->depth;
+            j->depth = 0;
+            emit_call_native(j, (void*)rt_div_error);
+            j->depth = depth;
+            patch_rel32(j, ok, j->size);
+            // x / -1 vira -x, como nos outros backends (idiv daria SIGFPE
+            // com o menor inteiro)
+            EMIT(j, 0x48, 0x83, 0xF9, 0xFF);    // cmp rcx, -1
+            size_t divide = emit_jcc(j, CC_NE);
+            EMIT(j, 0x48, 0xF7, 0xD8);          // neg rax
+            size_t done = emit_jump(j);
+            patch_rel32(j, divide, j->size);
+            EMIT(j, 0x48, 0x99);                // cqo
+            EMIT(j, 0x48, 0xF7, 0xF9);          // idiv rcx
+            patch_rel32(j, done, j->size);
+            return;
+        }
+        default:
+            break;
+    }
+    if (!is_comparison(ast_type(j->ast, e))) jit_error("expressão inteira inválida", ast_value(j->ast, e));
+
+    if (operand_type(j->ast, e) == TYPE_INTEGER) {
+        gen_int_operands(j, ast_child(j->ast, e), ast_sibling(j->ast, ast_child(j->ast, e)));
+        EMIT(j, 0x48, 0x39, 0xC8);              // cmp rax, rcx
+        EMIT(j, 0x0F);
+        emit_byte(j, 0x90 | int_condition(ast_type(j->ast, e)));
+        emit_byte(j, 0xC0);                     // setcc al
+    } else {
+        int cc = gen_float_compare(j, e);
+        if (cc >= 0) {
+            EMIT(j, 0x0F);
+            emit_byte(j, 0x90 | cc);
+            emit_byte(j, 0xC0);
+        } else if (ast_type(j->ast, e) == NODE_EQ) {
+            EMIT(j, 0x0F, 0x94, 0xC0, 0x0F, 0x9B, 0xC1, 0x20, 0xC8);  // sete al; setnp cl; and al, cl
+        } else {
+            EMIT(j, 0x0F, 0x95, 0xC0, 0x0F, 0x9A, 0xC1, 0x08, 0xC8);  // setne al; setp cl; or al, cl
+        }
+    }
+    EMIT(j, 0x0F, 0xB6, 0xC0);                  // movzx eax, al
+}
+
+static void gen_float(Jit* j, AstId e) {
+    if (expr_type(j->ast, e) == TYPE_INTEGER) {
+        gen_int(j, e);
+        EMIT(j, 0xF2, 0x48, 0x0F, 0x2A, 0xC0);  // cvtsi2sd xmm0, rax
+        return;
+    }
+    switch (ast_type(j->ast, e)) {
+        case NODE_FLOAT_LITERAL:
+            emit_load_float_imm(j, 0, strtod(ast_value(j->ast, e), NULL));
+            return;
+        case NODE_IDENTIFIER:
+            emit_load_xmm(j, 0, node_variable(j, e)->address);
+            return;
+        case NODE_FUNC_CALL:
+            gen_call(j, e);
+            return;
+        case NODE_NEGATE:
+            gen_float(j, ast_child(j->ast, e));
+            EMIT(j, 0x66, 0x48, 0x0F, 0x7E, 0xC0);  // movq rax, xmm0
+            EMIT(j, 0x48, 0x0F, 0xBA, 0xF8, 0x3F);  // btc rax, 63
+            EMIT(j, 0x66, 0x48, 0x0F, 0x6E, 0xC0);  // movq xmm0, rax
+            return;
+        case NODE_ADD:
+            gen_float_operands(j, ast_child(j->ast, e), ast_sibling(j->ast, ast_child(j->ast, e)));
+            EMIT(j, 0xF2, 0x0F, 0x58, 0xC1);    // addsd xmm0, xmm1
+            return;
+        case NODE_SUB:
+            gen_float_operands(j, ast_child(j->ast, e), ast_sibling(j->ast, ast_child(j->ast, e)));
+            EMIT(j, 0xF2, 0x0F, 0x5C, 0xC1);    // subsd xmm0, xmm1
+            return;
+        case NODE_MUL:
+            gen_float_operands(j, ast_child(j->ast, e), ast_sibling(j->ast, ast_child(j->ast, e)));
+            EMIT(j, 0xF2, 0x0F, 0x59, 0xC1);    // mulsd xmm0, xmm1
+            return;
+        case NODE_DIV:
+            gen_float_operands(j, ast_child(j->ast, e), ast_sibling(j->ast, ast_child(j->ast, e)));
+            EMIT(j, 0xF2, 0x0F, 0x5E, 0xC1);    // divsd xmm0, xmm1
+            return;
+        default:
+            jit_error("expressão float inválida", ast_value(j->ast, e));
+    }
+}
+
+// salta para `target` (corrigido depois) quando a condição for igual a
+// `when`. devolve as posições dos rel32 a corrigir (até duas).
+static int gen_branch(Jit* j, AstId cond, int when, size_t* patches) {
+    if (is_comparison(ast_type(j->ast, cond)) && operand_type(j->ast, cond) == TYPE_INTEGER) {
+        gen_int_operands(j, ast_child(j->ast, cond), ast_sibling(j->ast, ast_child(j->ast, cond)));
+        EMIT(j, 0x48, 0x39, 0xC8);              // cmp rax, rcx
+        int cc = int_condition(ast_type(j->ast, cond));
+        patches[0] = emit_jcc(j, when ? cc : cc ^ 1);
+        return 1;
+    }
+
+    int cc;
+    int is_equal;
+    if (is_comparison(ast_type(j->ast, cond))) {
+        cc = gen_float_compare(j, cond);
+        is_equal = ast_type(j->ast, cond) == NODE_EQ;
+    } else if (expr_type(j->ast, cond) == TYPE_FLOAT) {
+        // float como condição: verdadeiro se != 0
+        gen_float(j, cond);
+        EMIT(j, 0x66, 0x0F, 0x57, 0xC9);        // xorpd xmm1, xmm1
+        EMIT(j, 0x66, 0x0F, 0x2E, 0xC1);        // ucomisd xmm0, xmm1
+        cc = -1;
+        is_equal = 0;
+    } else {
+        gen_int(j, cond);
+        EMIT(j, 0x48, 0x85, 0xC0);              // test rax, rax
+        patches[0] = emit_jcc(j, when ? CC_NE : CC_E);
+        return 1;
+    }
+
+    if (cc >= 0) {
+        // a/ae já são falsos sem ordem (NaN); as negações são be/b
+        patches[0] = emit_jcc(j, when ? cc : (cc == CC_A ? CC_BE : CC_B));
+        return 1;
+    }
+    // igualdade é ZF=1 e PF=0
+    if (is_equal == (when != 0)) {
+        size_t skip = emit_jcc(j, CC_P);
+        patches[0] = emit_jcc(j, CC_E);
+        patch_rel32(j, skip, j->size);
+        return 1;
+    }
+    patches[0] = emit_jcc(j, CC_P);
+    patches[1] = emit_jcc(j, CC_NE);
+    return 2;
+}
+
+// ---------------------------------------------------------------------------
+// instruções
+// ---------------------------------------------------------------------------
+
+static void gen_block(Jit* j, AstId block);
+
+static void gen_return(Jit* j) {
+    EMIT(j, 0xC9, 0xC3);                        // leave; ret
+}
+
+static void gen_statement(Jit* j, AstId node) {
+    switch (ast_type(j->ast, node)) {
+        case NODE_DECLARATION: {
+            // variáveis começam valendo zero
+            SymbolNode* sym = node_variable(j, node);
+            EMIT(j, 0x48, 0xC7, 0x85);          // mov qword [rbp + disp32], 0
+            emit_u32(j, (uint32_t)slot(sym->address));
+            emit_u32(j, 0);
+            break;
+        }
+
+        case NODE_DECL_ASSIGN:
+            gen_statement(j, ast_child(j->ast, node));
+            gen_statement(j, ast_sibling(j->ast, ast_child(j->ast, node)));
+            break;
+
+        case NODE_ASSIGNMENT: {
+            SymbolNode* sym = node_variable(j, node);
+            gen_value(j, ast_child(j->ast, node), sym->type);
+            if (sym->type == TYPE_FLOAT) emit_store_xmm(j, 0, sym->address);
+            else emit_store(j, RAX, sym->address);
+            break;
+        }
+
+        case NODE_BLOCK:
+            gen_block(j, node);
+            break;
+
+        case NODE_CONDITIONAL: {
+            AstId cond = ast_child(j->ast, node);
+            AstId else_block = ast_sibling(j->ast, ast_sibling(j->ast, cond));
+            size_t to_else[2];
+            int count = gen_branch(j, cond, 0, to_else);
+            gen_block(j, ast_sibling(j->ast, cond));
+            size_t to_end = 0;
+            if (else_block) to_end = emit_jump(j);
+            for (int i = 0; i < count; i++) patch_rel32(j, to_else[i], j->size);
+            if (else_block) {
+                gen_block(j, else_block);
+                patch_rel32(j, to_end, j->size);
+            }
+            break;
+        }
+
+        case NODE_LOOP: {
+            // teste no fim: um só desvio por volta
+            size_t to_test = emit_jump(j);
+            size_t body = j->size;
+            gen_block(j, ast_sibling(j->ast, ast_child(j->ast, node)));
+            patch_rel32(j, to_test, j->size);
+            size_t back[2];
+            int count = gen_branch(j, ast_child(j->ast, node), 1, back);
+            for (int i = 0; i < count; i++) patch_rel32(j, back[i], body);
+            break;
+        }
+
+        case NODE_RETURN_STMT:
+            gen_value(j, ast_child(j->ast, node), j->return_type);
+            gen_return(j);
+            break;
+
+        case NODE_PRINT: {
+            AstId args = ast_child(j->ast, ast_child(j->ast, node));
+            if (!args) {
+                emit_call_native(j, (void*)rt_newline);
+                break;
+            }
+            for (AstId a = args; a; a = ast_sibling(j->ast, a)) {
+                uint32_t end = ast_sibling(j->ast, a) ? ' ' : '\n';
+                if (expr_type(j->ast, a) == TYPE_FLOAT) {
+                    gen_float(j, a);
+                    emit_byte(j, 0xBF);         // mov edi, imm32
+                    emit_u32(j, end);
+                    emit_call_native(j, (void*)rt_print_float);
+                } else {
+                    gen_int(j, a);
+                    EMIT(j, 0x48, 0x89, 0xC7);  // mov rdi, rax
+                    emit_byte(j, 0xBE);         // mov esi, imm32
+                    emit_u32(j, end);
+                    emit_call_native(j, (void*)rt_print_int);
+                }
+            }
+            break;
+        }
+
+        case NODE_SCAN:
+            for (AstId a = ast_child(j->ast, ast_child(j->ast, node)); a; a = ast_sibling(j->ast, a)) {
+                if (ast_type(j->ast, a) != NODE_IDENTIFIER) jit_error("scan espera variáveis como argumento", ast_value(j->ast, a));
+                SymbolNode* sym = node_variable(j, a);
+                if (sym->type == TYPE_FLOAT) {
+                    emit_call_native(j, (void*)rt_scan_float);
+                    emit_store_xmm(j, 0, sym->address);
+                } else {
+                    emit_call_native(j, (void*)rt_scan_int);
+                    emit_store(j, RAX, sym->address);
+                }
+            }
+            break;
+
+        case NODE_FUNC_CALL:
+            gen_call(j, node);
+            break;
+
+        default:
+            jit_error("instrução não suportada", ast_value(j->ast, node));
+    }
+}
+
+static void gen_block(Jit* j, AstId block) {
+    for (AstId stmt = ast_child(j->ast, block); stmt; stmt = ast_sibling(j->ast, stmt)) {
+        gen_statement(j, stmt);
+    }
+}
+
+static void gen_function(Jit* j, JitFunction* f) {
+    f->offset = j->size;
+    j->return_type = f->return_type;
+    j->depth = 0;
+
+    // um slot de 8 bytes por endereço, com a pilha alinhada em 16
+    int frame = 8 * scope_frame_size(f->scope);
+    if (frame % 16) frame += 8;
+    EMIT(j, 0x55);                              // push rbp
+    EMIT(j, 0x48, 0x89, 0xE5);                  // mov rbp, rsp
+    if (frame) {
+        EMIT(j, 0x48, 0x81, 0xEC);              // sub rsp, imm32
+        emit_u32(j, (uint32_t)frame);
+    }
+
+    // os parâmetros que não couberam nos registradores estão em [rbp + 16] em diante
+    int ints = 0, floats = 0, stacked = 0;
+    for (AstId p = f->decl ? ast_child(j->ast, ast_child(j->ast, f->decl)) : AST_NONE; p; p = ast_sibling(j->ast, p)) {
+        SymbolNode* sym = node_variable(j, p);
+        if (sym->type == TYPE_FLOAT ? floats++ >= MAX_FLOAT_ARGS : ints++ >= MAX_INT_ARGS) {
+            EMIT(j, 0x48, 0x8B, 0x85);          // mov rax, [rbp + disp32]
+            emit_u32(j, (uint32_t)(16 + 8 * stacked++));
+            emit_store(j, RAX, sym->address);
+        } else if (sym->type == TYPE_FLOAT) {
+            emit_store_xmm(j, floats - 1, sym->address);
+        } else {
+            emit_store(j, int_arg_registers[ints - 1], sym->address);
+        }
+    }
+
+    gen_block(j, f->body);
+
+    // sem return explícito a função devolve zero
+    if (f->return_type == TYPE_FLOAT) EMIT(j, 0x66, 0x0F, 0x57, 0xC0);  // xorpd xmm0, xmm0
+    else EMIT(j, 0x31, 0xC0);                                           // xor eax, eax
+    gen_return(j);
+}
+
+int jit_run(const Ast* ast, SymbolTable* global_scope) {
+    AstId root = ast->root;
+    Jit jit = { 0 };
+    Jit* j = &jit;
+    j->ast = ast;
+
+    for (AstId n = ast_child(ast, root); n; n = ast_sibling(ast, n)) j->function_count++;
+    j->functions = (JitFunction*)calloc(j->function_count ? j->function_count : 1, sizeof(JitFunction));
+    int entry = -1;
+    int i = 0;
+    for (AstId n = ast_child(ast, root); n; n = ast_sibling(ast, n), i++) {
+        JitFunction* f = &j->functions[i];
+        if (ast_type(ast, n) != NODE_FUNC_DECL) {
+            f->name = "<principal>";
+            f->scope = global_scope;
+            f->body = n;
+            f->return_type = TYPE_INTEGER;
+            entry = i;
+            continue;
+        }
+        f->name = ast_value(ast, n);
+        f->decl = n;
+        f->scope = ast_scope(ast, n);
+        f->body = ast_sibling(ast, ast_child(ast, n));
+        SymbolNode* sym = ast_symbol(ast, n);
+        f->return_type = sym ? sym->type : TYPE_INTEGER;
+        for (AstId p = ast_child(ast, ast_child(ast, n)); p; p = ast_sibling(ast, p)) f->param_count++;
+        f->param_types = (SymbolDataType*)malloc((f->param_count ? f->param_count : 1) * sizeof(SymbolDataType));
+        int k = 0;
+        for (AstId p = ast_child(ast, ast_child(ast, n)); p; p = ast_sibling(ast, p), k++) f->param_types[k] = ast_symbol(ast, p)->type;
+    }
+    if (entry < 0) {
+        entry = find_function(j, intern_cstr("main"));
+        if (j->functions[entry].param_count) jit_error("a função main não pode ter parâmetros", "main");
+    }
+
+    for (i = 0; i < j->function_count; i++) gen_function(j, &j->functions[i]);
+    for (i = 0; i < j->fixup_count; i++) {
+        patch_rel32(j, j->fixups[i].at, j->functions[j->fixups[i].function].offset);
+    }
+
+    // copia para memória executável e tira a permissão de escrita (W^X)
+    uint8_t* memory = (uint8_t*)mmap(NULL, j->size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) jit_error("falha ao reservar memória executável", NULL);
+    memcpy(memory, j->code, j->size);
+    if (mprotect(memory, j->size, PROT_READ | PROT_EXEC) != 0) jit_error("falha ao proteger a memória do código", NULL);
+
+    int result;
+    void* start = memory + j->functions[entry].offset;
+    if (j->functions[entry].return_type == TYPE_FLOAT) {
+        double (*function)(void) = (double (*)(void))start;
+        result = (int)function();
+    } else {
+        long long (*function)(void) = (long long (*)(void))start;
+        result = (int)function();
+    }
+    fflush(stdout);
+
+    munmap(memory, j->size);
+    for (i = 0; i < j->function_count; i++) free(j->functions[i].param_types);
+    free(j->functions);
+    free(j->fixups);
+    free(j->code);
+    return result;
+}
+
+#else
+
+int jit_run(const Ast* ast, SymbolTable* global_scope) {
+    (void)ast;
+    (void)global_scope;
+    fprintf(stderr, "Erro do JIT: o modo --jit só está disponível em x86-64.\n");
+    exit(EXIT_FAILURE);
+}
+
+#endif
@@ -1,174 +1,400 @@
 #include "lexer.h"
-#include <ctype.h>
+#include "lexer_scan.h"
+#include "threadpool.h"
+#include "diagnostic.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #define INITIAL_TOKEN_CAPACITY 50
 
+// a partir desse tamanho o texto é lido em paralelo, em pedaços de pelo
+// menos MIN_CHUNK_SIZE bytes
+#define PARALLEL_LEX_MIN (1 << 20)
+#define MIN_CHUNK_SIZE (256 * 1024)
+
 typedef struct {
   const char* word;
+  int length;
   TokenType type;
 } Keyword;
 
-// lista de palavras-chave
-static Keyword keywords[] = {
-    {"begin", TOKEN_BEGIN}, {"end", TOKEN_END}, {"int", TOKEN_INT},
-    {"float", TOKEN_FLOAT}, {"if", TOKEN_IF}, {"then", TOKEN_THEN},
-    {"endif", TOKEN_ENDIF}, {"else", TOKEN_ELSE}, {"endelse", TOKEN_ENDELSE},
-    {"while", TOKEN_WHILE}, {"do", TOKEN_DO}, {"endwhile", TOKEN_ENDWHILE},
-    {"print", TOKEN_PRINT}, {"scan", TOKEN_SCAN}, {"function", TOKEN_FUNCTION},
-    {"procedure", TOKEN_PROCEDURE}, {"return", TOKEN_RETURN},
-    {NULL, TOKEN_UNKNOWN}
+#define KEYWORD_MIN_LENGTH 2
+#define KEYWORD_MAX_LENGTH 9
+
+// hash perfeito das palavras-chave: cada uma cai numa posição diferente da
+// tabela, então cada identificador é comparado com no máximo uma palavra.
+// se mudar a lista, as constantes precisam ser recalculadas.
+static unsigned keyword_hash(const char* s, int length) {
+    return (unsigned)(5 * length + 8 * (unsigned char)s[0] + (unsigned char)s[length - 1]) & 31;
+}
+
+static const Keyword keywords[32] = {
+    [1] = {"else", 4, TOKEN_ELSE},
+    [2] = {"then", 4, TOKEN_THEN},
+    [6] = {"function", 8, TOKEN_FUNCTION},
+    [7] = {"endif", 5, TOKEN_ENDIF},
+    [11] = {"int", 3, TOKEN_INT},
+    [13] = {"print", 5, TOKEN_PRINT},
+    [16] = {"endelse", 7, TOKEN_ENDELSE},
+    [18] = {"procedure", 9, TOKEN_PROCEDURE},
+    [21] = {"endwhile", 8, TOKEN_ENDWHILE},
+    [22] = {"while", 5, TOKEN_WHILE},
+    [23] = {"begin", 5, TOKEN_BEGIN},
+    [24] = {"if", 2, TOKEN_IF},
+    [25] = {"do", 2, TOKEN_DO},
+    [26] = {"scan", 4, TOKEN_SCAN},
+    [27] = {"end", 3, TOKEN_END},
+    [28] = {"return", 6, TOKEN_RETURN},
+    [29] = {"float", 5, TOKEN_FLOAT},
 };
 
 // guarda o estado do analisador léxico.
-typedef struct {
+typedef struct LexerState {
+    const char* source;
     const char* start;
     const char* current;
     int line;
     Token* tokens;
     int token_count;
     int token_capacity;
+    const LexScanner* scan;
+    // leitura sob demanda (tokens == NULL): o último token lido fica aqui
+    Token pending;
+    int has_pending;
 } LexerState;
 
-// adiciona um novo token na lista
+// adiciona um novo token na lista (ou o entrega, na leitura sob demanda)
 static void add_token(LexerState* state, TokenType type, const char* lexeme, int length) {
-    // se a lista de tokens estiver cheia, dobra o tamanho dela
-    if (state->token_count >= state->token_capacity) {
-        state->token_capacity *= 2;
-        state->tokens = (Token*)realloc(state->tokens, state->token_capacity * sizeof(Token));
+    if (length > TOKEN_MAX_LENGTH) {
+        compile_error("Erro Léxico na linha %d: Lexema com mais de %d caracteres.", state->line, TOKEN_MAX_LENGTH);
+    }
+    if ((size_t)(lexeme - state->source) > UINT32_MAX) {
+        compile_error("Erro Léxico: Arquivo grande demais (limite de 4 GB).");
     }
 
-    Token* token = &state->tokens[state->token_count++];
-    token->type = type;
-    token->line = state->line;
+    Token* token = &state->pending;
+    if (state->tokens) {
+        // se a lista de tokens estiver cheia, dobra o tamanho dela
+        if (state->token_count >= state->token_capacity) {
+            state->token_capacity *= 2;
+            state->tokens = (Token*)realloc(state->tokens, state->token_capacity * sizeof(Token));
+        }
+        token = &state->tokens[state->token_count++];
+    }
+    state->has_pending = 1;
 
-    token->lexeme = (char*)malloc(length + 1);
-    strncpy(token->lexeme, lexeme, length);
-    token->lexeme[length] = '\0';
+    // só guarda a posição do lexema, sem copiar o texto
+    token->type = (uint8_t)type;
+    token->line = (uint32_t)state->line;
+    token->offset = (uint32_t)(lexeme - state->source);
+    token->length = (uint16_t)length;
+    token->name = type == TOKEN_IDENTIFIER ? intern(lexeme, length) : NAME_NONE;
 }
 
 // função para lidar com números
 static void number(LexerState* state) {
-    while (isdigit(*state->current)) state->current++;
+    state->current = state->scan->digit_end(state->current);
     TokenType type = TOKEN_INTEGER_LITERAL;
     // se encontrar um ponto, pode ser um número float
-    if (*state->current == '.' && isdigit(state->current[1])) {
+    if (*state->current == '.' && (CLASS_OF(state->current[1]) & CHAR_DIGIT)) {
         type = TOKEN_FLOAT_LITERAL;
         state->current++; // Pula o ponto.
-        while (isdigit(*state->current)) state->current++;
+        state->current = state->scan->digit_end(state->current);
     }
     add_token(state, type, state->start, state->current - state->start);
 }
 
 // lidar com identificadores e palavras-chave.
 static void identifier(LexerState* state) {
-    while (isalnum(*state->current) || *state->current == '_') state->current++;
+    state->current = state->scan->ident_end(state->current);
     int length = state->current - state->start;
     TokenType type = TOKEN_IDENTIFIER;
-    for (int i = 0; keywords[i].word != NULL; i++) {
-        if (strncmp(state->start, keywords[i].word, length) == 0 && keywords[i].word[length] == '\0') {
-            type = keywords[i].type;
-            break;
+    if (length >= KEYWORD_MIN_LENGTH && length <= KEYWORD_MAX_LENGTH) {
+        const Keyword* keyword = &keywords[keyword_hash(state->start, length)];
+        if (keyword->length == length && memcmp(keyword->word, state->start, length) == 0) {
+            type = keyword->type;
         }
     }
     add_token(state, type, state->start, length);
 }
 
-Token* tokenize(const char* source_code, int* token_count) {
+// capacity 0 prepara a leitura sob demanda, sem vetor de tokens
+static void init_state(LexerState* state, const char* source_code, const char* start, int capacity) {
+    state->source = source_code;
+    state->start = start;
+    state->current = start;
+    state->line = 1;
+    state->tokens = capacity ? (Token*)malloc(capacity * sizeof(Token)) : NULL;
+    state->token_count = 0;
+    state->token_capacity = capacity;
+    state->scan = lex_scanner();
+    state->has_pending = 0;
+}
+
+// lê um lexema, ou uma sequência de espaços ou um comentário, a partir de
+// state->current
+static void lex_step(LexerState* state) {
+    state->start = state->current;
+    char c = *state->current++;
+    switch (c) {
+        // ignora espaços em branco e conta as quebras de linha.
+        case ' ': case '\r': case '\t': case '\n':
+            state->current = state->scan->skip_blank(state->start, &state->line);
+            break;
+
+        // tokens de um caractere só.
+        case '(': add_token(state, TOKEN_LPAREN, state->start, 1); break;
+        case ')': add_token(state, TOKEN_RPAREN, state->start, 1); break;
+        case ',': add_token(state, TOKEN_COMMA, state->start, 1); break;
+        case ';': add_token(state, TOKEN_SEMICOLON, state->start, 1); break;
+        case '+': add_token(state, TOKEN_PLUS, state->start, 1); break;
+        case '-': add_token(state, TOKEN_MINUS, state->start, 1); break;
+        case '*': add_token(state, TOKEN_ASTERISK, state->start, 1); break;
+        
+        case '/':
+            if (*state->current == '/') {
+                state->current = state->scan->line_end(state->current);
+            } else {
+                add_token(state, TOKEN_SLASH, state->start, 1);
+            }
+            break;
+        
+        case '=':
+            if (*state->current == '=') {
+                state->current++;
+                add_token(state, TOKEN_EQ, state->start, 2);
+            } else {
+                add_token(state, TOKEN_ASSIGN, state->start, 1);
+            }
+            break;
+
+        case '!':
+            if (*state->current == '=') {
+                state->current++;
+                add_token(state, TOKEN_NEQ, state->start, 2);
+            } else {
+                add_token(state, TOKEN_UNKNOWN, state->start, 1);
+            }
+            break;
+
+        case '<':
+            if (*state->current == '=') {
+                state->current++;
+                add_token(state, TOKEN_LTE, state->start, 2);
+            } else {
+                add_token(state, TOKEN_LT, state->start, 1);
+            }
+            break;
+
+        case '>':
+            if (*state->current == '=') {
+                state->current++;
+                add_token(state, TOKEN_GTE, state->start, 2);
+            } else {
+                add_token(state, TOKEN_GT, state->start, 1);
+            }
+            break;
+
+        default:
+            if (CLASS_OF(c) & CHAR_IDENT_START) {
+                state->current--;
+                identifier(state);
+            } else if (CLASS_OF(c) & CHAR_DIGIT) {
+                state->current--;
+                number(state);
+            } else {
+                add_token(state, TOKEN_UNKNOWN, state->start, 1);
+            }
+            break;
+    }
+}
+
+// lê os tokens de state->current até end. as linhas contam a partir de 1
+// no começo do trecho.
+static void lex_range(LexerState* state, const char* end) {
+    while (state->current < end) lex_step(state);
+}
+
+// um pedaço do código-fonte lido por uma tarefa do pool
+typedef struct {
+    LexerState state;
+    const char* end;
+    Token* out;             // onde os tokens vão no vetor final
+    uint32_t line_base;     // linhas dos pedaços anteriores
+} LexChunk;
+
+static void lex_chunk_task(void* arg) {
+    LexChunk* chunk = (LexChunk*)arg;
+    lex_range(&chunk->state, chunk->end);
+}
+
+// copia os tokens do pedaço para o vetor final, corrigindo as linhas
+static void copy_chunk_task(void* arg) {
+    LexChunk* chunk = (LexChunk*)arg;
+    LexerState* state = &chunk->state;
+    for (int k = 0; k < state->token_count; k++) {
+        chunk->out[k] = state->tokens[k];
+        chunk->out[k].line += chunk->line_base;
+    }
+    free(state->tokens);
+}
+
+// primeira posição depois de target que começa uma linha e não é espaço.
+// como não há strings nem comentários de bloco, nenhum token atravessa uma
+// quebra de linha; e como o pedaço anterior termina nos espaços, o
+// skip_blank dele para exatamente aqui.
+static const char* split_point(const char* target, const char* end) {
+    const char* newline = (const char*)memchr(target, '\n', end - target);
+    if (!newline) return end;
+    const char* p = newline + 1;
+    while (p < end && (CLASS_OF(*p) & (CHAR_SPACE | CHAR_NEWLINE))) p++;
+    return p;
+}
+
+// divide o texto em pedaços de linhas inteiras, lê cada um numa thread e
+// junta os tokens, somando às linhas de cada pedaço as linhas dos anteriores
+static Token* tokenize_parallel(const char* source_code, size_t length, int chunk_count, int* token_count) {
+    ThreadPool* pool = thread_pool_shared();
+    const char* end = source_code + length;
+    LexChunk* chunks = (LexChunk*)malloc(chunk_count * sizeof(LexChunk));
+    TaskGroup group = TASK_GROUP_INIT;
+
+    const char* start = source_code;
+    int count = 0;
+    for (int i = 0; i < chunk_count && start < end; i++) {
+        const char* chunk_end = i == chunk_count - 1 ? end : split_point(source_code + length / chunk_count * (i + 1), end);
+        if (chunk_end <= start) continue;
+        LexChunk* chunk = &chunks[count++];
+        // estimativa de um token a cada 4 bytes, para quase não precisar de realloc
+        init_state(&chunk->state, source_code, start, (int)((chunk_end - start) / 4) + INITIAL_TOKEN_CAPACITY);
+        chunk->end = chunk_end;
+        thread_pool_submit(pool, &group, lex_chunk_task, chunk);
+        start = chunk_end;
+    }
+    thread_pool_wait(pool, &group);
+
+    size_t total = 1;
+    for (int i = 0; i < count; i++) total += chunks[i].state.token_count;
+    Token* tokens = (Token*)malloc(total * sizeof(Token));
+    if (!tokens) {
+        compile_error("Erro Léxico: Memória insuficiente para os tokens.");
+    }
+
+    // soma de prefixos das quantidades de tokens e de linhas
+    Token* out = tokens;
+    uint32_t line_base = 0;
+    for (int i = 0; i < count; i++) {
+        chunks[i].out = out;
+        chunks[i].line_base = line_base;
+        out += chunks[i].state.token_count;
+        line_base += (uint32_t)(chunks[i].state.line - 1);
+        thread_pool_submit(pool, &group, copy_chunk_task, &chunks[i]);
+    }
+    thread_pool_wait(pool, &group);
+
+    // token EOF no fim do texto
+    out->type = TOKEN_EOF;
+    out->offset = (uint32_t)length;
+    out->length = 0;
+    out->line = line_base + 1;
+    out->name = NAME_NONE;
+
+    free(chunks);
+    *token_count = (int)total;
+    return tokens;
+}
+
+// ---------------------------------------------------------------------------
+// fluxo de tokens
+// ---------------------------------------------------------------------------
+
+void token_stream_from_array(TokenStream* stream, Token* tokens, int count) {
+    memset(stream, 0, sizeof(TokenStream));
+    stream->tokens = tokens;
+    stream->count = count;
+}
+
+void token_stream_open(TokenStream* stream, const char* source_code, size_t length) {
+    memset(stream, 0, sizeof(TokenStream));
+    // com mais de um núcleo, textos grandes rendem mais lidos de uma vez em
+    // paralelo (e aí o parser também pode dividir as funções entre threads).
+    // com os erros sendo capturados, a leitura fica nesta thread.
+    if (length >= PARALLEL_LEX_MIN && !error_trap_active() && thread_pool_size(thread_pool_shared()) > 1) {
+        stream->tokens = tokenize(source_code, length, &stream->count);
+        stream->owns_tokens = 1;
+        return;
+    }
+    stream->lexer = (LexerState*)malloc(sizeof(LexerState));
+    init_state(stream->lexer, source_code, source_code, 0);
+    stream->end = source_code + length;
+    stream->count = -1;
+}
+
+// lê o próximo token para a janela
+static void pull_token(TokenStream* stream) {
+    LexerState* lexer = stream->lexer;
+    Token* slot = &stream->window[stream->lexed & (TOKEN_WINDOW - 1)];
+    lexer->has_pending = 0;
+    while (!lexer->has_pending && lexer->current < stream->end) lex_step(lexer);
+    if (lexer->has_pending) {
+        *slot = lexer->pending;
+    } else {
+        // fim do texto: o EOF fica repetido daqui em diante
+        add_token(lexer, TOKEN_EOF, stream->end, 0);
+        *slot = lexer->pending;
+        stream->count = stream->lexed + 1;
+    }
+    stream->lexed++;
+}
+
+Token token_stream_peek(TokenStream* stream, int k) {
+    int index = stream->position + k;
+    if (stream->count >= 0 && index >= stream->count) index = stream->count - 1;
+    if (!stream->lexer) return stream->tokens[index];
+    while (stream->lexed <= index && stream->count < 0) pull_token(stream);
+    if (stream->count >= 0 && index >= stream->count) index = stream->count - 1;
+    return stream->window[index & (TOKEN_WINDOW - 1)];
+}
+
+void token_stream_next(TokenStream* stream) {
+    // o EOF nunca é consumido
+    if (token_stream_peek(stream, 0).type != TOKEN_EOF) stream->position++;
+}
+
+void token_stream_close(TokenStream* stream) {
+    if (stream->owns_tokens) free_tokens(stream->tokens);
+    free(stream->lexer);
+    stream->tokens = NULL;
+    stream->lexer = NULL;
+}
+
+Token* tokenize(const char* source_code, size_t length, int* token_count) {
+    // textos grandes são divididos entre as threads do pool
+    if (length >= PARALLEL_LEX_MIN) {
+        int chunk_count = thread_pool_size(thread_pool_shared());
+        if ((size_t)chunk_count > length / MIN_CHUNK_SIZE) chunk_count = (int)(length / MIN_CHUNK_SIZE);
+        if (chunk_count > 1) return tokenize_parallel(source_code, length, chunk_count, token_count);
+    }
+
     // inicializa o estado do lexer.
-    LexerState state_obj = { source_code, source_code, 1, (Token*)malloc(INITIAL_TOKEN_CAPACITY * sizeof(Token)), 0, INITIAL_TOKEN_CAPACITY };
+    LexerState state_obj;
     LexerState* state = &state_obj;
+    init_state(state, source_code, source_code, INITIAL_TOKEN_CAPACITY);
+    lex_range(state, source_code + length);
 
-    // lê o código caractere por caractere.
-    while (*state->current != '\0') {
-        state->start = state->current;
-        char c = *state->current++;
-        switch (c) {
-            // ignora espaços em branco.
-            case ' ': case '\r': case '\t': break;
-            case '\n': state->line++; break;
-
-            // tokens de um caractere só.
-            case '(': add_token(state, TOKEN_LPAREN, state->start, 1); break;
-            case ')': add_token(state, TOKEN_RPAREN, state->start, 1); break;
-            case ',': add_token(state, TOKEN_COMMA, state->start, 1); break;
-            case ';': add_token(state, TOKEN_SEMICOLON, state->start, 1); break;
-            case '+': add_token(state, TOKEN_PLUS, state->start, 1); break;
-            case '-': add_token(state, TOKEN_MINUS, state->start, 1); break;
-            case '*': add_token(state, TOKEN_ASTERISK, state->start, 1); break;
-            
-            case '/':
-                if (*state->current == '/') {
-                    while (*state->current != '\n' && *state->current != '\0') {
-                        state->current++;
-                    }
-                } else {
-                    add_token(state, TOKEN_SLASH, state->start, 1);
-                }
-                break;
-            
-            case '=':
-                if (*state->current == '=') {
-                    state->current++;
-                    add_token(state, TOKEN_EQ, state->start, 2);
-                } else {
-                    add_token(state, TOKEN_ASSIGN, state->start, 1);
-                }
-                break;
-
-            case '!':
-                if (*state->current == '=') {
-                    state->current++;
-                    add_token(state, TOKEN_NEQ, state->start, 2);
-                } else {
-                    add_token(state, TOKEN_UNKNOWN, state->start, 1);
-                }
-                break;
-
-            case '<':
-                if (*state->current == '=') {
-                    state->current++;
-                    add_token(state, TOKEN_LTE, state->start, 2);
-                } else {
-                    add_token(state, TOKEN_LT, state->start, 1);
-                }
-                break;
-
-            case '>':
-                if (*state->current == '=') {
-                    state->current++;
-                    add_token(state, TOKEN_GTE, state->start, 2);
-                } else {
-                    add_token(state, TOKEN_GT, state->start, 1);
-                }
-                break;
-
-            default:
-                if (isalpha(c) || c == '_') {
-                    state->current--;
-                    identifier(state);
-                } else if (isdigit(c)) {
-                    state->current--;
-                    number(state);
-                } else {
-                    add_token(state, TOKEN_UNKNOWN, state->start, 1);
-                }
-                break;
-        }
-    }
     // adiciona o token EOF para sabermos que acabou
-    add_token(state, TOKEN_EOF, "EOF", 3);
+    add_token(state, TOKEN_EOF, state->current, 0);
     *token_count = state->token_count;
     return state->tokens;
 }
 
-// limpa a memória
-void free_tokens(Token* tokens, int token_count) {
-    if (!tokens) return;
-    for (int i = 0; i < token_count; i++) {
-        free(tokens[i].lexeme);
-    }
+void token_fprint(FILE* out, const char* source_code, Token t) {
+    if (t.type == TOKEN_EOF) fputs("EOF", out);
+    else fprintf(out, "%.*s", (int)t.length, token_start(source_code, t));
+}
+
+// os lexemas continuam no código-fonte, então basta liberar o vetor
+void free_tokens(Token* tokens) {
     free(tokens);
 }
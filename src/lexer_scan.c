@@ -0,0 +1,199 @@
+#include "lexer_scan.h"
+#include <stddef.h>
+
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(LEXER_NO_SIMD)
+#include <immintrin.h>
+#define LEXER_X86_SIMD
+#endif
+
+#define IS_DIGIT(c) ((c) >= '0' && (c) <= '9')
+#define IS_LETTER(c) (((c) >= 'a' && (c) <= 'z') || ((c) >= 'A' && (c) <= 'Z') || (c) == '_')
+#define CHAR_CLASS(c) \
+    ((IS_DIGIT(c) ? CHAR_DIGIT | CHAR_IDENT : 0) | \
+     (IS_LETTER(c) ? CHAR_IDENT_START | CHAR_IDENT : 0) | \
+     ((c) == ' ' || (c) == '\t' || (c) == '\r' ? CHAR_SPACE : 0) | \
+     ((c) == '\n' ? CHAR_NEWLINE : 0))
+#define CLASS_ROW(c) CHAR_CLASS(c), CHAR_CLASS(c + 1), CHAR_CLASS(c + 2), CHAR_CLASS(c + 3), \
+    CHAR_CLASS(c + 4), CHAR_CLASS(c + 5), CHAR_CLASS(c + 6), CHAR_CLASS(c + 7), \
+    CHAR_CLASS(c + 8), CHAR_CLASS(c + 9), CHAR_CLASS(c + 10), CHAR_CLASS(c + 11), \
+    CHAR_CLASS(c + 12), CHAR_CLASS(c + 13), CHAR_CLASS(c + 14), CHAR_CLASS(c + 15)
+
+const unsigned char char_class[256] = {
+    CLASS_ROW(0), CLASS_ROW(16), CLASS_ROW(32), CLASS_ROW(48),
+    CLASS_ROW(64), CLASS_ROW(80), CLASS_ROW(96), CLASS_ROW(112),
+    CLASS_ROW(128), CLASS_ROW(144), CLASS_ROW(160), CLASS_ROW(176),
+    CLASS_ROW(192), CLASS_ROW(208), CLASS_ROW(224), CLASS_ROW(240)
+};
+
+#ifndef LEXER_X86_SIMD
+
+// ---------------------------------------------------------------------------
+// versão escalar, um byte por vez (fora do x86-64 ou com LEXER_NO_SIMD)
+// ---------------------------------------------------------------------------
+
+static const char* skip_blank_scalar(const char* p, int* lines) {
+    for (;;) {
+        unsigned char c = CLASS_OF(*p);
+        if (c & CHAR_NEWLINE) (*lines)++;
+        else if (!(c & CHAR_SPACE)) return p;
+        p++;
+    }
+}
+
+static const char* line_end_scalar(const char* p) {
+    while (*p != '\n' && *p != '\0') p++;
+    return p;
+}
+
+static const char* ident_end_scalar(const char* p) {
+    while (CLASS_OF(*p) & CHAR_IDENT) p++;
+    return p;
+}
+
+static const char* digit_end_scalar(const char* p) {
+    while (CLASS_OF(*p) & CHAR_DIGIT) p++;
+    return p;
+}
+
+static const LexScanner scalar_scanner = {
+    "escalar", skip_blank_scalar, line_end_scalar, ident_end_scalar, digit_end_scalar
+};
+
+#else
+
+// ---------------------------------------------------------------------------
+// SSE2, 16 bytes por vez. as classes são montadas com comparações de bytes
+// com sinal; bytes >= 128 ficam negativos e nunca entram em nenhuma classe.
+// ---------------------------------------------------------------------------
+
+static inline __m128i in_range_sse2(__m128i v, char lo, char hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(lo - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8(hi + 1)));
+}
+
+static const char* skip_blank_sse2(const char* p, int* lines) {
+    for (;; p += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)p);
+        __m128i nl = _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'));
+        __m128i blank = _mm_or_si128(_mm_or_si128(nl, _mm_cmpeq_epi8(v, _mm_set1_epi8(' '))),
+                                     _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\t')),
+                                                  _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+        unsigned newlines = (unsigned)_mm_movemask_epi8(nl);
+        unsigned other = ~(unsigned)_mm_movemask_epi8(blank) & 0xFFFF;
+        if (other) {
+            unsigned index = (unsigned)__builtin_ctz(other);
+            *lines += __builtin_popcount(newlines & ((1u << index) - 1));
+            return p + index;
+        }
+        *lines += __builtin_popcount(newlines);
+    }
+}
+
+static const char* line_end_sse2(const char* p) {
+    for (;; p += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)p);
+        __m128i stop = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_setzero_si128()));
+        unsigned mask = (unsigned)_mm_movemask_epi8(stop);
+        if (mask) return p + __builtin_ctz(mask);
+    }
+}
+
+static const char* ident_end_sse2(const char* p) {
+    for (;; p += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)p);
+        __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+        __m128i ident = _mm_or_si128(_mm_or_si128(in_range_sse2(lower, 'a', 'z'), in_range_sse2(v, '0', '9')),
+                                     _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+        unsigned other = ~(unsigned)_mm_movemask_epi8(ident) & 0xFFFF;
+        if (other) return p + __builtin_ctz(other);
+    }
+}
+
+static const char* digit_end_sse2(const char* p) {
+    for (;; p += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)p);
+        unsigned other = ~(unsigned)_mm_movemask_epi8(in_range_sse2(v, '0', '9')) & 0xFFFF;
+        if (other) return p + __builtin_ctz(other);
+    }
+}
+
+static const LexScanner sse2_scanner = {
+    "sse2", skip_blank_sse2, line_end_sse2, ident_end_sse2, digit_end_sse2
+};
+
+// ---------------------------------------------------------------------------
+// AVX2, 32 bytes por vez, mesma lógica da SSE2
+// ---------------------------------------------------------------------------
+
+#define AVX2 __attribute__((target("avx2,popcnt,bmi")))
+
+AVX2 static inline __m256i in_range_avx2(__m256i v, char lo, char hi) {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(lo - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8(hi + 1), v));
+}
+
+AVX2 static const char* skip_blank_avx2(const char* p, int* lines) {
+    for (;; p += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)p);
+        __m256i nl = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'));
+        __m256i blank = _mm256_or_si256(_mm256_or_si256(nl, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' '))),
+                                        _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')),
+                                                        _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'))));
+        unsigned newlines = (unsigned)_mm256_movemask_epi8(nl);
+        unsigned other = ~(unsigned)_mm256_movemask_epi8(blank);
+        if (other) {
+            unsigned index = (unsigned)__builtin_ctz(other);
+            *lines += __builtin_popcount(newlines & ((1u << index) - 1));
+            return p + index;
+        }
+        *lines += __builtin_popcount(newlines);
+    }
+}
+
+AVX2 static const char* line_end_avx2(const char* p) {
+    for (;; p += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)p);
+        __m256i stop = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(v, _mm256_setzero_si256()));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(stop);
+        if (mask) return p + __builtin_ctz(mask);
+    }
+}
+
+AVX2 static const char* ident_end_avx2(const char* p) {
+    for (;; p += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)p);
+        __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+        __m256i ident = _mm256_or_si256(_mm256_or_si256(in_range_avx2(lower, 'a', 'z'), in_range_avx2(v, '0', '9')),
+                                        _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')));
+        unsigned other = ~(unsigned)_mm256_movemask_epi8(ident);
+        if (other) return p + __builtin_ctz(other);
+    }
+}
+
+AVX2 static const char* digit_end_avx2(const char* p) {
+    for (;; p += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)p);
+        unsigned other = ~(unsigned)_mm256_movemask_epi8(in_range_avx2(v, '0', '9'));
+        if (other) return p + __builtin_ctz(other);
+    }
+}
+
+static const LexScanner avx2_scanner = {
+    "avx2", skip_blank_avx2, line_end_avx2, ident_end_avx2, digit_end_avx2
+};
+
+#endif // LEXER_X86_SIMD
+
+const LexScanner* lex_scanner(void) {
+    // várias compilações podem pedir ao mesmo tempo; todas escolhem o mesmo
+    static const LexScanner* chosen = NULL;
+    const LexScanner* scanner = __atomic_load_n(&chosen, __ATOMIC_ACQUIRE);
+    if (scanner) return scanner;
+#ifdef LEXER_X86_SIMD
+    __builtin_cpu_init();
+    // SSE2 faz parte do x86-64 básico; AVX2 depende da CPU
+    scanner = __builtin_cpu_supports("avx2") ? &avx2_scanner : &sse2_scanner;
+#else
+    scanner = &scalar_scanner;
+#endif
+    __atomic_store_n(&chosen, scanner, __ATOMIC_RELEASE);
+    return scanner;
+}
@@ -0,0 +1,616 @@
+#include "loop.h"
+#include "types.h"
+#include "constant.h"
+#include "diagnostic.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// limites do desenrolamento: voltas, e nós do corpo vezes voltas
+#define UNROLL_MAX_TRIPS 16
+#define UNROLL_MAX_NODES 256
+
+// trecho de instruções que substitui uma instrução num bloco
+// (vazio quando first == AST_NONE)
+typedef struct {
+    AstId first;
+    AstId last;
+} StmtRange;
+
+// i = i + c ou i = i - c no nível de cima do corpo
+typedef struct {
+    SymbolNode* var;
+    AstId increment;    // a atribuição
+    NodeType op;        // NODE_ADD ou NODE_SUB
+    Constant step;      // c
+} Induction;
+
+// temporária que vale var * factor em todo o corpo
+typedef struct {
+    const Induction* induction;
+    AstId factor;       // literal inteiro ou variável invariante
+    SymbolNode* temp;
+} Derived;
+
+typedef struct {
+    Ast* ast;
+    SymbolTable* scope;
+
+    // por endereço: a variável local e as atribuições a ela no laço atual
+    // (só valem se stamp for o do laço)
+    SymbolNode** slot_symbol;
+    int* assigned;
+    uint32_t* stamp;
+    uint32_t epoch;
+    int slot_count;
+    int slot_capacity;
+    int temp_count;
+    int unrolled;
+
+    AstId* preheader;   // instruções a pôr antes do laço atual
+    int preheader_count;
+    int preheader_capacity;
+    Induction* inductions;
+    int induction_count;
+    int induction_capacity;
+    Derived* derived;
+    int derived_count;
+    int derived_capacity;
+} Loops;
+
+static void* grow_array(void* array, int* capacity, int needed, size_t element_size) {
+    if (needed <= *capacity) return array;
+    int bigger = *capacity ? *capacity : 16;
+    while (bigger < needed) bigger *= 2;
+    void* p = realloc(array, (size_t)bigger * element_size);
+    if (!p) compile_error("Erro: memória insuficiente para otimizar os laços.");
+    *capacity = bigger;
+    return p;
+}
+
+static void ensure_slots(Loops* l, int count) {
+    int capacity = l->slot_capacity;
+    l->slot_symbol = grow_array(l->slot_symbol, &capacity, count, sizeof(SymbolNode*));
+    capacity = l->slot_capacity;
+    l->assigned = grow_array(l->assigned, &capacity, count, sizeof(int));
+    capacity = l->slot_capacity;
+    l->stamp = grow_array(l->stamp, &capacity, count, sizeof(uint32_t));
+    for (int i = l->slot_count; i < count; i++) {
+        l->slot_symbol[i] = NULL;
+        l->assigned[i] = 0;
+        l->stamp[i] = 0;
+    }
+    l->slot_capacity = capacity;
+    l->slot_count = count;
+}
+
+// endereço da variável local, ou -1 (identificador que não é da função)
+static int slot_of(const Loops* l, const SymbolNode* sym) {
+    if (!sym || (sym->kind != KIND_VARIABLE && sym->kind != KIND_PARAMETER)) return -1;
+    if (sym->address < 0 || sym->address >= l->slot_count || l->slot_symbol[sym->address] != sym) return -1;
+    return sym->address;
+}
+
+static int assignments_in_loop(const Loops* l, const SymbolNode* sym) {
+    int slot = slot_of(l, sym);
+    if (slot < 0) return -1;
+    return l->stamp[slot] == l->epoch ? l->assigned[slot] : 0;
+}
+
+static void count_assignment(Loops* l, const SymbolNode* sym) {
+    int slot = slot_of(l, sym);
+    if (slot < 0) return;
+    if (l->stamp[slot] != l->epoch) {
+        l->stamp[slot] = l->epoch;
+        l->assigned[slot] = 0;
+    }
+    l->assigned[slot]++;
+}
+
+// conta as atribuições (e declarações e scans) da lista de nós
+static void count_assignments(Loops* l, AstId node) {
+    const Ast* ast = l->ast;
+    for (; node; node = ast_sibling(ast, node)) {
+        switch (ast_type(ast, node)) {
+            case NODE_ASSIGNMENT:
+            case NODE_DECLARATION:
+                count_assignment(l, ast_symbol(ast, node));
+                break;
+            case NODE_SCAN:
+                for (AstId a = ast_child(ast, ast_child(ast, node)); a; a = ast_sibling(ast, a)) count_assignment(l, ast_symbol(ast, a));
+                continue;
+            default:
+                break;
+        }
+        count_assignments(l, ast_child(ast, node));
+    }
+}
+
+// a subárvore muda o valor de sym
+static int assigns(const Ast* ast, AstId node, const SymbolNode* sym) {
+    switch (ast_type(ast, node)) {
+        case NODE_ASSIGNMENT:
+        case NODE_DECLARATION:
+            if (ast_symbol(ast, node) == sym) return 1;
+            break;
+        case NODE_SCAN:
+            for (AstId a = ast_child(ast, ast_child(ast, node)); a; a = ast_sibling(ast, a)) {
+                if (ast_symbol(ast, a) == sym) return 1;
+            }
+            return 0;
+        default:
+            break;
+    }
+    for (AstId c = ast_child(ast, node); c; c = ast_sibling(ast, c)) {
+        if (assigns(ast, c, sym)) return 1;
+    }
+    return 0;
+}
+
+static SymbolNode* new_temp(Loops* l, const char* prefix, SymbolDataType type) {
+    char name[32];
+    NameId id;
+    do {
+        int length = snprintf(name, sizeof(name), "%s%d", prefix, ++l->temp_count);
+        id = intern(name, length);
+    } while (scope_lookup_current(l->scope, id));
+    int address = l->slot_count;
+    SymbolNode* temp = scope_insert(l->scope, id, KIND_VARIABLE, type, 0, address);
+    ensure_slots(l, address + 1);
+    l->slot_symbol[address] = temp;
+    return temp;
+}
+
+static AstId variable_node(Ast* ast, SymbolNode* sym) {
+    AstId node = create_node(ast, NODE_IDENTIFIER, sym->id);
+    ast_set_symbol(ast, node, sym);
+    return node;
+}
+
+static AstId assignment_node(Ast* ast, SymbolNode* var, AstId value) {
+    AstId node = create_node(ast, NODE_ASSIGNMENT, var->id);
+    ast_set_symbol(ast, node, var);
+    add_child(ast, node, value);
+    return node;
+}
+
+static AstId binary_node(Ast* ast, NodeType type, AstId left, AstId right) {
+    AstId node = create_node(ast, type, NAME_NONE);
+    add_child(ast, node, left);
+    add_child(ast, node, right);
+    return node;
+}
+
+static AstId copy_tree(Ast* ast, AstId node) {
+    AstId copy = create_node(ast, ast_type(ast, node), ast_name(ast, node));
+    ast_set_symbol(ast, copy, ast_symbol(ast, node));
+    ast_set_scope(ast, copy, ast_scope(ast, node));
+    for (AstId c = ast_child(ast, node); c; c = ast_sibling(ast, c)) add_child(ast, copy, copy_tree(ast, c));
+    return copy;
+}
+
+// troca o nó, no lugar, pela leitura da variável
+static void become_variable(Ast* ast, AstId node, SymbolNode* sym) {
+    ast->type[node] = NODE_IDENTIFIER;
+    ast->value[node] = sym->id;
+    ast->child[node] = AST_NONE;
+    ast->last_child[node] = AST_NONE;
+    ast->symbol[node] = sym;
+}
+
+static void add_preheader(Loops* l, AstId stmt) {
+    l->preheader = grow_array(l->preheader, &l->preheader_capacity, l->preheader_count + 1, sizeof(AstId));
+    l->preheader[l->preheader_count++] = stmt;
+}
+
+static int is_leaf(NodeType type) {
+    return type == NODE_INT_LITERAL || type == NODE_FLOAT_LITERAL || type == NODE_IDENTIFIER;
+}
+
+// ---------------------------------------------------------------------------
+// variáveis de indução
+// ---------------------------------------------------------------------------
+
+static void find_inductions(Loops* l, AstId body) {
+    const Ast* ast = l->ast;
+    l->induction_count = 0;
+    for (AstId s = ast_child(ast, body); s; s = ast_sibling(ast, s)) {
+        if (ast_type(ast, s) != NODE_ASSIGNMENT) continue;
+        SymbolNode* var = ast_symbol(ast, s);
+        if (var->type != TYPE_INTEGER || assignments_in_loop(l, var) != 1) continue;
+        AstId rhs = ast_child(ast, s);
+        NodeType op = ast_type(ast, rhs);
+        if (op != NODE_ADD && op != NODE_SUB) continue;
+        AstId left = ast_child(ast, rhs), right = ast_sibling(ast, left);
+        // c + i também serve na soma
+        if (op == NODE_ADD && ast_type(ast, left) == NODE_INT_LITERAL) {
+            AstId t = left;
+            left = right;
+            right = t;
+        }
+        if (ast_type(ast, left) != NODE_IDENTIFIER || ast_symbol(ast, left) != var) continue;
+        if (ast_type(ast, right) != NODE_INT_LITERAL) continue;
+
+        l->inductions = grow_array(l->inductions, &l->induction_capacity, l->induction_count + 1, sizeof(Induction));
+        Induction* ind = &l->inductions[l->induction_count++];
+        ind->var = var;
+        ind->increment = s;
+        ind->op = op;
+        ind->step = constant_of_literal(ast, right);
+    }
+}
+
+static const Induction* induction_of(const Loops* l, AstId node) {
+    if (ast_type(l->ast, node) != NODE_IDENTIFIER) return NULL;
+    for (int i = 0; i < l->induction_count; i++) {
+        if (l->inductions[i].var == ast_symbol(l->ast, node)) return &l->inductions[i];
+    }
+    return NULL;
+}
+
+// ---------------------------------------------------------------------------
+// desenrolamento
+// ---------------------------------------------------------------------------
+
+// valor literal de var na entrada do laço, pelas instruções antes dele no
+// mesmo bloco
+static int initial_value(const Loops* l, AstId block, AstId loop, const SymbolNode* var, Constant* value) {
+    const Ast* ast = l->ast;
+    int known = 0;
+    AstId s;
+    for (s = ast_child(ast, block); s && s != loop; s = ast_sibling(ast, s)) {
+        NodeType type = ast_type(ast, s);
+        AstId assign = type == NODE_ASSIGNMENT ? s : type == NODE_DECL_ASSIGN ? ast_sibling(ast, ast_child(ast, s)) : AST_NONE;
+        if (assign && ast_symbol(ast, assign) == var) {
+            AstId rhs = ast_child(ast, assign);
+            known = ast_type(ast, rhs) == NODE_INT_LITERAL;
+            if (known) *value = constant_of_literal(ast, rhs);
+        } else if (type == NODE_DECLARATION && ast_symbol(ast, s) == var) {
+            // a declaração zera a variável
+            known = 1;
+            value->type = TYPE_INTEGER;
+            value->i = 0;
+        } else if (assigns(ast, s, var)) {
+            known = 0;
+        }
+    }
+    return known && s == loop;
+}
+
+// conta os nós da lista, parando depois do limite
+static int count_nodes(const Ast* ast, AstId node, int limit) {
+    int count = 0;
+    for (; node && count <= limit; node = ast_sibling(ast, node)) {
+        count += 1 + count_nodes(ast, ast_child(ast, node), limit - count);
+    }
+    return count;
+}
+
+// número de voltas de um laço i < n (ou <=, >, >=, !=, ==) com i de
+// valor inicial conhecido, ou -1
+static int trip_count(const Loops* l, AstId block, AstId loop) {
+    const Ast* ast = l->ast;
+    AstId cond = ast_child(ast, loop);
+    NodeType op = ast_type(ast, cond);
+    if (!is_comparison(op)) return -1;
+    AstId left = ast_child(ast, cond), right = ast_sibling(ast, left);
+    const Induction* ind = induction_of(l, left);
+    int var_on_left = ind != NULL;
+    if (!ind) ind = induction_of(l, right);
+    AstId limit_node = var_on_left ? right : left;
+    if (!ind || ast_type(ast, limit_node) != NODE_INT_LITERAL) return -1;
+
+    Constant value, limit = constant_of_literal(ast, limit_node);
+    if (!initial_value(l, block, loop, ind->var, &value)) return -1;
+    for (int trips = 0; trips <= UNROLL_MAX_TRIPS; trips++) {
+        Constant truth;
+        if (!constant_binary(op, var_on_left ? value : limit, var_on_left ? limit : value, &truth)) return -1;
+        if (!constant_truth(truth)) return trips;
+        if (!constant_binary(ind->op, value, ind->step, &value)) return -1;
+    }
+    return -1;
+}
+
+// o corpo repetido trips vezes (as cópias, e o original na última)
+static StmtRange unroll(Loops* l, AstId body, int trips) {
+    Ast* ast = l->ast;
+    StmtRange range = { AST_NONE, AST_NONE };
+    for (int k = 0; k < trips; k++) {
+        for (AstId s = ast_child(ast, body); s;) {
+            AstId next = ast_sibling(ast, s);
+            AstId node = k == trips - 1 ? s : copy_tree(ast, s);
+            if (range.last) ast->sibling[range.last] = node;
+            else range.first = node;
+            range.last = node;
+            s = next;
+        }
+    }
+    return range;
+}
+
+// ---------------------------------------------------------------------------
+// código invariante
+// ---------------------------------------------------------------------------
+
+static int invariant_variable(const Loops* l, const SymbolNode* sym) {
+    return assignments_in_loop(l, sym) == 0;
+}
+
+static int same_tree(const Ast* ast, AstId a, AstId b) {
+    if (ast_type(ast, a) != ast_type(ast, b) || ast_name(ast, a) != ast_name(ast, b) || ast_symbol(ast, a) != ast_symbol(ast, b)) return 0;
+    AstId x = ast_child(ast, a), y = ast_child(ast, b);
+    for (; x && y; x = ast_sibling(ast, x), y = ast_sibling(ast, y)) {
+        if (!same_tree(ast, x, y)) return 0;
+    }
+    return x == y;
+}
+
+// passa a conta para uma temporária calculada antes do laço (a mesma
+// conta já tirada do laço reaproveita a temporária)
+static void hoist(Loops* l, AstId node) {
+    Ast* ast = l->ast;
+    if (is_leaf(ast_type(ast, node))) return;
+    for (int i = 0; i < l->preheader_count; i++) {
+        AstId assign = l->preheader[i];
+        if (same_tree(ast, ast_child(ast, assign), node)) {
+            become_variable(ast, node, ast_symbol(ast, assign));
+            return;
+        }
+    }
+    SymbolNode* temp = new_temp(l, "_inv", expr_type(ast, node));
+    AstId moved = create_node(ast, ast_type(ast, node), ast_name(ast, node));
+    ast->child[moved] = ast->child[node];
+    ast->last_child[moved] = ast->last_child[node];
+    ast->symbol[moved] = ast->symbol[node];
+    become_variable(ast, node, temp);
+    add_preheader(l, assignment_node(ast, temp, moved));
+}
+
+// devolve 1 se a expressão não muda dentro do laço. das que mudam, as
+// maiores partes invariantes vão para antes do laço
+static int hoist_expr(Loops* l, AstId node) {
+    Ast* ast = l->ast;
+    NodeType type = ast_type(ast, node);
+    switch (type) {
+        case NODE_INT_LITERAL:
+        case NODE_FLOAT_LITERAL:
+            return 1;
+
+        case NODE_IDENTIFIER:
+            return invariant_variable(l, ast_symbol(ast, node));
+
+        case NODE_FUNC_CALL: {
+            AstId args = ast_child(ast, node);
+            for (AstId a = args ? ast_child(ast, args) : AST_NONE; a; a = ast_sibling(ast, a)) {
+                if (hoist_expr(l, a)) hoist(l, a);
+            }
+            return 0;
+        }
+
+        default: {
+            AstId left = ast_child(ast, node), right = ast_sibling(ast, left);
+            int a = hoist_expr(l, left), b = right ? hoist_expr(l, right) : 1;
+            // divisão inteira que pode falhar fica onde está
+            int pure = !(type == NODE_DIV && operand_type(ast, node) == TYPE_INTEGER &&
+                         (ast_type(ast, right) != NODE_INT_LITERAL || constant_of_literal(ast, right).i == 0));
+            if (a && b && pure) return 1;
+            if (a) hoist(l, left);
+            if (b && right) hoist(l, right);
+            return 0;
+        }
+    }
+}
+
+static void hoist_root(Loops* l, AstId node) {
+    if (node && hoist_expr(l, node)) hoist(l, node);
+}
+
+static void hoist_statements(Loops* l, AstId node) {
+    const Ast* ast = l->ast;
+    for (; node; node = ast_sibling(ast, node)) {
+        switch (ast_type(ast, node)) {
+            case NODE_ASSIGNMENT:
+            case NODE_RETURN_STMT:
+                hoist_root(l, ast_child(ast, node));
+                break;
+            case NODE_DECL_ASSIGN:
+            case NODE_BLOCK:
+                hoist_statements(l, ast_child(ast, node));
+                break;
+            case NODE_PRINT:
+                for (AstId a = ast_child(ast, ast_child(ast, node)); a; a = ast_sibling(ast, a)) hoist_root(l, a);
+                break;
+            case NODE_FUNC_CALL:
+                hoist_expr(l, node);
+                break;
+            case NODE_CONDITIONAL:
+            case NODE_LOOP:
+                hoist_root(l, ast_child(ast, node));
+                hoist_statements(l, ast_sibling(ast, ast_child(ast, node)));
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// redução de força
+// ---------------------------------------------------------------------------
+
+static int same_factor(const Ast* ast, AstId a, AstId b) {
+    if (ast_type(ast, a) != ast_type(ast, b)) return 0;
+    if (ast_type(ast, a) == NODE_IDENTIFIER) return ast_symbol(ast, a) == ast_symbol(ast, b);
+    return constant_of_literal(ast, a).i == constant_of_literal(ast, b).i;
+}
+
+// a temporária que vale ind * factor: começa com o produto antes do laço e
+// anda junto com o incremento
+static SymbolNode* derived_for(Loops* l, const Induction* ind, AstId factor) {
+    Ast* ast = l->ast;
+    for (int i = 0; i < l->derived_count; i++) {
+        Derived* d = &l->derived[i];
+        if (d->induction == ind && same_factor(ast, d->factor, factor)) return d->temp;
+    }
+
+    AstId step;
+    if (ast_type(ast, factor) == NODE_INT_LITERAL) {
+        Constant product;
+        constant_binary(NODE_MUL, ind->step, constant_of_literal(ast, factor), &product);
+        step = constant_node(ast, product);
+        if (!step) return NULL;
+    } else if (ind->step.i == 1) {
+        step = variable_node(ast, ast_symbol(ast, factor));
+    } else {
+        AstId c = constant_node(ast, ind->step);
+        if (!c) return NULL;
+        SymbolNode* scaled = new_temp(l, "_ind", TYPE_INTEGER);
+        add_preheader(l, assignment_node(ast, scaled, binary_node(ast, NODE_MUL, c, copy_tree(ast, factor))));
+        step = variable_node(ast, scaled);
+    }
+
+    SymbolNode* temp = new_temp(l, "_ind", TYPE_INTEGER);
+    AstId start = binary_node(ast, NODE_MUL, variable_node(ast, ind->var), copy_tree(ast, factor));
+    add_preheader(l, assignment_node(ast, temp, start));
+    AstId update = assignment_node(ast, temp, binary_node(ast, ind->op, variable_node(ast, temp), step));
+    ast->sibling[update] = ast->sibling[ind->increment];
+    ast->sibling[ind->increment] = update;
+    // a temporária muda a cada volta, então não serve de fator invariante
+    // para outro produto (3 * i * i)
+    count_assignment(l, temp);
+
+    l->derived = grow_array(l->derived, &l->derived_capacity, l->derived_count + 1, sizeof(Derived));
+    Derived* d = &l->derived[l->derived_count++];
+    d->induction = ind;
+    d->factor = factor;
+    d->temp = temp;
+    return temp;
+}
+
+// troca cada i * k (inteiro, k literal ou invariante) pela temporária
+static void reduce_strength(Loops* l, AstId node) {
+    Ast* ast = l->ast;
+    for (; node; node = ast_sibling(ast, node)) {
+        reduce_strength(l, ast_child(ast, node));
+        if (ast_type(ast, node) != NODE_MUL || expr_type(ast, node) != TYPE_INTEGER) continue;
+        AstId left = ast_child(ast, node), right = ast_sibling(ast, left);
+        const Induction* ind = induction_of(l, left);
+        AstId factor = right;
+        if (!ind) {
+            ind = induction_of(l, right);
+            factor = left;
+        }
+        if (!ind) continue;
+        NodeType type = ast_type(ast, factor);
+        if (type != NODE_INT_LITERAL &&
+            !(type == NODE_IDENTIFIER && ast_symbol(ast, factor)->type == TYPE_INTEGER && invariant_variable(l, ast_symbol(ast, factor)))) continue;
+        SymbolNode* temp = derived_for(l, ind, factor);
+        if (temp) become_variable(ast, node, temp);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// percurso
+// ---------------------------------------------------------------------------
+
+static StmtRange optimize_loop(Loops* l, AstId block, AstId loop) {
+    Ast* ast = l->ast;
+    AstId cond = ast_child(ast, loop), body = ast_sibling(ast, cond);
+    l->epoch++;
+    count_assignments(l, ast_child(ast, body));
+    find_inductions(l, body);
+
+    int trips = trip_count(l, block, loop);
+    if (trips >= 0 && trips * count_nodes(ast, ast_child(ast, body), UNROLL_MAX_NODES) <= UNROLL_MAX_NODES) {
+        l->unrolled++;
+        return unroll(l, body, trips);
+    }
+
+    l->preheader_count = 0;
+    l->derived_count = 0;
+    hoist_root(l, cond);
+    hoist_statements(l, ast_child(ast, body));
+    // o fator pode ser uma temporária que acabou de sair do laço
+    reduce_strength(l, ast_child(ast, loop));
+    for (AstId s = ast_child(ast, body); s; s = ast_sibling(ast, s)) ast->last_child[body] = s;
+
+    StmtRange range = { loop, loop };
+    for (int i = l->preheader_count - 1; i >= 0; i--) {
+        ast->sibling[l->preheader[i]] = range.first;
+        range.first = l->preheader[i];
+    }
+    return range;
+}
+
+static void optimize_block(Loops* l, AstId block);
+
+static StmtRange optimize_statement(Loops* l, AstId block, AstId node) {
+    Ast* ast = l->ast;
+    switch (ast_type(ast, node)) {
+        case NODE_BLOCK:
+            optimize_block(l, node);
+            break;
+        case NODE_CONDITIONAL:
+            for (AstId b = ast_sibling(ast, ast_child(ast, node)); b; b = ast_sibling(ast, b)) optimize_block(l, b);
+            break;
+        case NODE_LOOP:
+            // os laços de dentro primeiro
+            optimize_block(l, ast_sibling(ast, ast_child(ast, node)));
+            return optimize_loop(l, block, node);
+        default:
+            break;
+    }
+    StmtRange range = { node, node };
+    return range;
+}
+
+// troca cada instrução pelo trecho que sobrou dela. a lista fica ligada
+// até a instrução atual, porque o desenrolamento olha o que veio antes
+static void optimize_block(Loops* l, AstId block) {
+    Ast* ast = l->ast;
+    AstId last = AST_NONE;
+    for (AstId stmt = ast_child(ast, block); stmt;) {
+        AstId next = ast_sibling(ast, stmt);
+        StmtRange range = optimize_statement(l, block, stmt);
+        if (range.first) {
+            if (last) ast->sibling[last] = range.first;
+            else ast->child[block] = range.first;
+            last = range.last;
+            ast->sibling[last] = next;
+        } else if (last) {
+            ast->sibling[last] = next;
+        } else {
+            ast->child[block] = next;
+        }
+        stmt = next;
+    }
+    ast->last_child[block] = last;
+}
+
+static void optimize_function(Loops* l, AstId body, SymbolTable* scope) {
+    l->scope = scope;
+    l->temp_count = 0;
+    l->slot_count = 0;
+    ensure_slots(l, scope_frame_size(scope));
+    for (SymbolNode* sym = scope->first; sym; sym = sym->next) {
+        if (sym->kind == KIND_VARIABLE || sym->kind == KIND_PARAMETER) l->slot_symbol[sym->address] = sym;
+    }
+    optimize_block(l, body);
+}
+
+int loop_optimize_ast(Ast* ast, SymbolTable* global_scope) {
+    Loops l;
+    memset(&l, 0, sizeof(Loops));
+    l.ast = ast;
+    for (AstId n = ast_child(ast, ast->root); n; n = ast_sibling(ast, n)) {
+        if (ast_type(ast, n) == NODE_FUNC_DECL) optimize_function(&l, ast_sibling(ast, ast_child(ast, n)), ast_scope(ast, n));
+        else optimize_function(&l, n, global_scope);
+    }
+    free(l.slot_symbol);
+    free(l.assigned);
+    free(l.stamp);
+    free(l.preheader);
+    free(l.inductions);
+    free(l.derived);
+    return l.unrolled;
+}
@@ -0,0 +1,267 @@
+#include "optimize.h"
+#include "types.h"
+#include "constant.h"
+#include "ir.h"
+#include "cse.h"
+#include "loop.h"
+#include "inline.h"
+
+// trecho de instruções que substitui uma instrução num bloco
+// (vazio quando first == AST_NONE)
+typedef struct {
+    AstId first;
+    AstId last;
+} StmtRange;
+
+static int is_literal(const Ast* ast, AstId node) {
+    return ast_type(ast, node) == NODE_INT_LITERAL || ast_type(ast, node) == NODE_FLOAT_LITERAL;
+}
+
+static long long int_value(const Ast* ast, AstId node) {
+    return constant_of_literal(ast, node).i;
+}
+
+static double float_value(const Ast* ast, AstId node) {
+    Constant c = constant_of_literal(ast, node);
+    return c.type == TYPE_INTEGER ? (double)c.i : c.f;
+}
+
+static int is_pure_expression(const Ast* ast, AstId node) {
+    switch (ast_type(ast, node)) {
+        case NODE_INT_LITERAL: case NODE_FLOAT_LITERAL: case NODE_IDENTIFIER:
+            return 1;
+        case NODE_FUNC_CALL:
+            return 0;
+        case NODE_DIV: {
+            AstId divisor = ast_sibling(ast, ast_child(ast, node));
+            if (operand_type(ast, node) == TYPE_INTEGER &&
+                (ast_type(ast, divisor) != NODE_INT_LITERAL || int_value(ast, divisor) == 0)) return 0;
+            break;
+        }
+        default:
+            break;
+    }
+    for (AstId c = ast_child(ast, node); c; c = ast_sibling(ast, c)) {
+        if (!is_pure_expression(ast, c)) return 0;
+    }
+    return 1;
+}
+
+// operação entre dois literais. devolve AST_NONE se o valor só sair na
+// execução ou não tiver literal (veja constant.h)
+static AstId fold_binary(Ast* ast, AstId node, AstId left, AstId right) {
+    Constant r;
+    if (!constant_binary(ast_type(ast, node), constant_of_literal(ast, left), constant_of_literal(ast, right), &r)) return AST_NONE;
+    return constant_node(ast, r);
+}
+
+static int is_int_constant(const Ast* ast, AstId node, long long value) {
+    return ast_type(ast, node) == NODE_INT_LITERAL && int_value(ast, node) == value;
+}
+
+static int is_constant(const Ast* ast, AstId node, double value) {
+    return is_literal(ast, node) && float_value(ast, node) == value;
+}
+
+// identidades algébricas. o resultado precisa ter o tipo do nó: x * 1.0
+// com x inteiro é float e não vira x. com floats, x + 0 não vale (-0 + 0
+// é +0) e x * 0 também não (infinito, NaN e -0).
+static AstId simplify(Ast* ast, AstId node, AstId left, AstId right) {
+    NodeType type = ast_type(ast, node);
+    SymbolDataType result = expr_type(ast, node);
+    int left_same = expr_type(ast, left) == result, right_same = expr_type(ast, right) == result;
+    switch (type) {
+        case NODE_ADD:
+            if (result != TYPE_INTEGER) break;
+            if (is_int_constant(ast, right, 0)) return left;
+            if (is_int_constant(ast, left, 0)) return right;
+            break;
+        case NODE_SUB:
+            if (left_same && is_constant(ast, right, 0)) return left;
+            break;
+        case NODE_MUL:
+            if (left_same && is_constant(ast, right, 1)) return left;
+            if (right_same && is_constant(ast, left, 1)) return right;
+            if (result == TYPE_INTEGER) {
+                if (is_int_constant(ast, right, 0) && is_pure_expression(ast, left)) return right;
+                if (is_int_constant(ast, left, 0) && is_pure_expression(ast, right)) return left;
+            }
+            break;
+        case NODE_DIV:
+            if (left_same && is_constant(ast, right, 1)) return left;
+            break;
+        default:
+            break;
+    }
+    return node;
+}
+
+static void fold_list(Ast* ast, AstId parent);
+
+// dobra a expressão e devolve o nó que fica no lugar dela
+static AstId fold_expr(Ast* ast, AstId node) {
+    switch (ast_type(ast, node)) {
+        case NODE_FUNC_CALL:
+            if (ast_child(ast, node)) fold_list(ast, ast_child(ast, node));
+            return node;
+        case NODE_NEGATE: {
+            fold_list(ast, node);
+            AstId operand = ast_child(ast, node);
+            if (is_literal(ast, operand)) {
+                Constant r;
+                constant_negate(constant_of_literal(ast, operand), &r);
+                AstId folded = constant_node(ast, r);
+                if (folded) return folded;
+            }
+            // -(-x) = x
+            if (ast_type(ast, operand) == NODE_NEGATE) return ast_child(ast, operand);
+            return node;
+        }
+        case NODE_ADD: case NODE_SUB: case NODE_MUL: case NODE_DIV:
+        case NODE_EQ: case NODE_NEQ: case NODE_LT: case NODE_LTE: case NODE_GT: case NODE_GTE: {
+            fold_list(ast, node);
+            AstId left = ast_child(ast, node), right = ast_sibling(ast, left);
+            if (is_literal(ast, left) && is_literal(ast, right)) {
+                AstId folded = fold_binary(ast, node, left, right);
+                if (folded) return folded;
+            }
+            if (is_comparison(ast_type(ast, node))) return node;
+            return simplify(ast, node, left, right);
+        }
+        default:
+            return node;
+    }
+}
+
+// dobra cada filho de parent, religando a lista com os nós que sobraram
+static void fold_list(Ast* ast, AstId parent) {
+    AstId prev = AST_NONE;
+    for (AstId c = ast_child(ast, parent); c;) {
+        AstId next = ast_sibling(ast, c);
+        AstId folded = fold_expr(ast, c);
+        if (prev) ast->sibling[prev] = folded;
+        else ast->child[parent] = folded;
+        ast->sibling[folded] = next;
+        prev = folded;
+        c = next;
+    }
+    ast->last_child[parent] = prev;
+}
+
+// valor de verdade de uma condição constante (-1 se não for constante)
+static int literal_truth(const Ast* ast, AstId cond) {
+    return is_literal(ast, cond) ? constant_truth(constant_of_literal(ast, cond)) : -1;
+}
+
+static void optimize_block(Ast* ast, AstId block);
+
+static StmtRange single(AstId node) {
+    StmtRange range = { node, node };
+    return range;
+}
+
+// as instruções de dentro de um bloco, para pôr no lugar de um if
+static StmtRange block_contents(const Ast* ast, AstId block) {
+    StmtRange range = { AST_NONE, AST_NONE };
+    if (block && ast_child(ast, block)) {
+        range.first = ast_child(ast, block);
+        range.last = ast->last_child[block];
+    }
+    return range;
+}
+
+static StmtRange optimize_statement(Ast* ast, AstId node) {
+    switch (ast_type(ast, node)) {
+        case NODE_ASSIGNMENT:
+        case NODE_RETURN_STMT:
+            fold_list(ast, node);
+            break;
+
+        case NODE_DECL_ASSIGN:
+            fold_list(ast, ast_sibling(ast, ast_child(ast, node)));
+            break;
+
+        case NODE_PRINT:
+        case NODE_FUNC_CALL:
+            if (ast_child(ast, node)) fold_list(ast, ast_child(ast, node));
+            break;
+
+        case NODE_BLOCK:
+            optimize_block(ast, node);
+            break;
+
+        case NODE_CONDITIONAL: {
+            AstId cond = fold_expr(ast, ast_child(ast, node));
+            AstId then_block = ast_sibling(ast, ast_child(ast, node));
+            AstId else_block = ast_sibling(ast, then_block);
+            ast->child[node] = cond;
+            ast->sibling[cond] = then_block;
+            optimize_block(ast, then_block);
+            if (else_block) optimize_block(ast, else_block);
+            int truth = literal_truth(ast, cond);
+            if (truth == 1) return block_contents(ast, then_block);
+            if (truth == 0) return block_contents(ast, else_block);
+            break;
+        }
+
+        case NODE_LOOP: {
+            AstId cond = fold_expr(ast, ast_child(ast, node));
+            AstId body = ast_sibling(ast, ast_child(ast, node));
+            ast->child[node] = cond;
+            ast->sibling[cond] = body;
+            if (literal_truth(ast, cond) == 0) {
+                StmtRange none = { AST_NONE, AST_NONE };
+                return none;
+            }
+            optimize_block(ast, body);
+            break;
+        }
+
+        default:
+            break;
+    }
+    return single(node);
+}
+
+// otimiza as instruções do bloco, emendando no lugar de cada uma o trecho
+// que sobrou dela
+static void optimize_block(Ast* ast, AstId block) {
+    AstId last = AST_NONE;
+    for (AstId stmt = ast_child(ast, block); stmt;) {
+        AstId next = ast_sibling(ast, stmt);
+        StmtRange range = optimize_statement(ast, stmt);
+        if (range.first) {
+            if (last) ast->sibling[last] = range.first;
+            else ast->child[block] = range.first;
+            last = range.last;
+        }
+        stmt = next;
+    }
+    if (last) ast->sibling[last] = AST_NONE;
+    else ast->child[block] = AST_NONE;
+    ast->last_child[block] = last;
+}
+
+void optimize_ast(Ast* ast) {
+    for (AstId n = ast_child(ast, ast->root); n; n = ast_sibling(ast, n)) {
+        // funções: lista de parâmetros e depois o corpo
+        if (ast_type(ast, n) == NODE_FUNC_DECL) optimize_block(ast, ast_sibling(ast, ast_child(ast, n)));
+        else if (ast_type(ast, n) == NODE_BLOCK) optimize_block(ast, n);
+    }
+}
+
+void optimize_program(Ast* ast, SymbolTable* global_scope, FILE* stats) {
+    // os argumentos literais das funções expandidas também são dobrados
+    inline_optimize_ast(ast, global_scope, stats);
+    optimize_ast(ast);
+    ir_optimize_ast(ast, global_scope);
+    // as variáveis trocadas por constantes deixam contas e condições para
+    // dobrar de novo
+    optimize_ast(ast);
+    // as cópias de um laço desenrolado têm a variável de indução constante
+    if (loop_optimize_ast(ast, global_scope)) {
+        ir_optimize_ast(ast, global_scope);
+        optimize_ast(ast);
+    }
+    cse_optimize_ast(ast, global_scope);
+}
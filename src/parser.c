@@ -1,26 +1,63 @@
 #include "parser.h"
+#include "threadpool.h"
+#include "diagnostic.h"
 #include <stdio.h>
 #include <stdlib.h>
 
 // cada função cuida de uma parte da gramática
-static ASTNode* parse_Statement(ParserState* state);
-static ASTNode* parse_Expression(ParserState* state);
-static ASTNode* parse_ProgramBlock(ParserState* state);
-static ASTNode* parse_FunctionDeclaration(ParserState* state);
-static ASTNode* parse_Conditional(ParserState* state);
-static ASTNode* parse_Loop(ParserState* state);
-static ASTNode* parse_Factor(ParserState* state);
-static ASTNode* parse_Term(ParserState* state);
+static AstId parse_Statement(ParserState* state);
+static AstId parse_Expression(ParserState* state);
+static AstId parse_ProgramBlock(ParserState* state);
+static AstId parse_FunctionDeclaration(ParserState* state);
+static AstId parse_Conditional(ParserState* state);
+static AstId parse_Loop(ParserState* state);
+static AstId parse_Factor(ParserState* state);
 static SymbolDataType parse_Type(ParserState* state);
 
 // olha o token atual
 static Token peek(ParserState* state) {
-  return state->tokens[state->current];
+  return token_stream_peek(state->stream, 0);
 }
 
 // avança para o próximo token
 static void advance(ParserState* state) {
-  if (state->current < state->token_count) state->current++;
+  token_stream_next(state->stream);
+}
+
+// nome internado do token: identificadores já vêm internados do lexer,
+// literais são internados aqui
+static NameId lexeme(ParserState* state, Token t) {
+    if (t.name != NAME_NONE) return t.name;
+    return intern(token_start(state->source, t), t.length);
+}
+
+// entra em mais um nível de aninhamento, parando com erro se passar do limite
+static void enter_nesting(ParserState* state) {
+    if (++state->depth > state->max_depth) {
+        compile_error("Erro de Sintaxe na linha %d: Aninhamento passa do limite de %d níveis.", peek(state).line, state->max_depth);
+    }
+}
+
+static void leave_nesting(ParserState* state) {
+    state->depth--;
+}
+
+// cria um nó ligado ao símbolo já resolvido, para que as fases seguintes
+// cheguem à variável ou à função sem procurar o nome de novo
+static AstId bound_node(ParserState* state, NodeType type, SymbolNode* sym) {
+    AstId node = create_node(state->ast, type, sym->id);
+    ast_set_symbol(state->ast, node, sym);
+    return node;
+}
+
+// texto do token para as mensagens de erro (o EOF não tem texto no fonte)
+static int token_text(ParserState* state, Token t, const char** text) {
+    if (t.type == TOKEN_EOF) {
+        *text = "EOF";
+        return 3;
+    }
+    *text = token_start(state->source, t);
+    return (int)t.length;
 }
 
 // consome o token atual
@@ -28,8 +65,10 @@ static Token consume(ParserState* state, TokenType type, const char* message) {
     if (peek(state).type == type) {
         Token t = peek(state); advance(state); return t;
     }
-    fprintf(stderr, "Erro de Sintaxe na linha %d: %s. Encontrado '%s' (%s) ao invés.\n", peek(state).line, message, peek(state).lexeme, token_type_to_string(peek(state).type));
-    exit(EXIT_FAILURE);
+    const char* text;
+    int length = token_text(state, peek(state), &text);
+    compile_error("Erro de Sintaxe na linha %d: %s. Encontrado '%.*s' (%s) ao invés.",
+                  peek(state).line, message, length, text, token_type_to_string(peek(state).type));
 }
 
 // checa se o token atual é de um tipo específico sem consumir ele
@@ -39,16 +78,16 @@ static int check(ParserState* state, TokenType type) { return peek(state).type =
 static SymbolDataType parse_Type(ParserState* state) {
     if (check(state, TOKEN_INT)) { consume(state, TOKEN_INT, ""); return TYPE_INTEGER; }
     if (check(state, TOKEN_FLOAT)) { consume(state, TOKEN_FLOAT, ""); return TYPE_FLOAT; }
-    fprintf(stderr, "Erro de Sintaxe: Esperado um tipo (int ou float).\n"); exit(EXIT_FAILURE);
+    compile_error("Erro de Sintaxe: Esperado um tipo (int ou float).");
 }
 
 // analisa a lista de argumentos de uma chamada de função.
-static ASTNode* parse_ArgumentList(ParserState* state) {
-    ASTNode* args = create_node(NODE_ARG_LIST, NULL);
+static AstId parse_ArgumentList(ParserState* state) {
+    AstId args = create_node(state->ast, NODE_ARG_LIST, NAME_NONE);
     consume(state, TOKEN_LPAREN, "Esperado '('.");
     if (!check(state, TOKEN_RPAREN)) {
         do { 
-            add_child(args, parse_Expression(state));
+            add_child(state->ast, args, parse_Expression(state));
         } while (check(state, TOKEN_COMMA) && (consume(state, TOKEN_COMMA, ""), 1));
     }
     consume(state, TOKEN_RPAREN, "Esperado ')'.");
@@ -56,96 +95,131 @@ static ASTNode* parse_ArgumentList(ParserState* state) {
 }
 
 // analisa os fatores de uma expressão, identificadores, literais (números) ou expressões entre parênteses
-static ASTNode* parse_Factor(ParserState* state) {
-    if (check(state, TOKEN_IDENTIFIER) && state->tokens[state->current + 1].type == TOKEN_LPAREN) {
+static AstId parse_Factor(ParserState* state) {
+    if (check(state, TOKEN_IDENTIFIER) && token_stream_peek(state->stream, 1).type == TOKEN_LPAREN) {
         Token id = consume(state, TOKEN_IDENTIFIER, "");
-        SymbolNode* sym = scope_lookup(state->current_scope, id.lexeme);
-        if (!sym || (sym->kind != KIND_FUNCTION && sym->kind != KIND_PROCEDURE)) {
-            fprintf(stderr, "Erro Semântico: '%s' não é uma função ou procedimento.\n", id.lexeme); exit(EXIT_FAILURE);
+        NameId name = lexeme(state, id);
+        SymbolNode* sym = scope_lookup(state->current_scope, name);
+        // na análise paralela as funções de depois já estão na tabela, mas
+        // continuam invisíveis como na sequencial
+        if (!sym || (sym->kind != KIND_FUNCTION && sym->kind != KIND_PROCEDURE) || sym->order >= state->function_count) {
+            compile_error("Erro Semântico: '%s' não é uma função ou procedimento.", intern_name(name));
         }
-        ASTNode* call = create_node(NODE_FUNC_CALL, id.lexeme);
-        add_child(call, parse_ArgumentList(state));
+        AstId call = bound_node(state, NODE_FUNC_CALL, sym);
+        add_child(state->ast, call, parse_ArgumentList(state));
         return call;
     }
     if (check(state, TOKEN_IDENTIFIER)) {
         Token id = consume(state, TOKEN_IDENTIFIER, "");
-        if (scope_lookup(state->current_scope, id.lexeme) == NULL) {
-            fprintf(stderr, "Erro Semântico: Variável '%s' não declarada.\n", id.lexeme); exit(EXIT_FAILURE);
+        NameId name = lexeme(state, id);
+        SymbolNode* sym = scope_lookup(state->current_scope, name);
+        if (sym == NULL) {
+            compile_error("Erro Semântico: Variável '%s' não declarada.", intern_name(name));
         }
-        return create_node(NODE_IDENTIFIER, id.lexeme);
+        return bound_node(state, NODE_IDENTIFIER, sym);
     }
-    if (check(state, TOKEN_INTEGER_LITERAL)) return create_node(NODE_INT_LITERAL, consume(state, TOKEN_INTEGER_LITERAL, "").lexeme);
-    if (check(state, TOKEN_FLOAT_LITERAL)) return create_node(NODE_FLOAT_LITERAL, consume(state, TOKEN_FLOAT_LITERAL, "").lexeme);
+    if (check(state, TOKEN_INTEGER_LITERAL)) return create_node(state->ast, NODE_INT_LITERAL, lexeme(state, consume(state, TOKEN_INTEGER_LITERAL, "")));
+    if (check(state, TOKEN_FLOAT_LITERAL)) return create_node(state->ast, NODE_FLOAT_LITERAL, lexeme(state, consume(state, TOKEN_FLOAT_LITERAL, "")));
     if (check(state, TOKEN_LPAREN)) {
         consume(state, TOKEN_LPAREN, "");
-        ASTNode* expr = parse_Expression(state);
+        AstId expr = parse_Expression(state);
         consume(state, TOKEN_RPAREN, "");
         return expr;
     }
-    fprintf(stderr, "Erro de Sintaxe: Token inesperado na expressão.\n"); exit(EXIT_FAILURE);
+    compile_error("Erro de Sintaxe: Token inesperado na expressão.");
 }
 
-// analisa os termos de uma expressão
-static ASTNode* parse_Term(ParserState* state) {
+// precedência dos operadores binários, da menor para a maior. todos
+// associam à esquerda; o menos unário fica acima de todos.
+enum {
+    PREC_NONE,          // não é operador binário
+    PREC_EQUALITY,      // == !=
+    PREC_COMPARISON,    // < <= > >=
+    PREC_TERM,          // + -
+    PREC_FACTOR,        // * /
+    PREC_UNARY          // - prefixo
+};
+
+typedef struct {
+    uint8_t precedence;
+    uint8_t node;       // NodeType do nó criado
+} BinaryOperator;
+
+// uma consulta por operador; um operador novo é só mais uma linha aqui
+static const BinaryOperator binary_operators[TOKEN_UNKNOWN + 1] = {
+    [TOKEN_EQ]       = { PREC_EQUALITY,   NODE_EQ },
+    [TOKEN_NEQ]      = { PREC_EQUALITY,   NODE_NEQ },
+    [TOKEN_LT]       = { PREC_COMPARISON, NODE_LT },
+    [TOKEN_LTE]      = { PREC_COMPARISON, NODE_LTE },
+    [TOKEN_GT]       = { PREC_COMPARISON, NODE_GT },
+    [TOKEN_GTE]      = { PREC_COMPARISON, NODE_GTE },
+    [TOKEN_PLUS]     = { PREC_TERM,       NODE_ADD },
+    [TOKEN_MINUS]    = { PREC_TERM,       NODE_SUB },
+    [TOKEN_ASTERISK] = { PREC_FACTOR,     NODE_MUL },
+    [TOKEN_SLASH]    = { PREC_FACTOR,     NODE_DIV },
+};
+
+// menos unário: -x * y é (-x) * y e - - x é -(-x)
+// é a porta de entrada de todo operando (inclusive entre parênteses e nos
+// argumentos), então é aqui que o aninhamento das expressões é contado
+static AstId parse_Unary(ParserState* state) {
+    enter_nesting(state);
+    AstId node;
     if (check(state, TOKEN_MINUS)) {
-        consume(state, TOKEN_MINUS, "");
-        ASTNode* operand = parse_Factor(state);
-        ASTNode* negate_node = create_node(NODE_NEGATE, NULL);
-        add_child(negate_node, operand);
-        return negate_node;
-    }
-    ASTNode* node = parse_Factor(state);
-    while (check(state, TOKEN_ASTERISK) || check(state, TOKEN_SLASH)) {
-        Token op = consume(state, peek(state).type, "");
-        ASTNode* right = parse_Factor(state);
-        ASTNode* new_node = create_node((op.type == TOKEN_ASTERISK) ? NODE_MUL : NODE_DIV, NULL);
-        add_child(new_node, node); add_child(new_node, right);
-        node = new_node;
+        advance(state);
+        node = create_node(state->ast, NODE_NEGATE, NAME_NONE);
+        add_child(state->ast, node, parse_Unary(state));
+    } else {
+        node = parse_Factor(state);
     }
+    leave_nesting(state);
     return node;
 }
 
-// analisa uma expressão completa
-static ASTNode* parse_Expression(ParserState* state) {
-    ASTNode* node = parse_Term(state);
-    while (check(state, TOKEN_PLUS) || check(state, TOKEN_MINUS) || check(state, TOKEN_EQ) || check(state, TOKEN_NEQ) || check(state, TOKEN_LT) || check(state, TOKEN_LTE) || check(state, TOKEN_GT) || check(state, TOKEN_GTE)) {
-        Token op = consume(state, peek(state).type, "");
-        ASTNode* right = parse_Term(state);
-        NodeType type;
-        switch(op.type) {
-            case TOKEN_PLUS: type = NODE_ADD; break;
-            case TOKEN_MINUS: type = NODE_SUB; break;
-            case TOKEN_EQ: type = NODE_EQ; break;
-            case TOKEN_NEQ: type = NODE_NEQ; break;
-            case TOKEN_LT: type = NODE_LT; break;
-            case TOKEN_LTE: type = NODE_LTE; break;
-            case TOKEN_GT: type = NODE_GT; break;
-            case TOKEN_GTE: type = NODE_GTE; break;
-            default: type = -1;
-        }
-        ASTNode* new_node = create_node(type, NULL);
-        add_child(new_node, node); add_child(new_node, right);
+// precedence climbing: lê um operando e depois todos os operadores com
+// precedência de pelo menos min_precedence. o lado direito só pega
+// operadores mais fortes, o que dá a associação à esquerda.
+static AstId parse_Precedence(ParserState* state, int min_precedence) {
+    AstId node = parse_Unary(state);
+    int levels = 0;
+    for (;;) {
+        const BinaryOperator* op = &binary_operators[peek(state).type];
+        if (op->precedence < min_precedence) break;
+        advance(state);
+        // cada operador encadeado põe a árvore de antes um nível abaixo
+        enter_nesting(state);
+        levels++;
+        AstId right = parse_Precedence(state, op->precedence + 1);
+        AstId new_node = create_node(state->ast, (NodeType)op->node, NAME_NONE);
+        add_child(state->ast, new_node, node); add_child(state->ast, new_node, right);
         node = new_node;
     }
+    state->depth -= levels;
     return node;
 }
 
+// analisa uma expressão completa
+static AstId parse_Expression(ParserState* state) {
+    return parse_Precedence(state, PREC_EQUALITY);
+}
+
 // analisa a declaração de uma variável
-static ASTNode* parse_Declaration(ParserState* state) {
+static AstId parse_Declaration(ParserState* state) {
     SymbolDataType type = parse_Type(state);
     Token id = consume(state, TOKEN_IDENTIFIER, "Esperado um identificador.");
-    scope_insert(state->current_scope, id.lexeme, KIND_VARIABLE, type, id.line, state->next_address++);
-    ASTNode* decl_node = create_node(NODE_DECLARATION, id.lexeme);
+    NameId name = lexeme(state, id);
+    SymbolNode* sym = scope_insert(state->current_scope, name, KIND_VARIABLE, type, id.line, state->next_address++);
+    AstId decl_node = bound_node(state, NODE_DECLARATION, sym);
 
     if (check(state, TOKEN_ASSIGN)) {
         consume(state, TOKEN_ASSIGN, "Esperado '='.");
-        ASTNode* expr = parse_Expression(state);
-        ASTNode* assign_node = create_node(NODE_ASSIGNMENT, id.lexeme);
-        add_child(assign_node, expr);
+        AstId expr = parse_Expression(state);
+        AstId assign_node = bound_node(state, NODE_ASSIGNMENT, sym);
+        add_child(state->ast, assign_node, expr);
 
-        ASTNode* decl_assign_node = create_node(NODE_DECL_ASSIGN, NULL);
-        add_child(decl_assign_node, decl_node);
-        add_child(decl_assign_node, assign_node);
+        AstId decl_assign_node = create_node(state->ast, NODE_DECL_ASSIGN, NAME_NONE);
+        add_child(state->ast, decl_assign_node, decl_node);
+        add_child(state->ast, decl_assign_node, assign_node);
         return decl_assign_node;
     }
 
@@ -153,25 +227,25 @@ static ASTNode* parse_Declaration(ParserState* state) {
 }
 
 // analisa uma instrução de retorno
-static ASTNode* parse_ReturnStatement(ParserState* state) {
+static AstId parse_ReturnStatement(ParserState* state) {
     consume(state, TOKEN_RETURN, "Esperado 'return'.");
-    ASTNode* ret = create_node(NODE_RETURN_STMT, NULL);
-    add_child(ret, parse_Expression(state));
+    AstId ret = create_node(state->ast, NODE_RETURN_STMT, NAME_NONE);
+    add_child(state->ast, ret, parse_Expression(state));
     consume(state, TOKEN_SEMICOLON, "Esperado ';'.");
     return ret;
 }
 
 // analisa uma estrutura condicional
-static ASTNode* parse_Conditional(ParserState* state) {
+static AstId parse_Conditional(ParserState* state) {
     consume(state, TOKEN_IF, "Esperado 'if'.");
-    ASTNode* cond_node = create_node(NODE_CONDITIONAL, NULL);
-    add_child(cond_node, parse_Expression(state));
+    AstId cond_node = create_node(state->ast, NODE_CONDITIONAL, NAME_NONE);
+    add_child(state->ast, cond_node, parse_Expression(state));
     consume(state, TOKEN_THEN, "Esperado 'then'.");
-    add_child(cond_node, parse_ProgramBlock(state));
+    add_child(state->ast, cond_node, parse_ProgramBlock(state));
 
     if (check(state, TOKEN_ELSE)) {
         consume(state, TOKEN_ELSE, "");
-        add_child(cond_node, parse_ProgramBlock(state));
+        add_child(state->ast, cond_node, parse_ProgramBlock(state));
         consume(state, TOKEN_ENDELSE, "Esperado 'endelse'.");
     }
     consume(state, TOKEN_ENDIF, "Esperado 'endif'.");
@@ -179,77 +253,79 @@ static ASTNode* parse_Conditional(ParserState* state) {
 }
 
 // analisa um laço de repetição
-static ASTNode* parse_Loop(ParserState* state) {
+static AstId parse_Loop(ParserState* state) {
     consume(state, TOKEN_WHILE, "Esperado 'while'.");
-    ASTNode* loop_node = create_node(NODE_LOOP, NULL);
-    add_child(loop_node, parse_Expression(state));
+    AstId loop_node = create_node(state->ast, NODE_LOOP, NAME_NONE);
+    add_child(state->ast, loop_node, parse_Expression(state));
     consume(state, TOKEN_DO, "Esperado 'do'.");
-    add_child(loop_node, parse_ProgramBlock(state));
+    add_child(state->ast, loop_node, parse_ProgramBlock(state));
     consume(state, TOKEN_ENDWHILE, "Esperado 'endwhile'.");
     return loop_node;
 }
 
 // olha o token atual e decide qual tipo de instrução está vindo
-static ASTNode* parse_Statement(ParserState* state) {
+static AstId parse_Statement(ParserState* state) {
     if (check(state, TOKEN_IF)) return parse_Conditional(state);
     if (check(state, TOKEN_WHILE)) return parse_Loop(state);
     if (check(state, TOKEN_RETURN)) return parse_ReturnStatement(state);
     if (check(state, TOKEN_PRINT)) {
         consume(state, TOKEN_PRINT, "");
-        ASTNode* print_node = create_node(NODE_PRINT, NULL);
-        add_child(print_node, parse_ArgumentList(state)); // o que vai ser impresso.
+        AstId print_node = create_node(state->ast, NODE_PRINT, NAME_NONE);
+        add_child(state->ast, print_node, parse_ArgumentList(state)); // o que vai ser impresso.
         consume(state, TOKEN_SEMICOLON, "Esperado ';' após a instrução print.");
         return print_node;
     }
     if (check(state, TOKEN_SCAN)) {
         consume(state, TOKEN_SCAN, "");
-        ASTNode* scan_node = create_node(NODE_SCAN, NULL);
-        add_child(scan_node, parse_ArgumentList(state)); // onde vai ser lido.
+        AstId scan_node = create_node(state->ast, NODE_SCAN, NAME_NONE);
+        add_child(state->ast, scan_node, parse_ArgumentList(state)); // onde vai ser lido.
         consume(state, TOKEN_SEMICOLON, "Esperado ';' após a instrução scan.");
         return scan_node;
     }
 
     // se for int ou float, é uma declaração de variável
     if (check(state, TOKEN_INT) || check(state, TOKEN_FLOAT)) {
-        ASTNode* decl = parse_Declaration(state);
+        AstId decl = parse_Declaration(state);
         consume(state, TOKEN_SEMICOLON, "Esperado ';' após a declaração.");
         return decl;
     }
     // se for um identificador seguido de '(' é uma chamada de procedimento
-    if (check(state, TOKEN_IDENTIFIER) && state->tokens[state->current + 1].type == TOKEN_LPAREN) {
-        ASTNode* call = parse_Factor(state);
+    if (check(state, TOKEN_IDENTIFIER) && token_stream_peek(state->stream, 1).type == TOKEN_LPAREN) {
+        AstId call = parse_Factor(state);
         consume(state, TOKEN_SEMICOLON, "Esperado ';' após a chamada de procedimento.");
         return call;
     }
     // se for um identificador sozinho é uma atribuição
     if (check(state, TOKEN_IDENTIFIER)) {
         Token id = consume(state, TOKEN_IDENTIFIER, "");
+        NameId name = lexeme(state, id);
         // checa se a variável já foi declarada
-        if (scope_lookup(state->current_scope, id.lexeme) == NULL) {
-            fprintf(stderr, "Erro Semântico: Atribuição a variável não declarada '%s'.\n", id.lexeme); exit(EXIT_FAILURE);
+        SymbolNode* sym = scope_lookup(state->current_scope, name);
+        if (sym == NULL) {
+            compile_error("Erro Semântico: Atribuição a variável não declarada '%s'.", intern_name(name));
         }
         consume(state, TOKEN_ASSIGN, "Esperado '='.");
-        ASTNode* expr = parse_Expression(state);
+        AstId expr = parse_Expression(state);
         consume(state, TOKEN_SEMICOLON, "Esperado ';'.");
-        ASTNode* assign = create_node(NODE_ASSIGNMENT, id.lexeme);
-        add_child(assign, expr);
+        AstId assign = bound_node(state, NODE_ASSIGNMENT, sym);
+        add_child(state->ast, assign, expr);
         return assign;
     }
-    fprintf(stderr, "Erro de Sintaxe na linha %d: Instrução inválida.\n", peek(state).line);
-    exit(EXIT_FAILURE);
+    compile_error("Erro de Sintaxe na linha %d: Instrução inválida.", peek(state).line);
 }
 
 // analisa a lista de parâmetros de uma função ou procedimento
-static ASTNode* parse_ParameterList(ParserState* state) {
-    ASTNode* params = create_node(NODE_PARAM_LIST, NULL);
+static AstId parse_ParameterList(ParserState* state) {
+    AstId params = create_node(state->ast, NODE_PARAM_LIST, NAME_NONE);
     consume(state, TOKEN_LPAREN, "Esperado '('.");
     if (!check(state, TOKEN_RPAREN)) {
         do {
             SymbolDataType type = parse_Type(state);
             Token id = consume(state, TOKEN_IDENTIFIER, "Esperado o nome do parâmetro.");
+            NameId name = lexeme(state, id);
             // insere o parâmetro na tabela de símbolos do escopo da função
-            scope_insert(state->current_scope, id.lexeme, KIND_PARAMETER, type, id.line, state->next_address++);
-            add_child(params, create_node(NODE_PARAM, id.lexeme));
+            SymbolNode* sym = scope_insert(state->current_scope, name, KIND_PARAMETER, type, id.line, state->next_address++);
+            add_child(state->ast, params, bound_node(state, NODE_PARAM, sym));
         } while (check(state, TOKEN_COMMA) && (consume(state, TOKEN_COMMA, ""), 1));
     }
     consume(state, TOKEN_RPAREN, "Esperado ')'.");
@@ -257,22 +333,29 @@ static ASTNode* parse_ParameterList(ParserState* state) {
 }
 
 // analisa a declaração de uma função
-static ASTNode* parse_FunctionDeclaration(ParserState* state) {
+static AstId parse_FunctionDeclaration(ParserState* state) {
     consume(state, TOKEN_FUNCTION, "Esperado 'function'.");
     SymbolDataType return_type = parse_Type(state);
     Token id = consume(state, TOKEN_IDENTIFIER, "Esperado o nome da função.");
+    NameId name = lexeme(state, id);
     // insere a função na tabela de símbolos do escopo global
-    scope_insert(state->current_scope, id.lexeme, KIND_FUNCTION, return_type, id.line, 0); 
-    ASTNode* func = create_node(NODE_FUNC_DECL, id.lexeme);
+    SymbolNode* sym;
+    if (!state->predeclared) {
+        sym = scope_insert(state->current_scope, name, KIND_FUNCTION, return_type, id.line, 0);
+        sym->order = state->function_count++;
+    } else {
+        sym = scope_lookup_current(state->current_scope, name);
+    }
+    AstId func = bound_node(state, NODE_FUNC_DECL, sym);
     
     // entra em um novo escopo para a função
-    state->current_scope = scope_enter(state->current_scope);
+    state->current_scope = scope_enter(state->arena, state->current_scope);
     state->next_address = 1;
     
-    add_child(func, parse_ParameterList(state));
-    add_child(func, parse_ProgramBlock(state));
+    add_child(state->ast, func, parse_ParameterList(state));
+    add_child(state->ast, func, parse_ProgramBlock(state));
     
-    func->scope = state->current_scope;
+    ast_set_scope(state->ast, func, state->current_scope);
     
     // sai do escopo da função, voltando para o pai
     state->current_scope = state->current_scope->parent;
@@ -281,40 +364,146 @@ static ASTNode* parse_FunctionDeclaration(ParserState* state) {
 }
 
 // Analisa um bloco de código
-static ASTNode* parse_ProgramBlock(ParserState* state) {
-    ASTNode* block = create_node(NODE_BLOCK, NULL);
+static AstId parse_ProgramBlock(ParserState* state) {
+    enter_nesting(state);
+    AstId block = create_node(state->ast, NODE_BLOCK, NAME_NONE);
     consume(state, TOKEN_BEGIN, "Esperado 'begin'.");
     // continua analisando instruções até encontrar um 'end'.
     while (!check(state, TOKEN_END)) {
-        add_child(block, parse_Statement(state));
+        add_child(state->ast, block, parse_Statement(state));
     }
     consume(state, TOKEN_END, "Esperado 'end'.");
+    leave_nesting(state);
     return block;
 }
 
+// análise paralela: programas com menos tokens que isso não compensam
+#define PARALLEL_PARSE_MIN_TOKENS 50000
+
+// uma função do nível mais alto, analisada por uma tarefa do pool
+typedef struct {
+    ParserState state;
+    TokenStream stream;     // percorre o mesmo vetor a partir da função
+    int end;                // token logo depois do 'end' do corpo
+    AstId node;
+} FunctionJob;
+
+static void parse_function_task(void* arg) {
+    FunctionJob* job = (FunctionJob*)arg;
+    job->node = parse_FunctionDeclaration(&job->state);
+}
+
+// acha o fim de uma declaração "function tipo nome (...) begin ... end"
+// começando em start, casando begin/end. devolve -1 se a forma não for a
+// esperada; aí a análise sequencial encontra e reporta o erro.
+static int function_end(ParserState* state, int start) {
+    Token* t = state->stream->tokens;
+    int token_count = state->stream->count;
+    if (t[start + 1].type != TOKEN_INT && t[start + 1].type != TOKEN_FLOAT) return -1;
+    if (t[start + 2].type != TOKEN_IDENTIFIER || t[start + 3].type != TOKEN_LPAREN) return -1;
+    int i = start + 4;
+    while (i < token_count && t[i].type != TOKEN_BEGIN) {
+        if (t[i].type != TOKEN_INT && t[i].type != TOKEN_FLOAT && t[i].type != TOKEN_IDENTIFIER &&
+            t[i].type != TOKEN_COMMA && t[i].type != TOKEN_RPAREN) return -1;
+        i++;
+    }
+    int depth = 0;
+    for (; i < token_count; i++) {
+        if (t[i].type == TOKEN_BEGIN) depth++;
+        else if (t[i].type == TOKEN_END && --depth == 0) return i + 1;
+        else if (t[i].type == TOKEN_FUNCTION || t[i].type == TOKEN_EOF) return -1;
+    }
+    return -1;
+}
+
+// analisa em paralelo a sequência de funções que começa no token atual
+// e as liga como filhas de program, na ordem do código. se a sequência não
+// tiver a forma esperada, não faz nada e a análise continua sequencial.
+static void parse_functions_parallel(ParserState* state, AstId program) {
+    // encontra os limites das funções
+    Token* tokens = state->stream->tokens;
+    int count = 0;
+    for (int i = state->stream->position; tokens[i].type == TOKEN_FUNCTION; count++) {
+        i = function_end(state, i);
+        if (i < 0) return;
+    }
+    if (count < 2) return;
+
+    FunctionJob* jobs = (FunctionJob*)malloc(count * sizeof(FunctionJob));
+    int start = state->stream->position;
+    for (int k = 0; k < count; k++) {
+        FunctionJob* job = &jobs[k];
+        job->end = function_end(state, start);
+
+        // registra a assinatura no escopo global, em ordem, antes dos corpos
+        Token type = tokens[start + 1];
+        Token id = tokens[start + 2];
+        NameId name = lexeme(state, id);
+        scope_insert(state->current_scope, name, KIND_FUNCTION, type.type == TOKEN_INT ? TYPE_INTEGER : TYPE_FLOAT, id.line, 0)->order = state->function_count;
+
+        // cada corpo tem seu estado, sua arena e sua AST; o escopo global só
+        // é lido
+        job->state = *state;
+        token_stream_from_array(&job->stream, tokens, state->stream->count);
+        job->stream.position = start;
+        job->state.stream = &job->stream;
+        job->state.arena = arena_create();
+        job->state.ast = ast_create();
+        job->state.function_count = state->function_count + 1;
+        job->state.predeclared = 1;
+        job->state.parallel = 0;
+        state->function_count++;
+        start = job->end;
+    }
+
+    ThreadPool* pool = thread_pool_shared();
+    TaskGroup group = TASK_GROUP_INIT;
+    for (int k = 0; k < count; k++) thread_pool_submit(pool, &group, parse_function_task, &jobs[k]);
+    thread_pool_wait(pool, &group);
+
+    // copia as funções para a AST principal, na ordem do código, e junta as
+    // arenas (onde estão os escopos) na principal
+    for (int k = 0; k < count; k++) {
+        add_child(state->ast, program, ast_merge(state->ast, jobs[k].state.ast, jobs[k].node));
+        ast_free(jobs[k].state.ast);
+        arena_merge(state->arena, jobs[k].state.arena);
+    }
+    // o bloco principal continua a numeração de endereços da última função
+    state->next_address = jobs[count - 1].state.next_address;
+    state->stream->position = jobs[count - 1].end;
+    free(jobs);
+}
+
 // analisa o nível mais alto do programa
-static ASTNode* parse_TopLevel(ParserState* state) {
-    ASTNode* program = create_node(NODE_PROGRAM, NULL);
+static AstId parse_TopLevel(ParserState* state) {
+    AstId program = create_node(state->ast, NODE_PROGRAM, NAME_NONE);
+    // só dá para dividir quando os tokens já estão todos num vetor
+    if (state->parallel && state->stream->tokens && state->stream->count >= PARALLEL_PARSE_MIN_TOKENS &&
+        thread_pool_size(thread_pool_shared()) > 1) {
+        parse_functions_parallel(state, program);
+    }
     while (!check(state, TOKEN_EOF)) {
         if (check(state, TOKEN_FUNCTION)) {
-            add_child(program, parse_FunctionDeclaration(state)); // se for função, analisa a função
+            add_child(state->ast, program, parse_FunctionDeclaration(state)); // se for função, analisa a função
         } else if (check(state, TOKEN_BEGIN)) {
-            add_child(program, parse_ProgramBlock(state)); // se for 'begin', eh o bloco principal
+            add_child(state->ast, program, parse_ProgramBlock(state)); // se for 'begin', eh o bloco principal
             break;
         } else {
-            fprintf(stderr, "Erro de Sintaxe: Esperado declaração de função ou bloco principal do programa.\n");
-            exit(EXIT_FAILURE);
+            compile_error("Erro de Sintaxe: Esperado declaração de função ou bloco principal do programa.");
         }
     }
     return program;
 }
 
 // função principal do parser
-ASTNode* parse(ParserState* state) {
-    ASTNode* root = parse_TopLevel(state);
+AstId parse(ParserState* state) {
+    if (state->max_depth <= 0) state->max_depth = PARSER_DEFAULT_MAX_DEPTH;
+    AstId root = parse_TopLevel(state);
+    state->ast->root = root;
     if (!check(state, TOKEN_EOF)) {
-        fprintf(stderr, "Erro: Tokens extras no final do arquivo, começando com '%s'.\n", peek(state).lexeme);
-        exit(EXIT_FAILURE);
+        const char* text;
+        int length = token_text(state, peek(state), &text);
+        compile_error("Erro: Tokens extras no final do arquivo, começando com '%.*s'.", length, text);
     }
     return root;
 }
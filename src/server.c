@@ -0,0 +1,155 @@
+#include "server.h"
+#include "compiler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define SERVER_BACKLOG 64
+#define READ_CHUNK (64 * 1024)
+
+// lê a conexão inteira (até o cliente fechar a escrita)
+static char* read_request(int fd, size_t* length) {
+    size_t capacity = READ_CHUNK, used = 0;
+    char* data = (char*)malloc(capacity + 1);
+    if (!data) return NULL;
+    for (;;) {
+        if (capacity - used < READ_CHUNK) {
+            capacity *= 2;
+            char* bigger = (char*)realloc(data, capacity + 1);
+            if (!bigger) {
+                free(data);
+                return NULL;
+            }
+            data = bigger;
+        }
+        ssize_t n = read(fd, data + used, capacity - used);
+        if (n < 0) {
+            free(data);
+            return NULL;
+        }
+        if (n == 0) break;
+        used += (size_t)n;
+    }
+    data[used] = '\0';
+    *length = used;
+    return data;
+}
+
+static int write_all(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        // MSG_NOSIGNAL: um cliente que foi embora não derruba o servidor
+        ssize_t n = send(fd, data, length, MSG_NOSIGNAL);
+        if (n <= 0) return 0;
+        data += n;
+        length -= (size_t)n;
+    }
+    return 1;
+}
+
+static void reply(int fd, const char* status, const char* body, size_t length) {
+    char header[64];
+    int header_length = snprintf(header, sizeof(header), "%s %zu\n", status, length);
+    if (write_all(fd, header, (size_t)header_length)) write_all(fd, body, length);
+}
+
+// lê a linha de cabeçalho do pedido. devolve 0 se ela for inválida.
+static int parse_header(const char* line, size_t length, CompileOptions* options) {
+    char word[32];
+    size_t i = 0;
+    options->target = COMPILE_CHECK;
+    options->max_depth = 0;
+    options->no_optimize = 0;
+    while (i < length && line[i] != ' ') i++;
+    if (i >= sizeof(word)) return 0;
+    memcpy(word, line, i);
+    word[i] = '\0';
+    if (strcmp(word, "check") == 0) options->target = COMPILE_CHECK;
+    else if (strcmp(word, "asm") == 0) options->target = COMPILE_EMIT_ASM;
+    else if (strcmp(word, "c") == 0) options->target = COMPILE_EMIT_C;
+    else return 0;
+
+    while (i < length && line[i] == ' ') i++;
+    if (i == length) return 1;
+    if (length - i > 10 && strncmp(line + i, "max-depth=", 10) == 0) {
+        options->max_depth = atoi(line + i + 10);
+        return options->max_depth > 0;
+    }
+    return 0;
+}
+
+// atende uma conexão. devolve 0 quando o pedido foi para encerrar.
+static int serve(int fd) {
+    size_t length = 0;
+    char* request = read_request(fd, &length);
+    if (!request) {
+        static const char message[] = "Erro: falha ao ler o pedido.";
+        reply(fd, "erro", message, sizeof(message) - 1);
+        return 1;
+    }
+
+    char* newline = memchr(request, '\n', length);
+    size_t header_length = newline ? (size_t)(newline - request) : length;
+    if (header_length == 8 && strncmp(request, "shutdown", 8) == 0) {
+        reply(fd, "ok", "", 0);
+        free(request);
+        return 0;
+    }
+
+    CompileOptions options;
+    if (!parse_header(request, header_length, &options)) {
+        static const char message[] = "Erro: pedido inválido (esperado 'check', 'asm' ou 'c').";
+        reply(fd, "erro", message, sizeof(message) - 1);
+        free(request);
+        return 1;
+    }
+
+    const char* source = newline ? newline + 1 : request + length;
+    CompileResult result;
+    if (compile_source(source, length - (size_t)(source - request), &options, &result)) {
+        reply(fd, "ok", result.output ? result.output : "", result.output_length);
+        compile_result_free(&result);
+    } else {
+        reply(fd, "erro", result.error, strlen(result.error));
+    }
+    free(request);
+    return 1;
+}
+
+int server_run(const char* socket_path) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "Erro: caminho do socket longo demais \"%s\".\n", socket_path);
+        return 74;
+    }
+    strcpy(address.sun_path, socket_path);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        perror("Falha ao criar o socket");
+        return 74;
+    }
+    // um socket que sobrou de uma execução anterior é trocado pelo novo
+    unlink(socket_path);
+    if (bind(listener, (struct sockaddr*)&address, sizeof(address)) < 0 || listen(listener, SERVER_BACKLOG) < 0) {
+        perror("Falha ao abrir o socket");
+        close(listener);
+        return 74;
+    }
+
+    int running = 1;
+    while (running) {
+        int fd = accept(listener, NULL, NULL);
+        if (fd < 0) continue;
+        running = serve(fd);
+        close(fd);
+    }
+
+    close(listener);
+    unlink(socket_path);
+    return 0;
+}
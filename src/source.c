@@ -0,0 +1,122 @@
+#include "source.h"
+#include "diagnostic.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SOURCE_USE_MMAP
+#endif
+
+#define READ_CHUNK_SIZE (64 * 1024)
+
+static void source_error(const char* message, const char* path) {
+    // com os erros sendo capturados (vários arquivos por vez), o erro volta
+    // para quem chamou em vez de terminar o processo
+    if (error_trap_active()) compile_error("%s \"%s\".", message, path);
+    fprintf(stderr, "%s \"%s\".\n", message, path);
+    exit(74);
+}
+
+// lê a entrada em blocos até o fim, para pipes e stdin, que não têm tamanho
+// conhecido de antemão
+static void read_stream(Source* source, FILE* file, const char* path) {
+    size_t capacity = READ_CHUNK_SIZE;
+    size_t length = 0;
+    char* buffer = (char*)malloc(capacity + SOURCE_PADDING);
+    if (!buffer) source_error("Memória insuficiente para ler", path);
+
+    for (;;) {
+        // sempre sobra espaço para um bloco inteiro
+        if (capacity - length < READ_CHUNK_SIZE) {
+            capacity *= 2;
+            buffer = (char*)realloc(buffer, capacity + SOURCE_PADDING);
+            if (!buffer) source_error("Memória insuficiente para ler", path);
+        }
+        size_t bytes_read = fread(buffer + length, 1, capacity - length, file);
+        length += bytes_read;
+        if (bytes_read == 0) {
+            if (ferror(file)) source_error("Não foi possível ler o arquivo", path);
+            break;
+        }
+    }
+    memset(buffer + length, 0, SOURCE_PADDING);
+    source->text = buffer;
+    source->length = length;
+}
+
+#ifdef SOURCE_USE_MMAP
+// mapeia o arquivo e, logo depois dele, uma página anônima de zeros. o resto
+// da última página do arquivo já vem zerado, então o texto sempre termina
+// em '\0' seguido de pelo menos uma página de zeros, sem copiar nada.
+static int map_file(Source* source, int fd, size_t size) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t total = (size + page - 1) / page * page + page;
+    if (page < SOURCE_PADDING) return 0;
+
+    char* region = (char*)mmap(NULL, total, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED) return 0;
+    if (mmap(region, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(region, total);
+        return 0;
+    }
+    // o lexer lê do começo ao fim uma única vez
+    madvise(region, size, MADV_SEQUENTIAL);
+
+    source->text = region;
+    source->length = size;
+    source->mapping = region;
+    source->mapping_size = total;
+    return 1;
+}
+#endif
+
+Source* source_open(const char* path) {
+    Source* source = (Source*)calloc(1, sizeof(Source));
+    if (!source) source_error("Memória insuficiente para ler", path);
+
+    if (strcmp(path, "-") == 0) {
+        read_stream(source, stdin, "<stdin>");
+        return source;
+    }
+
+#ifdef SOURCE_USE_MMAP
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        free(source);
+        source_error("Não foi possível abrir o arquivo", path);
+    }
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0 &&
+        map_file(source, fd, (size_t)info.st_size)) {
+        close(fd);
+        return source;
+    }
+    // FIFOs, arquivos vazios ou mmap indisponível: lê em blocos
+    FILE* file = fdopen(fd, "rb");
+#else
+    FILE* file = fopen(path, "rb");
+#endif
+    if (!file) {
+        free(source);
+        source_error("Não foi possível abrir o arquivo", path);
+    }
+    read_stream(source, file, path);
+    fclose(file);
+    return source;
+}
+
+void source_close(Source* source) {
+    if (!source) return;
+#ifdef SOURCE_USE_MMAP
+    if (source->mapping) munmap(source->mapping, source->mapping_size);
+    else free((char*)source->text);
+#else
+    free((char*)source->text);
+#endif
+    free(source);
+}
@@ -1,98 +1,97 @@
 #include "symtab.h"
+#include "diagnostic.h"
 #include <stdio.h>
 #include <stdlib.h>
-#include <string.h>
 
-// função de "hash"zer a busca por variáveis ser bem rápida.
-static unsigned int hash(const char *key) {
-    unsigned long int hash_value = 5381;
-    int c;
-    while ((c = *key++)) {
-        hash_value = ((hash_value << 5) + hash_value) + c; // djb2 hash
-    }
-    return hash_value % SYMBOL_TABLE_SIZE;
+#define INITIAL_CAPACITY 8
+#define INITIAL_SHIFT (32 - 3)
+
+// hash multiplicativo (Fibonacci) do número do nome: os bits altos do
+// produto decidem a posição
+static inline unsigned int slot_of(const SymbolTable* st, NameId name) {
+    return (uint32_t)(name * 2654435769u) >> st->shift;
 }
 
 // cria uma nova tabela de símbolos
-SymbolTable* scope_create() {
-    SymbolTable* st = (SymbolTable*)malloc(sizeof(SymbolTable));
-    if (!st) {
-        perror("Falha ao alocar memória para a tabela de símbolos");
-        exit(EXIT_FAILURE);
-    }
+SymbolTable* scope_create(Arena* arena) {
+    SymbolTable* st = (SymbolTable*)arena_alloc(arena, sizeof(SymbolTable));
     st->parent = NULL;
+    st->arena = arena;
 
-    // inicializa todas as posições da tabela como vazias
-    for (int i = 0; i < SYMBOL_TABLE_SIZE; i++) {
-        st->table[i] = NULL;
-    }
+    // começa com todas as posições vazias
+    st->capacity = INITIAL_CAPACITY;
+    st->shift = INITIAL_SHIFT;
+    st->slots = (SymbolNode**)arena_calloc(arena, INITIAL_CAPACITY * sizeof(SymbolNode*));
+    st->count = 0;
+    st->first = NULL;
+    st->last = NULL;
     return st;
 }
 
-// libera a memória que a gente usou para a tabela de símbolos
-void scope_destroy(SymbolTable* st) {
-    if (!st) return;
-
-    for (int i = 0; i < SYMBOL_TABLE_SIZE; i++) {
-        SymbolNode* current = st->table[i];
-        while (current != NULL) {
-            SymbolNode* temp = current;
-            current = current->next;
-            free(temp->name);
-            free(temp);
-        }
-    }
-    free(st);
-}
-
 // cria um novo escopo dentro de outro
-SymbolTable* scope_enter(SymbolTable* parent) {
-    SymbolTable* new_scope = scope_create();
+SymbolTable* scope_enter(Arena* arena, SymbolTable* parent) {
+    SymbolTable* new_scope = scope_create(arena);
     new_scope->parent = parent; // o escopo atual se torna o pai do novo
     return new_scope;
 }
 
 // procura por um símbolo (variável ou função) no escopo atual.
-SymbolNode* scope_lookup_current(SymbolTable* st, const char* name) {
+SymbolNode* scope_lookup_current(SymbolTable* st, NameId name) {
     if (!st) return NULL;
-    unsigned int index = hash(name);
-    SymbolNode* current = st->table[index];
-    while (current != NULL) {
-        if (strcmp(current->name, name) == 0) {
-            return current;
-        }
-        current = current->next;
+    unsigned int mask = st->capacity - 1;
+    for (unsigned int i = slot_of(st, name); st->slots[i]; i = (i + 1) & mask) {
+        if (st->slots[i]->id == name) return st->slots[i];
     }
     return NULL;
 }
 
+// dobra a tabela e reinsere os símbolos. a tabela antiga fica na arena.
+static void grow(SymbolTable* st) {
+    st->capacity *= 2;
+    st->shift--;
+    st->slots = (SymbolNode**)arena_calloc(st->arena, st->capacity * sizeof(SymbolNode*));
+    unsigned int mask = st->capacity - 1;
+    for (SymbolNode* sym = st->first; sym; sym = sym->next) {
+        unsigned int i = slot_of(st, sym->id);
+        while (st->slots[i]) i = (i + 1) & mask;
+        st->slots[i] = sym;
+    }
+}
+
 // insere uma nova variável ou função na tabela de símbolos
-void scope_insert(SymbolTable* st, const char* name, SymbolKind kind, SymbolDataType type, int line, int address) {
+SymbolNode* scope_insert(SymbolTable* st, NameId name, SymbolKind kind, SymbolDataType type, int line, int address) {
     // checa se já existe uma variável com esse nome
     if (scope_lookup_current(st, name) != NULL) {
-        fprintf(stderr, "Erro Semântico na linha %d: Identificador '%s' já foi declarado neste escopo.\n", line, name);
-        exit(EXIT_FAILURE);
+        compile_error("Erro Semântico na linha %d: Identificador '%s' já foi declarado neste escopo.", line, intern_name(name));
     }
 
-    unsigned int index = hash(name);
-    SymbolNode* new_node = (SymbolNode*)malloc(sizeof(SymbolNode));
-    if (!new_node) {
-        perror("Falha ao alocar memória para o nó do símbolo");
-        exit(EXIT_FAILURE);
-    }
+    // mantém a tabela no máximo metade cheia
+    if (2 * (st->count + 1) > st->capacity) grow(st);
 
-    new_node->name = strdup(name);
+    SymbolNode* new_node = (SymbolNode*)arena_alloc(st->arena, sizeof(SymbolNode));
+    new_node->id = name;
+    new_node->name = intern_name(name);
     new_node->kind = kind;
     new_node->type = type;
     new_node->line = line;
     new_node->address = address;
-    
-    new_node->next = st->table[index];
-    st->table[index] = new_node;
+    new_node->order = 0;
+    new_node->next = NULL;
+
+    unsigned int mask = st->capacity - 1;
+    unsigned int i = slot_of(st, name);
+    while (st->slots[i]) i = (i + 1) & mask;
+    st->slots[i] = new_node;
+    st->count++;
+
+    if (st->last) st->last->next = new_node;
+    else st->first = new_node;
+    st->last = new_node;
+    return new_node;
 }
 
 // procura por um símbolo começando pelo escopo atual e vai subindo para os escopos pai se não achar
-SymbolNode* scope_lookup(SymbolTable* st, const char* name) {
+SymbolNode* scope_lookup(SymbolTable* st, NameId name) {
     SymbolTable* current_scope = st;
     while (current_scope != NULL) {
         SymbolNode* symbol = scope_lookup_current(current_scope, name);
@@ -104,22 +103,27 @@ SymbolNode* scope_lookup(SymbolTable* st, const char* name) {
     return NULL;
 }
 
-// despejar o conteúdo da tabela de símbolos na tela
+// maior endereço de variável ou parâmetro do escopo, mais um
+int scope_frame_size(SymbolTable* st) {
+    int size = 0;
+    for (SymbolNode* sym = st->first; sym; sym = sym->next) {
+        if ((sym->kind == KIND_VARIABLE || sym->kind == KIND_PARAMETER) && sym->address + 1 > size) {
+            size = sym->address + 1;
+        }
+    }
+    return size;
+}
+
+// despejar o conteúdo da tabela de símbolos na tela, na ordem de declaração
 void scope_dump(SymbolTable* st) {
     printf("--- Despejo da Tabela de Símbolos ---\n");
     int scope_level = 0;
     SymbolTable* current_scope = st;
     while(current_scope) {
         printf("--- Nível de Escopo %d ---\n", scope_level++);
-        for (int i = 0; i < SYMBOL_TABLE_SIZE; i++) {
-            SymbolNode* current = current_scope->table[i];
-            if (current) {
-                while (current) {
-                    printf("  -> Nome: %-15s, Tipo: %d, Categoria: %d, Endereço: %d\n",
-                           current->name, current->type, current->kind, current->address);
-                    current = current->next;
-                }
-            }
+        for (SymbolNode* current = current_scope->first; current; current = current->next) {
+            printf("  -> Nome: %-15s, Tipo: %d, Categoria: %d, Endereço: %d\n",
+                   current->name, current->type, current->kind, current->address);
         }
         current_scope = current_scope->parent;
     }
@@ -0,0 +1,258 @@
+#include "threadpool.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define DEQUE_INITIAL_CAPACITY 64
+
+typedef struct {
+    TaskFunction function;
+    void* arg;
+    TaskGroup* group;
+} Task;
+
+// fila de uma thread: a dona põe e tira do fim (a tarefa mais recente, que
+// ainda está no cache), as outras roubam do começo (as mais antigas, que
+// costumam ser as maiores)
+typedef struct {
+    pthread_mutex_t lock;
+    Task* tasks;        // vetor circular
+    int head;
+    int count;
+    int capacity;
+    struct ThreadPool* pool;
+    int index;
+} TaskDeque;
+
+struct ThreadPool {
+    pthread_mutex_t lock;           // só para dormir e acordar
+    pthread_cond_t changed;         // chegou tarefa, um grupo terminou ou o pool vai fechar
+
+    // uma fila por thread auxiliar e, por último, a das threads de fora do pool
+    TaskDeque* deques;
+    int deque_count;
+    int queued;                     // tarefas em todas as filas (atômico)
+    int sleeping;                   // threads esperando em changed
+
+    pthread_t* workers;
+    int worker_count;
+    int shutting_down;
+};
+
+// fila da thread atual, se ela for auxiliar de algum pool
+static __thread TaskDeque* own_deque = NULL;
+
+static ThreadPool* shared_pool = NULL;
+static int shared_size = 0;
+static pthread_once_t shared_once = PTHREAD_ONCE_INIT;
+
+static void pool_error(const char* message) {
+    fprintf(stderr, "Erro: %s.\n", message);
+    exit(EXIT_FAILURE);
+}
+
+int cpu_count(void) {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+}
+
+static void deque_init(TaskDeque* deque, ThreadPool* pool, int index) {
+    pthread_mutex_init(&deque->lock, NULL);
+    deque->capacity = DEQUE_INITIAL_CAPACITY;
+    deque->tasks = (Task*)malloc(deque->capacity * sizeof(Task));
+    if (!deque->tasks) pool_error("memória insuficiente para o pool de threads");
+    deque->head = 0;
+    deque->count = 0;
+    deque->pool = pool;
+    deque->index = index;
+}
+
+static void deque_push(TaskDeque* deque, Task task) {
+    pthread_mutex_lock(&deque->lock);
+    if (deque->count == deque->capacity) {
+        // desenrola o vetor circular num vetor maior
+        Task* tasks = (Task*)malloc(2 * deque->capacity * sizeof(Task));
+        if (!tasks) pool_error("memória insuficiente para o pool de threads");
+        for (int i = 0; i < deque->count; i++) tasks[i] = deque->tasks[(deque->head + i) % deque->capacity];
+        free(deque->tasks);
+        deque->tasks = tasks;
+        deque->head = 0;
+        deque->capacity *= 2;
+    }
+    deque->tasks[(deque->head + deque->count) % deque->capacity] = task;
+    deque->count++;
+    pthread_mutex_unlock(&deque->lock);
+}
+
+// tira do fim (usado pela dona da fila)
+static int deque_pop(TaskDeque* deque, Task* task) {
+    pthread_mutex_lock(&deque->lock);
+    int found = deque->count > 0;
+    if (found) {
+        deque->count--;
+        *task = deque->tasks[(deque->head + deque->count) % deque->capacity];
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+// tira do começo (usado pelas outras threads)
+static int deque_steal(TaskDeque* deque, Task* task) {
+    pthread_mutex_lock(&deque->lock);
+    int found = deque->count > 0;
+    if (found) {
+        *task = deque->tasks[deque->head];
+        deque->head = (deque->head + 1) % deque->capacity;
+        deque->count--;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+// fila onde a thread atual põe as tarefas que cria
+static TaskDeque* submit_deque(ThreadPool* pool) {
+    if (own_deque && own_deque->pool == pool) return own_deque;
+    return &pool->deques[pool->worker_count];
+}
+
+// procura uma tarefa: primeiro na própria fila, depois roubando das
+// outras, a partir da vizinha. quem é de fora começa pela fila de fora.
+static int find_task(ThreadPool* pool, Task* task) {
+    if (__atomic_load_n(&pool->queued, __ATOMIC_ACQUIRE) == 0) return 0;
+    int self = pool->worker_count;
+    if (own_deque && own_deque->pool == pool) {
+        self = own_deque->index;
+        if (deque_pop(own_deque, task)) goto found;
+    }
+    for (int k = 0; k < pool->deque_count; k++) {
+        int victim = (self + k) % pool->deque_count;
+        if (victim == self && self < pool->worker_count) continue;
+        if (deque_steal(&pool->deques[victim], task)) goto found;
+    }
+    return 0;
+found:
+    __atomic_sub_fetch(&pool->queued, 1, __ATOMIC_ACQ_REL);
+    return 1;
+}
+
+// executa a tarefa e avisa quem espera o grupo
+static void run_task(ThreadPool* pool, Task task) {
+    task.function(task.arg);
+    if (__atomic_sub_fetch(&task.group->pending, 1, __ATOMIC_ACQ_REL) == 0) {
+        pthread_mutex_lock(&pool->lock);
+        pthread_cond_broadcast(&pool->changed);
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+static void* worker_main(void* arg) {
+    own_deque = (TaskDeque*)arg;
+    ThreadPool* pool = own_deque->pool;
+    for (;;) {
+        Task task;
+        if (find_task(pool, &task)) {
+            run_task(pool, task);
+            continue;
+        }
+        pthread_mutex_lock(&pool->lock);
+        while (__atomic_load_n(&pool->queued, __ATOMIC_ACQUIRE) == 0 && !pool->shutting_down) {
+            pool->sleeping++;
+            pthread_cond_wait(&pool->changed, &pool->lock);
+            pool->sleeping--;
+        }
+        int done = pool->shutting_down && __atomic_load_n(&pool->queued, __ATOMIC_ACQUIRE) == 0;
+        pthread_mutex_unlock(&pool->lock);
+        if (done) break;
+    }
+    return NULL;
+}
+
+ThreadPool* thread_pool_create(int threads) {
+    if (threads <= 0) threads = cpu_count();
+    ThreadPool* pool = (ThreadPool*)calloc(1, sizeof(ThreadPool));
+    if (!pool) pool_error("memória insuficiente para o pool de threads");
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->changed, NULL);
+
+    // quem chama thread_pool_wait conta como uma das threads
+    pool->worker_count = threads - 1;
+    pool->deque_count = pool->worker_count + 1;
+    pool->deques = (TaskDeque*)malloc(pool->deque_count * sizeof(TaskDeque));
+    pool->workers = (pthread_t*)malloc((pool->worker_count ? pool->worker_count : 1) * sizeof(pthread_t));
+    if (!pool->deques || !pool->workers) pool_error("memória insuficiente para o pool de threads");
+    for (int i = 0; i < pool->deque_count; i++) deque_init(&pool->deques[i], pool, i);
+    for (int i = 0; i < pool->worker_count; i++) {
+        if (pthread_create(&pool->workers[i], NULL, worker_main, &pool->deques[i]) != 0) {
+            pool_error("não foi possível criar as threads do pool");
+        }
+    }
+    return pool;
+}
+
+// o pool compartilhado vive até o fim do processo. ele não é destruído no
+// atexit porque um exit() chamado de dentro de uma tarefa faria a thread
+// esperar por ela mesma.
+static void create_shared(void) {
+    shared_pool = thread_pool_create(shared_size);
+}
+
+ThreadPool* thread_pool_shared(void) {
+    pthread_once(&shared_once, create_shared);
+    return shared_pool;
+}
+
+void thread_pool_set_shared_size(int threads) {
+    shared_size = threads;
+}
+
+int thread_pool_size(ThreadPool* pool) {
+    return pool->worker_count + 1;
+}
+
+void thread_pool_submit(ThreadPool* pool, TaskGroup* group, TaskFunction function, void* arg) {
+    Task task = { function, arg, group };
+    __atomic_add_fetch(&group->pending, 1, __ATOMIC_ACQ_REL);
+    deque_push(submit_deque(pool), task);
+    __atomic_add_fetch(&pool->queued, 1, __ATOMIC_ACQ_REL);
+    // quem dorme confere queued com o lock, então o aviso não se perde
+    pthread_mutex_lock(&pool->lock);
+    if (pool->sleeping) pthread_cond_signal(&pool->changed);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void thread_pool_wait(ThreadPool* pool, TaskGroup* group) {
+    while (__atomic_load_n(&group->pending, __ATOMIC_ACQUIRE) > 0) {
+        Task task;
+        if (find_task(pool, &task)) {
+            run_task(pool, task);
+            continue;
+        }
+        pthread_mutex_lock(&pool->lock);
+        while (__atomic_load_n(&group->pending, __ATOMIC_ACQUIRE) > 0 &&
+               __atomic_load_n(&pool->queued, __ATOMIC_ACQUIRE) == 0) {
+            pool->sleeping++;
+            pthread_cond_wait(&pool->changed, &pool->lock);
+            pool->sleeping--;
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+void thread_pool_destroy(ThreadPool* pool) {
+    if (!pool) return;
+    pthread_mutex_lock(&pool->lock);
+    pool->shutting_down = 1;
+    pthread_cond_broadcast(&pool->changed);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 0; i < pool->worker_count; i++) pthread_join(pool->workers[i], NULL);
+    for (int i = 0; i < pool->deque_count; i++) {
+        pthread_mutex_destroy(&pool->deques[i].lock);
+        free(pool->deques[i].tasks);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->changed);
+    free(pool->deques);
+    free(pool->workers);
+    free(pool);
+}
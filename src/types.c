@@ -0,0 +1,38 @@
+#include "types.h"
+#include "diagnostic.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+int is_comparison(NodeType type) {
+    return type == NODE_EQ || type == NODE_NEQ || type == NODE_LT ||
+           type == NODE_LTE || type == NODE_GT || type == NODE_GTE;
+}
+
+SymbolDataType operand_type(const Ast* ast, AstId op) {
+    AstId left = ast_child(ast, op);
+    if (expr_type(ast, left) == TYPE_FLOAT || expr_type(ast, ast_sibling(ast, left)) == TYPE_FLOAT) {
+        return TYPE_FLOAT;
+    }
+    return TYPE_INTEGER;
+}
+
+static SymbolDataType compute_type(const Ast* ast, AstId expr) {
+    switch (ast_type(ast, expr)) {
+        case NODE_INT_LITERAL: return TYPE_INTEGER;
+        case NODE_FLOAT_LITERAL: return TYPE_FLOAT;
+        case NODE_IDENTIFIER:
+        case NODE_FUNC_CALL: return ast_symbol(ast, expr)->type;
+        case NODE_NEGATE: return expr_type(ast, ast_child(ast, expr));
+        case NODE_ADD: case NODE_SUB: case NODE_MUL: case NODE_DIV:
+            return operand_type(ast, expr);
+        default:
+            if (is_comparison(ast_type(ast, expr))) return TYPE_INTEGER;
+            compile_error("Erro Semântico: Nó do tipo %d não é uma expressão.", ast_type(ast, expr));
+    }
+}
+
+SymbolDataType expr_type(const Ast* ast, AstId expr) {
+    // sem o valor guardado, cada consulta percorreria a subárvore inteira
+    if (ast->data_type[expr] == AST_TYPE_UNKNOWN) ast->data_type[expr] = (uint8_t)compute_type(ast, expr);
+    return (SymbolDataType)ast->data_type[expr];
+}
@@ -0,0 +1,194 @@
+#include "vm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_STACK_SIZE 1024
+#define INITIAL_FRAME_CAPACITY 64
+#define MAX_CALL_DEPTH (1 << 20)
+
+// no GCC e no Clang o despacho usa "computed goto": cada instrução salta
+// direto para a próxima, sem voltar para o topo de um switch
+#if defined(__GNUC__) && !defined(VM_NO_COMPUTED_GOTO)
+#define VM_COMPUTED_GOTO 1
+#endif
+
+// quadro de uma chamada em andamento
+typedef struct {
+    const BytecodeFunction* fn;
+    const Instruction* ip;  // instrução de retorno
+    size_t base;            // início dos registradores no vetor da pilha
+    int ret_reg;            // registrador do chamador que recebe o resultado
+} CallFrame;
+
+static void runtime_error(const char* message) {
+    fflush(stdout);
+    fprintf(stderr, "Erro de Execução: %s.\n", message);
+    exit(EXIT_FAILURE);
+}
+
+// prepara os registradores de uma função: zera as variáveis e copia as constantes
+static void setup_frame(const BytecodeFunction* fn, Value* regs) {
+    memset(regs, 0, fn->local_count * sizeof(Value));
+    if (fn->constant_count) {
+        memcpy(regs + fn->local_count, fn->constants, fn->constant_count * sizeof(Value));
+    }
+}
+
+int vm_run(const BytecodeProgram* program) {
+    size_t stack_size = INITIAL_STACK_SIZE;
+    while (stack_size < (size_t)program->functions[program->entry].register_count) stack_size *= 2;
+    Value* stack = (Value*)malloc(stack_size * sizeof(Value));
+    int frame_capacity = INITIAL_FRAME_CAPACITY;
+    int frame_count = 0;
+    CallFrame* frames = (CallFrame*)malloc(frame_capacity * sizeof(CallFrame));
+    if (!stack || !frames) runtime_error("memória insuficiente");
+
+    const BytecodeFunction* fn = &program->functions[program->entry];
+    size_t base = 0;
+    Value* regs = stack;
+    const Instruction* ip = fn->code;
+    const Instruction* in;
+    int result;
+    setup_frame(fn, regs);
+
+#define R(x) regs[x]
+
+#ifdef VM_COMPUTED_GOTO
+    static const void* labels[] = {
+#define VM_LABEL(name) &&op_##name,
+        BYTECODE_OPS(VM_LABEL)
+#undef VM_LABEL
+    };
+#define CASE(name) op_##name:
+#define NEXT() do { in = ip++; goto *labels[in->op]; } while (0)
+    NEXT();
+#else
+#define CASE(name) case OP_##name:
+#define NEXT() continue
+    for (;;) {
+        in = ip++;
+        switch (in->op) {
+#endif
+
+    CASE(MOVE)  R(in->a) = R(in->b); NEXT();
+    CASE(I2F)   R(in->a).f = (double)R(in->b).i; NEXT();
+    CASE(F2I)   R(in->a).i = (long long)R(in->b).f; NEXT();
+
+    CASE(ADDI)  R(in->a).i = R(in->b).i + R(in->c).i; NEXT();
+    CASE(SUBI)  R(in->a).i = R(in->b).i - R(in->c).i; NEXT();
+    CASE(MULI)  R(in->a).i = R(in->b).i * R(in->c).i; NEXT();
+    CASE(DIVI)
+        if (R(in->c).i == 0) runtime_error("divisão por zero");
+        R(in->a).i = R(in->c).i == -1 ? -R(in->b).i : R(in->b).i / R(in->c).i;
+        NEXT();
+    CASE(ADDF)  R(in->a).f = R(in->b).f + R(in->c).f; NEXT();
+    CASE(SUBF)  R(in->a).f = R(in->b).f - R(in->c).f; NEXT();
+    CASE(MULF)  R(in->a).f = R(in->b).f * R(in->c).f; NEXT();
+    CASE(DIVF)  R(in->a).f = R(in->b).f / R(in->c).f; NEXT();
+    CASE(NEGI)  R(in->a).i = -R(in->b).i; NEXT();
+    CASE(NEGF)  R(in->a).f = -R(in->b).f; NEXT();
+
+    CASE(EQI)   R(in->a).i = R(in->b).i == R(in->c).i; NEXT();
+    CASE(NEI)   R(in->a).i = R(in->b).i != R(in->c).i; NEXT();
+    CASE(LTI)   R(in->a).i = R(in->b).i < R(in->c).i; NEXT();
+    CASE(LEI)   R(in->a).i = R(in->b).i <= R(in->c).i; NEXT();
+    CASE(EQF)   R(in->a).i = R(in->b).f == R(in->c).f; NEXT();
+    CASE(NEF)   R(in->a).i = R(in->b).f != R(in->c).f; NEXT();
+    CASE(LTF)   R(in->a).i = R(in->b).f < R(in->c).f; NEXT();
+    CASE(LEF)   R(in->a).i = R(in->b).f <= R(in->c).f; NEXT();
+
+    CASE(JMP)   ip = fn->code + in->c; NEXT();
+    CASE(JMPF)  if (R(in->a).i == 0) ip = fn->code + in->c; NEXT();
+    CASE(JMPT)  if (R(in->a).i != 0) ip = fn->code + in->c; NEXT();
+    CASE(JMPFF) if (R(in->a).f == 0) ip = fn->code + in->c; NEXT();
+    CASE(JMPTF) if (R(in->a).f != 0) ip = fn->code + in->c; NEXT();
+    CASE(JEQI)  if (R(in->a).i == R(in->b).i) ip = fn->code + in->c; NEXT();
+    CASE(JNEI)  if (R(in->a).i != R(in->b).i) ip = fn->code + in->c; NEXT();
+    CASE(JLTI)  if (R(in->a).i < R(in->b).i) ip = fn->code + in->c; NEXT();
+    CASE(JLEI)  if (R(in->a).i <= R(in->b).i) ip = fn->code + in->c; NEXT();
+    CASE(JEQF)  if (R(in->a).f == R(in->b).f) ip = fn->code + in->c; NEXT();
+    CASE(JNEF)  if (R(in->a).f != R(in->b).f) ip = fn->code + in->c; NEXT();
+    CASE(JLTF)  if (R(in->a).f < R(in->b).f) ip = fn->code + in->c; NEXT();
+    CASE(JLEF)  if (R(in->a).f <= R(in->b).f) ip = fn->code + in->c; NEXT();
+    CASE(JNLTF) if (!(R(in->a).f < R(in->b).f)) ip = fn->code + in->c; NEXT();
+    CASE(JNLEF) if (!(R(in->a).f <= R(in->b).f)) ip = fn->code + in->c; NEXT();
+
+    CASE(CALL) {
+        const BytecodeFunction* callee = &program->functions[in->b];
+        size_t new_base = base + fn->register_count;
+
+        // garante espaço para os registradores da função chamada
+        if (new_base + callee->register_count > stack_size) {
+            while (new_base + callee->register_count > stack_size) stack_size *= 2;
+            stack = (Value*)realloc(stack, stack_size * sizeof(Value));
+            if (!stack) runtime_error("memória insuficiente");
+            regs = stack + base;
+        }
+        if (frame_count >= frame_capacity) {
+            if (frame_capacity >= MAX_CALL_DEPTH) runtime_error("estouro da pilha de chamadas");
+            frame_capacity *= 2;
+            frames = (CallFrame*)realloc(frames, frame_capacity * sizeof(CallFrame));
+            if (!frames) runtime_error("memória insuficiente");
+        }
+        frames[frame_count++] = (CallFrame){ fn, ip, base, in->a };
+
+        // os parâmetros ocupam os registradores 1..param_count
+        Value* callee_regs = stack + new_base;
+        setup_frame(callee, callee_regs);
+        for (int i = 0; i < callee->param_count; i++) {
+            callee_regs[i + 1] = R(in->c + i);
+        }
+
+        fn = callee;
+        base = new_base;
+        regs = callee_regs;
+        ip = fn->code;
+        NEXT();
+    }
+
+    CASE(RET)
+    CASE(RETZ) {
+        Value v;
+        if (in->op == OP_RET) v = R(in->a);
+        else v.i = 0;
+        if (frame_count == 0) {
+            result = fn->return_type == TYPE_FLOAT ? (int)v.f : (int)v.i;
+            goto done;
+        }
+        CallFrame* frame = &frames[--frame_count];
+        fn = frame->fn;
+        ip = frame->ip;
+        base = frame->base;
+        regs = stack + base;
+        R(frame->ret_reg) = v;
+        NEXT();
+    }
+
+    CASE(PRINTI) printf("%lld%c", R(in->a).i, in->b ? '\n' : ' '); NEXT();
+    CASE(PRINTF) printf("%g%c", R(in->a).f, in->b ? '\n' : ' '); NEXT();
+    CASE(PRINTNL) putchar('\n'); NEXT();
+    CASE(SCANI)
+        if (scanf("%lld", &R(in->a).i) != 1) runtime_error("entrada inválida para scan");
+        NEXT();
+    CASE(SCANF)
+        if (scanf("%lf", &R(in->a).f) != 1) runtime_error("entrada inválida para scan");
+        NEXT();
+
+#ifndef VM_COMPUTED_GOTO
+        default:
+            runtime_error("instrução inválida");
+        }
+    }
+#endif
+
+#undef CASE
+#undef NEXT
+#undef R
+
+done:
+    fflush(stdout);
+    free(stack);
+    free(frames);
+    return result;
+}